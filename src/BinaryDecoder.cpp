@@ -0,0 +1,1129 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "BinaryDecoder.hpp"
+#include "BinarySink.hpp"
+#include "CharacterScan.hpp"
+#include "TextSink.hpp"
+#include "TextStream.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <new>
+
+
+using namespace std;
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+// ----=====================================================================----
+//     DecoderCursor
+// ----=====================================================================----
+
+//! A cursor over the encoded items of a record.
+struct DecoderCursor
+{
+    //! The maximum nesting depth of the items. Structs, format tuples and
+    //! fields are decoded recursively, so deeper nesting is rejected.
+    static constexpr unsigned maxDepth = 64;
+
+    //! Tracks the nesting depth while an item is decoded.
+    class NestingGuard
+    {
+    public:
+        explicit
+        NestingGuard(DecoderCursor& cursor) noexcept
+            : m_cursor(cursor),
+              m_isValid(cursor.depth < maxDepth)
+        {
+            if (m_isValid)
+                ++m_cursor.depth;
+            else
+                m_cursor.fail();
+        }
+
+        ~NestingGuard()
+        {
+            if (m_isValid)
+                --m_cursor.depth;
+        }
+
+        NestingGuard(const NestingGuard&) = delete;
+        NestingGuard& operator=(const NestingGuard&) = delete;
+
+        //! Returns \p false if the nesting is too deep.
+        explicit
+        operator bool() const noexcept
+        {
+            return m_isValid;
+        }
+
+    private:
+        DecoderCursor& m_cursor;
+        bool m_isValid;
+    };
+
+    DecoderCursor(const uint8_t* begin, const uint8_t* end,
+                  vector<StringRef>& dictionary) noexcept
+        : iter(begin),
+          end(end),
+          dictionary(dictionary),
+          depth(0),
+          isValid(true)
+    {
+    }
+
+    //! Returns true if the next item is a break.
+    bool atBreak() const noexcept
+    {
+        return iter < end && *iter == 0xE0 + 31;
+    }
+
+    bool fail() noexcept
+    {
+        isValid = false;
+        return false;
+    }
+
+    bool readByte(uint8_t& value) noexcept
+    {
+        if (iter == end)
+            return fail();
+        value = *iter++;
+        return true;
+    }
+
+    bool readBytes(size_t size, const uint8_t*& data) noexcept
+    {
+        if (size_t(end - iter) < size)
+            return fail();
+        data = iter;
+        iter += size;
+        return true;
+    }
+
+    //! Reads the value of an integer whose tag had the lower bits
+    //! \p immediate.
+    bool readInteger(uint8_t immediate, uint64_t& value) noexcept
+    {
+        if (immediate < 24)
+        {
+            value = immediate;
+            return true;
+        }
+
+        const uint8_t* data;
+        unsigned size = immediate - 23;
+        if (!readBytes(size, data))
+            return false;
+        value = 0;
+        for (unsigned idx = 0; idx < size; ++idx)
+            value |= uint64_t(data[idx]) << (8 * idx);
+        return true;
+    }
+
+    //! Reads a positive integer item.
+    bool readUnsigned(uint64_t& value) noexcept
+    {
+        uint8_t tag;
+        if (!readByte(tag) || (tag & 0xE0) != 0x00)
+            return fail();
+        return readInteger(tag & 0x1F, value);
+    }
+
+    //! Reads a little-endian value of \p size bytes.
+    bool readFixed(unsigned size, uint64_t& value) noexcept
+    {
+        return readInteger(23 + size, value);
+    }
+
+    //! Reads a string item. A definition for the string dictionary is
+    //! registered.
+    bool readString(StringRef& str) noexcept
+    {
+        uint8_t tag;
+        return readByte(tag) && readString(tag, str);
+    }
+
+    //! Reads a string item whose tag has been read already.
+    bool readString(uint8_t tag, StringRef& str) noexcept
+    {
+        if ((tag & 0xE0) == 0x40)
+        {
+            uint64_t length = tag & 0x1F;
+            if (length == 30 && !readFixed(1, length))
+                return false;
+            if (length == 31 && !readFixed(2, length))
+                return false;
+            const uint8_t* data;
+            if (!readBytes(length, data))
+                return false;
+            str = StringRef{reinterpret_cast<const char*>(data), length};
+            return true;
+        }
+        else if (tag == 0xA0 + 0)
+        {
+            uint64_t id;
+            if (!readUnsigned(id) || !readString(str))
+                return false;
+            if (id < dictionary.size())
+                dictionary[id] = str;
+            else if (id == dictionary.size())
+                dictionary.push_back(str);
+            else
+                return fail();
+            return true;
+        }
+        else if (tag == 0xA0 + 1)
+        {
+            uint64_t id;
+            if (!readUnsigned(id) || id >= dictionary.size())
+                return fail();
+            str = dictionary[id];
+            return true;
+        }
+        else if (tag >= 0xE0 + 20 && tag <= 0xE0 + 22)
+        {
+            // The string cannot be resolved without the program image.
+            static const unsigned sizes[] = {3, 4, 8};
+            uint64_t offset;
+            if (!readFixed(sizes[tag - (0xE0 + 20)], offset))
+                return false;
+            static const char digits[] = "0123456789abcdef";
+            char* last = placeholder + sizeof(placeholder);
+            char* first = last;
+            *--first = '>';
+            do
+            {
+                *--first = digits[offset & 0xF];
+                offset >>= 4;
+            } while (offset);
+            first -= 10;
+            memcpy(first, "<string@0x", 10);
+            str = StringRef{first, size_t(last - first)};
+            return true;
+        }
+        return fail();
+    }
+
+    //! Reads the elements of an array of the given \p type.
+    bool readArray(unsigned type, uint64_t& count, const uint8_t*& data) noexcept
+    {
+        unsigned size = elementSize(type);
+        if (!size || !readUnsigned(count) || count > size_t(end - iter) / size)
+            return fail();
+        return readBytes(count * size, data);
+    }
+
+    //! Skips the next item.
+    bool skipItem() noexcept
+    {
+        NestingGuard guard(*this);
+        uint8_t tag;
+        if (!guard || !readByte(tag))
+            return false;
+
+        uint8_t immediate = tag & 0x1F;
+        uint64_t value;
+        switch (tag & 0xE0)
+        {
+        case 0x00:
+        case 0x20:
+            return readInteger(immediate, value);
+
+        case 0x40:
+        case 0xA0:
+        {
+            StringRef str;
+            return readString(tag, str);
+        }
+
+        case 0x60:
+            if (immediate < 4)
+                return readFixed(immediate + 1, value) && skipUntilBreak();
+            if (immediate < 8)
+                return readFixed(immediate - 3, value) && skipItem();
+            if (immediate == 16)
+                return skipUntilBreak();
+            if (immediate == 17)
+                return skipItem() && skipItem();
+            return fail();
+
+        case 0x80:
+        {
+            const uint8_t* data;
+            return readArray(immediate, value, data);
+        }
+
+        case 0xE0:
+        {
+            const uint8_t* data;
+            switch (immediate)
+            {
+            case 0: case 1: case 2:
+                return true;
+            case 8:  return readBytes(sizeof(float), data);
+            case 9:  return readBytes(sizeof(double), data);
+            case 10: return readBytes(sizeof(long double), data);
+            case 16: return readBytes(3, data);
+            case 17: return readBytes(4, data);
+            case 18: return readBytes(8, data);
+            case 20: case 21: case 22:
+            {
+                StringRef str;
+                return readString(tag, str);
+            }
+            }
+            return fail();
+        }
+        }
+        return fail();
+    }
+
+    //! Skips all items up to and including the next break.
+    bool skipUntilBreak() noexcept
+    {
+        while (!atBreak())
+        {
+            if (!skipItem())
+                return false;
+        }
+        ++iter;
+        return true;
+    }
+
+    //! Returns the size of an array element of the given \p type or zero
+    //! for an invalid type.
+    static
+    unsigned elementSize(unsigned type) noexcept
+    {
+        static const unsigned char sizes[] = {
+            1, 1, 2, 2, 4, 4, 8, 8,
+            sizeof(float), sizeof(double), sizeof(long double)
+        };
+        return type < sizeof(sizes) ? sizes[type] : 0;
+    }
+
+    const uint8_t* iter;
+    const uint8_t* end;
+    vector<StringRef>& dictionary;
+    //! The nesting depth of the current item.
+    unsigned depth;
+    bool isValid;
+    //! A buffer for the text of unresolvable strings.
+    char placeholder[32];
+};
+
+// ----=====================================================================----
+//     DecoderPrinter
+// ----=====================================================================----
+
+//! Prints decoded items to a TextStream.
+class DecoderPrinter
+{
+public:
+    static
+    bool printItem(TextStream& out, DecoderCursor& cursor);
+
+private:
+    static
+    bool printFormatTuple(TextStream& out, DecoderCursor& cursor);
+
+    static
+    bool printField(TextStream& out, DecoderCursor& cursor);
+
+    static
+    bool printArray(TextStream& out, DecoderCursor& cursor, unsigned type);
+
+    template <typename T>
+    static
+    void printElements(TextStream& out, const uint8_t* data, size_t count);
+
+    static
+    bool printUserType(TextStream& out, DecoderCursor& cursor,
+                       uint8_t immediate);
+
+    static
+    void printString(TextStream& out, const StringRef& str)
+    {
+        out << SplitStringView{str.data, str.size, nullptr, 0};
+    }
+};
+
+template <>
+struct ArgumentForwarder<DecoderCursor>
+{
+    explicit
+    ArgumentForwarder(TextStream& outStream, DecoderCursor& cursor)
+        : m_cursor(cursor),
+          m_outStream(outStream)
+    {
+    }
+
+    void printNext()
+    {
+        if (m_cursor.isValid && m_cursor.iter < m_cursor.end
+            && !m_cursor.atBreak())
+        {
+            DecoderPrinter::printItem(m_outStream, m_cursor);
+        }
+    }
+
+    void printRest()
+    {
+        while (m_cursor.isValid && m_cursor.iter < m_cursor.end
+               && !m_cursor.atBreak())
+        {
+            // Structured fields are not enclosed in angle brackets.
+            if (*m_cursor.iter == 0x60 + 17)
+            {
+                DecoderPrinter::printItem(m_outStream, m_cursor);
+                continue;
+            }
+
+            m_outStream << ' ' << '<';
+            DecoderPrinter::printItem(m_outStream, m_cursor);
+            m_outStream << '>';
+        }
+    }
+
+private:
+    DecoderCursor& m_cursor;
+    TextStream& m_outStream;
+};
+
+bool DecoderPrinter::printItem(TextStream& out, DecoderCursor& cursor)
+{
+    DecoderCursor::NestingGuard guard(cursor);
+    uint8_t tag;
+    if (!guard || !cursor.readByte(tag))
+        return false;
+
+    uint8_t immediate = tag & 0x1F;
+    uint64_t value;
+    switch (tag & 0xE0)
+    {
+    case 0x00:
+        if (!cursor.readInteger(immediate, value))
+            return false;
+        out << static_cast<unsigned long long>(value);
+        return true;
+
+    case 0x20:
+        if (!cursor.readInteger(immediate, value))
+            return false;
+        out << static_cast<long long>(~value);
+        return true;
+
+    case 0x40:
+    case 0xA0:
+    {
+        StringRef str;
+        if (!cursor.readString(tag, str))
+            return false;
+        printString(out, str);
+        return true;
+    }
+
+    case 0x60:
+        if (immediate < 8)
+            return printUserType(out, cursor, immediate);
+        if (immediate == 16)
+            return printFormatTuple(out, cursor);
+        if (immediate == 17)
+            return printField(out, cursor);
+        return cursor.fail();
+
+    case 0x80:
+        return printArray(out, cursor, immediate);
+
+    case 0xE0:
+    {
+        const uint8_t* data;
+        switch (immediate)
+        {
+        case 0:
+        case 1:
+            out << (immediate == 1);
+            return true;
+        case 2:
+            out << static_cast<const void*>(nullptr);
+            return true;
+        case 8:
+        {
+            float temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            out << temp;
+            return true;
+        }
+        case 9:
+        {
+            double temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            out << temp;
+            return true;
+        }
+        case 10:
+        {
+            long double temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            out << temp;
+            return true;
+        }
+        case 16:
+        case 17:
+        case 18:
+        {
+            static const unsigned sizes[] = {3, 4, 8};
+            if (!cursor.readFixed(sizes[immediate - 16], value))
+                return false;
+            out << reinterpret_cast<const void*>(uintptr_t(value));
+            return true;
+        }
+        case 20:
+        case 21:
+        case 22:
+        {
+            StringRef str;
+            if (!cursor.readString(tag, str))
+                return false;
+            printString(out, str);
+            return true;
+        }
+        }
+        return cursor.fail();
+    }
+    }
+    return cursor.fail();
+}
+
+bool DecoderPrinter::printFormatTuple(TextStream& out, DecoderCursor& cursor)
+{
+    StringRef format;
+    if (!cursor.readString(format))
+        return false;
+
+    out.doFormat(SplitStringView{format.data, format.size, nullptr, 0},
+                 ArgumentForwarder<DecoderCursor>(out, cursor));
+    if (!cursor.isValid || !cursor.atBreak())
+        return cursor.fail();
+    ++cursor.iter;
+    return true;
+}
+
+bool DecoderPrinter::printField(TextStream& out, DecoderCursor& cursor)
+{
+    StringRef key;
+    if (!cursor.readString(key))
+        return false;
+
+    out.m_sink->beginField(key.data, key.size, out.m_numFields);
+    ++out.m_numFields;
+    out.m_inField = true;
+    bool result = printItem(out, cursor);
+    out.endField();
+    return result;
+}
+
+bool DecoderPrinter::printArray(TextStream& out, DecoderCursor& cursor,
+                                unsigned type)
+{
+    uint64_t count;
+    const uint8_t* data;
+    if (!cursor.readArray(type, count, data))
+        return false;
+
+    switch (static_cast<ArrayElementType>(type))
+    {
+    case ArrayElementType::Int8:   printElements<int8_t>(out, data, count); break;
+    case ArrayElementType::UInt8:  printElements<uint8_t>(out, data, count); break;
+    case ArrayElementType::Int16:  printElements<int16_t>(out, data, count); break;
+    case ArrayElementType::UInt16: printElements<uint16_t>(out, data, count); break;
+    case ArrayElementType::Int32:  printElements<int32_t>(out, data, count); break;
+    case ArrayElementType::UInt32: printElements<uint32_t>(out, data, count); break;
+    case ArrayElementType::Int64:  printElements<int64_t>(out, data, count); break;
+    case ArrayElementType::UInt64: printElements<uint64_t>(out, data, count); break;
+    case ArrayElementType::Float:  printElements<float>(out, data, count); break;
+    case ArrayElementType::Double: printElements<double>(out, data, count); break;
+    case ArrayElementType::LongDouble:
+        printElements<long double>(out, data, count);
+        break;
+    }
+    return true;
+}
+
+template <typename T>
+void DecoderPrinter::printElements(TextStream& out, const uint8_t* data,
+                                   size_t count)
+{
+    // The format applies to every element (like in the ArraySerdes).
+    auto format = out.m_format;
+    out.m_sink->writeChar('[');
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        T value;
+        memcpy(&value, data + idx * sizeof(T), sizeof(T));
+        if (idx)
+            out.m_sink->writeString(", ", 2);
+        out.m_format = format;
+        out << value;
+    }
+    out.m_sink->writeChar(']');
+    out.reset();
+}
+
+bool DecoderPrinter::printUserType(TextStream& out, DecoderCursor& cursor,
+                                   uint8_t immediate)
+{
+    // Structs are printed as '#tag{a, b}' and enums as '#tag(value)'.
+    uint64_t typeTag;
+    if (!cursor.readFixed((immediate & 3) + 1, typeTag))
+        return false;
+
+    char buffer[12];
+    char* last = buffer + sizeof(buffer);
+    char* first = last;
+    do
+    {
+        *--first = char('0' + typeTag % 10);
+        typeTag /= 10;
+    } while (typeTag);
+    *--first = '#';
+    out.m_sink->writeString(first, last - first);
+
+    if (immediate >= 4)
+    {
+        out.m_sink->writeChar('(');
+        bool result = printItem(out, cursor);
+        out.m_sink->writeChar(')');
+        return result;
+    }
+
+    out.m_sink->writeChar('{');
+    for (bool first = true; !cursor.atBreak(); first = false)
+    {
+        if (!first)
+            out.m_sink->writeString(", ", 2);
+        if (!printItem(out, cursor))
+            return false;
+    }
+    ++cursor.iter;
+    out.m_sink->writeChar('}');
+    return true;
+}
+
+// ----=====================================================================----
+//     DecoderWriter
+// ----=====================================================================----
+
+//! Writes decoded items to a binary sink.
+class DecoderWriter
+{
+public:
+    static
+    bool writeItem(BinarySinkBase& sink, DecoderCursor& cursor);
+
+private:
+    //! Writes the items up to the next break and skips the break.
+    static
+    bool writeUntilBreak(BinarySinkBase& sink, DecoderCursor& cursor);
+
+    static
+    bool writeUserType(BinarySinkBase& sink, DecoderCursor& cursor,
+                       uint8_t immediate);
+};
+
+bool DecoderWriter::writeItem(BinarySinkBase& sink, DecoderCursor& cursor)
+{
+    DecoderCursor::NestingGuard guard(cursor);
+    uint8_t tag;
+    if (!guard || !cursor.readByte(tag))
+        return false;
+
+    uint8_t immediate = tag & 0x1F;
+    uint64_t value;
+    switch (tag & 0xE0)
+    {
+    case 0x00:
+        if (!cursor.readInteger(immediate, value))
+            return false;
+        sink.write(static_cast<unsigned long long>(value));
+        return true;
+
+    case 0x20:
+        if (!cursor.readInteger(immediate, value))
+            return false;
+        sink.write(static_cast<long long>(~value));
+        return true;
+
+    case 0x40:
+    case 0xA0:
+    {
+        StringRef str;
+        if (!cursor.readString(tag, str))
+            return false;
+        sink.write(SplitStringView{str.data, str.size, nullptr, 0});
+        return true;
+    }
+
+    case 0x60:
+        if (immediate < 8)
+            return writeUserType(sink, cursor, immediate);
+        if (immediate == 16)
+        {
+            sink.beginFormatTuple();
+            if (!writeUntilBreak(sink, cursor))
+                return false;
+            sink.endFormatTuple();
+            return true;
+        }
+        if (immediate == 17)
+        {
+            sink.beginField();
+            return writeItem(sink, cursor) && writeItem(sink, cursor);
+        }
+        return cursor.fail();
+
+    case 0x80:
+    {
+        const uint8_t* data;
+        if (!cursor.readArray(immediate, value, data))
+            return false;
+        sink.writeArray(static_cast<ArrayElementType>(immediate), value,
+                        SplitStringView{
+                            reinterpret_cast<const char*>(data),
+                            value * DecoderCursor::elementSize(immediate),
+                            nullptr, 0});
+        return true;
+    }
+
+    case 0xE0:
+    {
+        const uint8_t* data;
+        switch (immediate)
+        {
+        case 0:
+        case 1:
+            sink.write(immediate == 1);
+            return true;
+        case 2:
+            sink.write(static_cast<const void*>(nullptr));
+            return true;
+        case 8:
+        {
+            float temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            sink.write(temp);
+            return true;
+        }
+        case 9:
+        {
+            double temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            sink.write(temp);
+            return true;
+        }
+        case 10:
+        {
+            long double temp;
+            if (!cursor.readBytes(sizeof(temp), data))
+                return false;
+            memcpy(&temp, data, sizeof(temp));
+            sink.write(temp);
+            return true;
+        }
+        case 16:
+        case 17:
+        case 18:
+        {
+            static const unsigned sizes[] = {3, 4, 8};
+            if (!cursor.readFixed(sizes[immediate - 16], value))
+                return false;
+            sink.write(reinterpret_cast<const void*>(uintptr_t(value)));
+            return true;
+        }
+        case 20:
+        case 21:
+        case 22:
+        {
+            // The offset cannot be resolved, so the placeholder is written.
+            StringRef str;
+            if (!cursor.readString(tag, str))
+                return false;
+            sink.write(SplitStringView{str.data, str.size, nullptr, 0});
+            return true;
+        }
+        }
+        return cursor.fail();
+    }
+    }
+    return cursor.fail();
+}
+
+bool DecoderWriter::writeUntilBreak(BinarySinkBase& sink, DecoderCursor& cursor)
+{
+    while (!cursor.atBreak())
+    {
+        if (!writeItem(sink, cursor))
+            return false;
+    }
+    ++cursor.iter;
+    return true;
+}
+
+bool DecoderWriter::writeUserType(BinarySinkBase& sink, DecoderCursor& cursor,
+                                  uint8_t immediate)
+{
+    uint64_t typeTag;
+    if (!cursor.readFixed((immediate & 3) + 1, typeTag))
+        return false;
+
+    if (immediate < 4)
+    {
+        sink.beginStruct(typeTag);
+        if (!writeUntilBreak(sink, cursor))
+            return false;
+        sink.endStruct(typeTag);
+        return true;
+    }
+
+    // The value of an enum is an integer.
+    uint8_t tag;
+    uint64_t value;
+    if (   !cursor.readByte(tag)
+        || ((tag & 0xE0) != 0x00 && (tag & 0xE0) != 0x20)
+        || !cursor.readInteger(tag & 0x1F, value))
+    {
+        return cursor.fail();
+    }
+    sink.writeEnum(typeTag, (tag & 0xE0) == 0x00 ? int64_t(value)
+                                                 : int64_t(~value));
+    return true;
+}
+
+} // namespace log11_detail
+
+
+using namespace log11_detail;
+
+
+// ----=====================================================================----
+//     BinaryDecoder
+// ----=====================================================================----
+
+BinaryDecoder::BinaryDecoder()
+    : m_begin(nullptr),
+      m_iter(nullptr),
+      m_end(nullptr),
+      m_blockSequence(0),
+      m_scratchPad(32),
+      m_headerGenerator(nullptr)
+{
+    m_headerGenerator = RecordHeaderGenerator::parse("[{D}d {H}:{M}:{S}.{us} {L}] ");
+}
+
+BinaryDecoder::~BinaryDecoder()
+{
+    if (m_headerGenerator)
+        delete m_headerGenerator;
+}
+
+void BinaryDecoder::setData(const void* data, std::size_t size) noexcept
+{
+    m_begin = static_cast<const uint8_t*>(data);
+    m_iter = m_begin;
+    m_end = m_begin + size;
+    m_blockSequence = 0;
+    m_dictionary.clear();
+}
+
+BinaryDecoder::Status BinaryDecoder::next(DecodedRecord& record)
+{
+    using namespace std::chrono;
+
+    for (;;)
+    {
+        if (m_iter == m_end)
+            return Status::EndOfData;
+
+        DecoderCursor cursor(m_iter, m_end, m_dictionary);
+        uint8_t tag;
+        if (!cursor.readByte(tag))
+            return Status::Malformed;
+
+        // A block header resets the string dictionary.
+        if (tag == 0x60 + 19)
+        {
+            const uint8_t* marker;
+            uint64_t sequence;
+            if (   !cursor.readBytes(sizeof(BinarySink::blockMarker), marker)
+                || memcmp(marker, BinarySink::blockMarker,
+                          sizeof(BinarySink::blockMarker)) != 0
+                || !cursor.readUnsigned(sequence))
+            {
+                return Status::Malformed;
+            }
+            m_dictionary.clear();
+            m_blockSequence = sequence;
+            m_iter = cursor.iter;
+            if (!cursor.readByte(tag))
+                return Status::Malformed;
+        }
+
+        uint64_t flags;
+        uint64_t time;
+        uint64_t sequence = 0;
+        if (   tag != 0x60 + 18
+            || !cursor.readUnsigned(flags)
+            || !cursor.readUnsigned(time)
+            || ((flags & 0x10) && !cursor.readUnsigned(sequence)))
+        {
+            return Status::Malformed;
+        }
+
+        // The arguments are skipped even if the record does not pass the
+        // filter because they may define strings in the dictionary.
+        record.begin = cursor.iter;
+        while (!cursor.atBreak())
+        {
+            if (!cursor.skipItem())
+                return Status::Malformed;
+        }
+        record.end = cursor.iter;
+        m_iter = cursor.iter + 1;
+
+        auto severity = static_cast<Severity>(flags & 0x07);
+        if (!m_filter.matches(severity, time))
+            continue;
+
+        record.data.severity = severity;
+        record.data.isTruncated = (flags & 0x08) != 0;
+        record.data.sequence = sequence;
+        record.data.time = high_resolution_clock::time_point(
+                duration_cast<high_resolution_clock::duration>(nanoseconds(time)));
+        return Status::Ok;
+    }
+}
+
+std::size_t BinaryDecoder::position() const noexcept
+{
+    return m_iter - m_begin;
+}
+
+void BinaryDecoder::seek(std::size_t offset) noexcept
+{
+    m_iter = m_begin + offset;
+    m_dictionary.clear();
+}
+
+std::size_t BinaryDecoder::findBlock(std::size_t offset) const noexcept
+{
+    const auto markerSize = sizeof(BinarySink::blockMarker);
+    const char* begin = reinterpret_cast<const char*>(m_begin);
+    const char* end = reinterpret_cast<const char*>(m_end);
+    const char* iter = begin + offset;
+    for (;;)
+    {
+        iter = findCharacter(iter, end, char(0x60 + 19));
+        if (size_t(end - iter) <= markerSize)
+            return m_end - m_begin;
+        if (memcmp(iter + 1, BinarySink::blockMarker, markerSize) == 0)
+            return iter - begin;
+        ++iter;
+    }
+}
+
+void BinaryDecoder::setFilter(const RecordFilter& filter) noexcept
+{
+    m_filter = filter;
+}
+
+const RecordFilter& BinaryDecoder::filter() const noexcept
+{
+    return m_filter;
+}
+
+bool BinaryDecoder::isAtBlockHeader() const noexcept
+{
+    return m_iter < m_end && *m_iter == 0x60 + 19;
+}
+
+std::uint64_t BinaryDecoder::blockSequence() const noexcept
+{
+    return m_blockSequence;
+}
+
+void BinaryDecoder::setTextHeader(const char* header)
+{
+    auto* generator = RecordHeaderGenerator::parse(header);
+    if (m_headerGenerator)
+        delete m_headerGenerator;
+    m_headerGenerator = generator;
+}
+
+void BinaryDecoder::format(const DecodedRecord& record, TextSink& sink)
+{
+    LogRecordData data = record.data;
+
+    m_scratchPad.clear();
+    sink.beginLogEntry(data);
+    if (m_headerGenerator)
+    {
+        m_headerGenerator->generate(data, m_scratchPad);
+        sink.writeHeader(m_scratchPad.data(), m_scratchPad.size());
+    }
+    else
+    {
+        sink.writeHeader("", 0);
+    }
+
+    TextStream outStream(sink, m_scratchPad);
+    DecoderCursor cursor(record.begin, record.end, m_dictionary);
+    while (cursor.iter < cursor.end)
+    {
+        if (!DecoderPrinter::printItem(outStream, cursor))
+            break;
+    }
+    outStream.endFields();
+    sink.endLogEntry(data);
+}
+
+namespace log11_detail
+{
+
+// ----=====================================================================----
+//     EncodedArgumentsSerdes
+// ----=====================================================================----
+
+namespace
+{
+
+//! Reads encoded arguments from the \p stream. The decoder needs the items
+//! in contiguous memory, so they are copied to \p copy if they wrap around
+//! the end of the ring buffer.
+bool readEncodedArguments(RingBuffer::Stream& stream,
+                          unique_ptr<uint8_t[]>& copy,
+                          const uint8_t*& begin, const uint8_t*& end) noexcept
+{
+    uint16_t size;
+    SplitStringView view;
+    if (   !stream.read(&size, sizeof(size))
+        || stream.readString(view, size) != size)
+    {
+        return false;
+    }
+
+    begin = reinterpret_cast<const uint8_t*>(view.begin1);
+    if (view.length2)
+    {
+        copy.reset(new (nothrow) uint8_t[size]);
+        if (!copy)
+            return false;
+        memcpy(copy.get(), view.begin1, view.length1);
+        memcpy(copy.get() + view.length1, view.begin2, view.length2);
+        begin = copy.get();
+    }
+    end = begin + size;
+    return true;
+}
+
+} // anonymous namespace
+
+EncodedArgumentsSerdes* EncodedArgumentsSerdes::instance()
+{
+    static EncodedArgumentsSerdes serdes;
+    return &serdes;
+}
+
+bool EncodedArgumentsSerdes::serialize(RingBuffer::Stream& stream,
+                                       const uint8_t* begin,
+                                       const uint8_t* end) noexcept
+{
+    SerdesBase* serdes = instance();
+    uint16_t size = end - begin;
+    return stream.write(&serdes, sizeof(void*))
+           && stream.write(&size, sizeof(size))
+           && stream.write(begin, size);
+}
+
+bool EncodedArgumentsSerdes::deserialize(
+        RingBuffer::Stream& inStream, BinaryStream& outStream) const noexcept
+{
+    unique_ptr<uint8_t[]> copy;
+    const uint8_t* begin;
+    const uint8_t* end;
+    if (!readEncodedArguments(inStream, copy, begin, end))
+        return false;
+
+    vector<StringRef> dictionary;
+    DecoderCursor cursor(begin, end, dictionary);
+    while (cursor.iter < cursor.end)
+    {
+        if (!DecoderWriter::writeItem(*outStream.m_sink, cursor))
+            return false;
+    }
+    return true;
+}
+
+bool EncodedArgumentsSerdes::deserialize(
+        RingBuffer::Stream& inStream, TextStream& outStream) const noexcept
+{
+    unique_ptr<uint8_t[]> copy;
+    const uint8_t* begin;
+    const uint8_t* end;
+    if (!readEncodedArguments(inStream, copy, begin, end))
+        return false;
+
+    vector<StringRef> dictionary;
+    DecoderCursor cursor(begin, end, dictionary);
+    while (cursor.iter < cursor.end)
+    {
+        if (!DecoderPrinter::printItem(outStream, cursor))
+            return false;
+    }
+    return true;
+}
+
+} // namespace log11_detail
+} // namespace log11
@@ -0,0 +1,218 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_BINARYDECODER_HPP
+#define LOG11_BINARYDECODER_HPP
+
+#include "BlockIndex.hpp"
+#include "Config.hpp"
+#include "LogRecordData.hpp"
+#include "Serdes.hpp"
+#include "Utility.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace log11
+{
+class TextSink;
+
+//! \brief A log record, which has been decoded from the binary format.
+struct DecodedRecord
+{
+    //! The meta-data of the record.
+    LogRecordData data;
+    //! The begin of the encoded arguments.
+    const std::uint8_t* begin;
+    //! The end of the encoded arguments.
+    const std::uint8_t* end;
+};
+
+//! \brief A decoder for the output of a BinarySink.
+//!
+//! The BinaryDecoder reads log records from a contiguous memory area, which
+//! holds the output of a BinarySink. Usually, this is a memory-mapped file.
+//! The records are decoded in place. Apart from the string dictionary, the
+//! decoder does not allocate memory.
+//!
+//! The floating-point numbers and arrays are stored in the byte order of the
+//! writer. The decoder assumes that the writer used the same byte order and
+//! the same size of <tt>long double</tt>. Immutable strings, which have been
+//! written as offsets rather than to the string dictionary, cannot be
+//! resolved and are printed as <tt>\<string@offset\></tt>.
+//!
+//! The data can be split at block headers. Every block can be decoded
+//! independently, e.g. by one decoder per thread. findBlock() locates the
+//! block headers.
+class BinaryDecoder
+{
+public:
+    enum class Status
+    {
+        Ok,        //!< A record has been decoded.
+        EndOfData, //!< There are no more records.
+        Malformed  //!< The data is corrupt.
+    };
+
+    BinaryDecoder();
+    ~BinaryDecoder();
+
+    BinaryDecoder(const BinaryDecoder&) = delete;
+    BinaryDecoder& operator=(const BinaryDecoder&) = delete;
+
+    //! \brief Sets the data to decode.
+    //!
+    //! Sets the memory area <tt>[data, data + size)</tt> from which the
+    //! records are decoded. The string dictionary is cleared. The memory
+    //! must stay valid as long as records are decoded and formatted.
+    void setData(const void* data, std::size_t size) noexcept;
+
+    //! \brief Decodes the next record.
+    //!
+    //! Decodes the next record into \p record and returns Status::Ok. If
+    //! all records have been decoded, Status::EndOfData is returned. The
+    //! definitions of the string dictionary are processed even if the
+    //! record is never formatted. Records, which do not pass the filter,
+    //! are skipped.
+    Status next(DecodedRecord& record);
+
+    //! Returns the offset of the next record in the data.
+    std::size_t position() const noexcept;
+
+    //! \brief Moves to another position.
+    //!
+    //! Continues decoding at the given \p offset, which must be the
+    //! offset of a block header (or the end of the data). The string
+    //! dictionary is cleared.
+    void seek(std::size_t offset) noexcept;
+
+    //! \brief Finds a block.
+    //!
+    //! Returns the offset of the first block header at or after the given
+    //! \p offset. The search looks for the block marker without decoding
+    //! the data. If there is no block header, the size of the data is
+    //! returned.
+    std::size_t findBlock(std::size_t offset) const noexcept;
+
+    //! \brief Sets a filter.
+    //!
+    //! next() skips the records, which do not pass the \p filter. By
+    //! default, all records pass.
+    void setFilter(const RecordFilter& filter) noexcept;
+
+    //! Returns the filter.
+    const RecordFilter& filter() const noexcept;
+
+    //! Returns true if the next record is preceded by a block header.
+    bool isAtBlockHeader() const noexcept;
+
+    //! Returns the sequence number of the current block.
+    std::uint64_t blockSequence() const noexcept;
+
+    //! \brief Sets the header of the text output.
+    //!
+    //! Sets the header, which is prepended to every formatted record. The
+    //! syntax is the same as for LogCore::setTextHeader().
+    void setTextHeader(const char* header);
+
+    //! \brief Formats a record.
+    //!
+    //! Formats the \p record with the same rules as the LogCore and writes
+    //! the text to the \p sink. The record must have been decoded with
+    //! next() from the current data.
+    void format(const DecodedRecord& record, TextSink& sink);
+
+private:
+    //! The data which is decoded.
+    const std::uint8_t* m_begin;
+    //! The position of the next record.
+    const std::uint8_t* m_iter;
+    //! The end of the data.
+    const std::uint8_t* m_end;
+    //! The sequence number of the current block.
+    std::uint64_t m_blockSequence;
+    //! The filter for the records.
+    RecordFilter m_filter;
+
+    //! The string dictionary. The strings reside in the data.
+    std::vector<StringRef> m_dictionary;
+
+    //! A scratch pad for the text formatting.
+    log11_detail::ScratchPad m_scratchPad;
+    //! The generator of the text header.
+    log11_detail::RecordHeaderGenerator* m_headerGenerator;
+};
+
+namespace log11_detail
+{
+
+//! \brief A serdes for arguments in the binary format.
+//!
+//! The serialized form is the size of the encoded arguments (16 bit)
+//! followed by the items, which a BinarySink has written for them. The items
+//! must not refer to the string dictionary. Deserializing the arguments
+//! writes the items to a binary sink again or formats them like the
+//! BinaryDecoder. The LogCore uses this serdes to replay records, which have
+//! been spilled to a file.
+class EncodedArgumentsSerdes : public SerdesBase
+{
+public:
+    static
+    EncodedArgumentsSerdes* instance();
+
+    //! Returns the size, which is needed to serialize \p size bytes of
+    //! encoded arguments.
+    static constexpr
+    std::size_t requiredSize(std::size_t size) noexcept
+    {
+        return sizeof(void*) + sizeof(std::uint16_t) + size;
+    }
+
+    //! Serializes the encoded arguments <tt>[begin, end)</tt> to the
+    //! \p stream. Returns \p false if there is not enough space.
+    static
+    bool serialize(RingBuffer::Stream& stream,
+                   const std::uint8_t* begin, const std::uint8_t* end) noexcept;
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     BinaryStream& outStream) const noexcept override;
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     TextStream& outStream) const noexcept override;
+};
+
+} // namespace log11_detail
+
+} // namespace log11
+
+#endif // LOG11_BINARYDECODER_HPP
@@ -0,0 +1,244 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "BinaryFileSink.hpp"
+
+#include <string>
+#include <utility>
+
+using namespace std;
+
+
+namespace log11
+{
+
+// ----=====================================================================----
+//     BinaryFileSink
+// ----=====================================================================----
+
+BinaryFileSink::BinaryFileSink()
+    : m_file(nullptr),
+      m_indexFile(nullptr),
+      m_codec(nullptr),
+      m_nextCodec(nullptr),
+      m_hasPendingBlock(false),
+      m_stopCompression(false),
+      m_fileOffset(0)
+{
+}
+
+BinaryFileSink::~BinaryFileSink()
+{
+    close();
+}
+
+bool BinaryFileSink::open(const char* path, bool writeIndex)
+{
+    close();
+
+    m_file = fopen(path, "wb");
+    if (!m_file)
+        return false;
+
+    if (writeIndex)
+    {
+        m_indexFile = fopen((string(path) + ".idx").c_str(), "wb");
+        if (!m_indexFile
+            || fwrite(BlockIndex::magic, sizeof(BlockIndex::magic), 1,
+                      m_indexFile) != 1)
+        {
+            close();
+            return false;
+        }
+    }
+
+    restartOutput();
+
+    m_codec = m_nextCodec;
+    if (m_codec)
+    {
+        if (blockSize() == 0)
+            setBlockSize(64 * 1024);
+        m_fillBuffer.clear();
+        m_fillBuffer.reserve(2 * blockSize());
+        m_hasPendingBlock = false;
+        m_stopCompression = false;
+        m_fileOffset = 0;
+        m_compressionThread = thread(&BinaryFileSink::compressBlocks, this);
+    }
+    return true;
+}
+
+void BinaryFileSink::close()
+{
+    if (m_file)
+        completeBlock();
+
+    if (m_compressionThread.joinable())
+    {
+        {
+            lock_guard<mutex> lock(m_compressionMutex);
+            m_stopCompression = true;
+        }
+        m_compressionCv.notify_all();
+        m_compressionThread.join();
+    }
+    m_codec = nullptr;
+
+    if (m_indexFile)
+    {
+        fclose(m_indexFile);
+        m_indexFile = nullptr;
+    }
+    if (m_file)
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool BinaryFileSink::isOpen() const noexcept
+{
+    return m_file != nullptr;
+}
+
+void BinaryFileSink::setCodec(BlockCodec* codec) noexcept
+{
+    m_nextCodec = codec;
+}
+
+void BinaryFileSink::writeByte(byte data)
+{
+    if (m_codec)
+        m_fillBuffer.push_back(data);
+    else if (m_file)
+        putc(data, m_file);
+}
+
+void BinaryFileSink::writeBytes(const byte* data, unsigned size)
+{
+    if (m_codec)
+        m_fillBuffer.insert(m_fillBuffer.end(), data, data + size);
+    else if (m_file)
+        fwrite(data, 1, size, m_file);
+}
+
+void BinaryFileSink::blockCompleted(const BlockInfo& block)
+{
+    if (!m_codec)
+    {
+        writeIndexEntry(block);
+        return;
+    }
+
+    // Hand the block over to the compression thread. We have to wait if
+    // the previous block is still being compressed.
+    {
+        unique_lock<mutex> lock(m_compressionMutex);
+        m_compressionCv.wait(lock, [&] { return !m_hasPendingBlock; });
+        swap(m_fillBuffer, m_pendingBuffer);
+        m_pendingBlock = block;
+        m_hasPendingBlock = true;
+    }
+    m_compressionCv.notify_all();
+    m_fillBuffer.clear();
+}
+
+void BinaryFileSink::writeIndexEntry(const BlockInfo& block)
+{
+    if (!m_indexFile)
+        return;
+
+    byte entry[BlockIndex::entrySize];
+    BlockIndex::encode(block, entry);
+    fwrite(entry, sizeof(entry), 1, m_indexFile);
+    // Flush the index so that a reader finds all completed blocks.
+    fflush(m_indexFile);
+}
+
+void BinaryFileSink::compressBlocks()
+{
+    for (;;)
+    {
+        unique_lock<mutex> lock(m_compressionMutex);
+        m_compressionCv.wait(lock, [&] {
+            return m_hasPendingBlock || m_stopCompression;
+        });
+        if (!m_hasPendingBlock)
+            break;
+
+        // The consumer does not touch the pending buffer until the flag
+        // has been cleared.
+        lock.unlock();
+        writeFrame(m_pendingBuffer, m_pendingBlock);
+        lock.lock();
+        m_hasPendingBlock = false;
+        lock.unlock();
+        m_compressionCv.notify_all();
+    }
+}
+
+void BinaryFileSink::writeFrame(const vector<byte>& data, BlockInfo block)
+{
+    BlockFrame frame;
+    frame.rawSize = uint32_t(data.size());
+
+    m_compressedBuffer.resize(
+            BlockFrame::headerSize + m_codec->maxCompressedSize(data.size()));
+    auto compressedSize = m_codec->compress(
+            data.data(), data.size(),
+            m_compressedBuffer.data() + BlockFrame::headerSize,
+            m_compressedBuffer.size() - BlockFrame::headerSize);
+
+    // Store the block as is if it cannot be compressed.
+    const byte* payload;
+    if (compressedSize && compressedSize < data.size())
+    {
+        frame.codec = m_codec->id();
+        frame.payloadSize = uint32_t(compressedSize);
+        payload = m_compressedBuffer.data() + BlockFrame::headerSize;
+    }
+    else
+    {
+        frame.payloadSize = frame.rawSize;
+        payload = data.data();
+    }
+
+    byte header[BlockFrame::headerSize];
+    frame.encodeHeader(header);
+    fwrite(header, sizeof(header), 1, m_file);
+    fwrite(payload, 1, frame.payloadSize, m_file);
+
+    block.offset = m_fileOffset;
+    block.size = uint32_t(BlockFrame::headerSize + frame.payloadSize);
+    m_fileOffset += block.size;
+    writeIndexEntry(block);
+}
+
+} // namespace log11
@@ -0,0 +1,155 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_BINARYFILESINK_HPP
+#define LOG11_BINARYFILESINK_HPP
+
+#include "BinarySink.hpp"
+#include "BlockCodec.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace log11
+{
+
+//! \brief A binary sink, which writes to a file.
+//!
+//! The BinaryFileSink writes the binary format to a file. Next to the file,
+//! it maintains a sparse index with the extension <tt>.idx</tt>. The index
+//! holds an entry for every block of the output (see BlockIndex), which
+//! allows a reader to skip the blocks outside of a time range or without
+//! records of a certain severity. An entry is appended when a block is
+//! complete, so the entry of the last block is missing until the file is
+//! closed.
+//!
+//! Optionally, the blocks are compressed with a BlockCodec. Every block is
+//! stored in a BlockFrame, which can be decompressed independently of the
+//! other frames. For a compressed file, the offset and size in an index
+//! entry refer to the frame of the block. The compression runs on a
+//! dedicated thread. While it compresses one block, the sink collects the
+//! next one in a second buffer. The consumer thread only waits if a block
+//! is complete before its predecessor has been compressed.
+//!
+//! The file must only be opened and closed while the sink is not attached
+//! to a log core.
+class BinaryFileSink : public BinarySink
+{
+public:
+    BinaryFileSink();
+
+    virtual
+    ~BinaryFileSink();
+
+    BinaryFileSink(const BinaryFileSink&) = delete;
+    BinaryFileSink& operator=(const BinaryFileSink&) = delete;
+
+    //! \brief Opens a file.
+    //!
+    //! Closes the current file and creates the file \p path. If
+    //! \p writeIndex is set, the index is written to \p path with the
+    //! extension <tt>.idx</tt> appended. Returns true on success.
+    bool open(const char* path, bool writeIndex = true);
+
+    //! \brief Closes the file.
+    //!
+    //! Completes the current block and closes the file and its index.
+    void close();
+
+    //! Returns true if a file is open.
+    bool isOpen() const noexcept;
+
+    //! \brief Sets the codec.
+    //!
+    //! Sets the \p codec, which compresses the blocks of the next file
+    //! which is opened. A null pointer disables the compression, which is
+    //! the default. The codec must outlive the file. As the compression
+    //! works on blocks, a block size of zero is replaced by 64 KiB.
+    void setCodec(BlockCodec* codec) noexcept;
+
+    virtual
+    void writeByte(byte data) override;
+
+    virtual
+    void writeBytes(const byte* data, unsigned size) override;
+
+protected:
+    virtual
+    void blockCompleted(const BlockInfo& block) override;
+
+private:
+    //! The output file.
+    std::FILE* m_file;
+    //! The index file.
+    std::FILE* m_indexFile;
+    //! The codec of the open file or null if the file is not compressed.
+    BlockCodec* m_codec;
+    //! The codec for the next file.
+    BlockCodec* m_nextCodec;
+
+    //! The buffer for the block which is written currently.
+    std::vector<byte> m_fillBuffer;
+    //! The block which is compressed currently.
+    std::vector<byte> m_pendingBuffer;
+    //! The summary of the pending block.
+    BlockInfo m_pendingBlock;
+    //! Set if the pending block has not been compressed yet.
+    bool m_hasPendingBlock;
+    //! Set to stop the compression thread.
+    bool m_stopCompression;
+    //! The mutex for the pending block.
+    std::mutex m_compressionMutex;
+    //! Signalled when the state of the pending block changes.
+    std::condition_variable m_compressionCv;
+    //! The thread which compresses the blocks.
+    std::thread m_compressionThread;
+
+    //! The buffer for the compressed data.
+    std::vector<byte> m_compressedBuffer;
+    //! The number of bytes which have been written to the file.
+    std::uint64_t m_fileOffset;
+
+
+    void writeIndexEntry(const BlockInfo& block);
+
+    //! Compresses the pending blocks until the file is closed.
+    void compressBlocks();
+
+    //! Compresses the \p data of a \p block and writes it as a frame.
+    void writeFrame(const std::vector<byte>& data, BlockInfo block);
+};
+
+} // namespace log11
+
+#endif // LOG11_BINARYFILESINK_HPP
@@ -29,7 +29,9 @@
 
 #include "BinarySink.hpp"
 
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 using namespace std;
@@ -42,6 +44,30 @@ namespace log11
 //     BinarySink
 // ----=====================================================================----
 
+const BinarySink::byte BinarySink::blockMarker[8] = {
+    0xC3, 'L', 'O', 'G', '1', '1', 0x0D, 0x0A
+};
+
+BinarySink::BinarySink()
+    : m_dictionary(nullptr),
+      m_dictionaryCapacity(0),
+      m_dictionarySize(0),
+      m_dictionaryEnabled(true),
+      m_dictionaryResetRequested(false),
+      m_sequenceNumbersEnabled(false),
+      m_blockSize(64 * 1024),
+      m_offset(0),
+      m_blockSequence(0),
+      m_isBlockOpen(false)
+{
+}
+
+BinarySink::~BinarySink()
+{
+    if (m_dictionary)
+        delete[] m_dictionary;
+}
+
 void BinarySink::writeBytes(const byte* data, unsigned size)
 {
     while (size--)
@@ -50,6 +76,106 @@ void BinarySink::writeBytes(const byte* data, unsigned size)
     }
 }
 
+void BinarySink::beginLogEntry(const LogRecordData& data)
+{
+    using namespace std::chrono;
+
+    BinarySinkBase::beginLogEntry(data);
+    if (!isCurrentRecordLogged())
+        return;
+
+    auto time = duration_cast<nanoseconds>(
+                    data.time.time_since_epoch()).count();
+
+    // Start a new block before the record if the current one is full.
+    unsigned blockSize = m_blockSize;
+    if (blockSize && (!m_isBlockOpen || m_offset - m_block.offset >= blockSize))
+        beginBlock();
+
+    // Update the summary of the block. The records are not strictly ordered
+    // by time because the time is taken before the record is enqueued.
+    if (m_block.numRecords == 0 || uint64_t(time) < m_block.firstTime)
+        m_block.firstTime = time;
+    if (m_block.numRecords == 0 || uint64_t(time) > m_block.lastTime)
+        m_block.lastTime = time;
+    m_block.severities |= 1u << static_cast<unsigned>(data.severity);
+    ++m_block.numRecords;
+
+    bool hasSequence = data.sequence != 0 && m_sequenceNumbersEnabled;
+    putByte(0x60 + 18);
+    writeUnsignedInteger(static_cast<unsigned>(data.severity)
+                         | (data.isTruncated ? 0x08 : 0x00)
+                         | (hasSequence ? 0x10 : 0x00));
+    writeUnsignedInteger(time);
+    if (hasSequence)
+        writeUnsignedInteger(data.sequence);
+}
+
+void BinarySink::endLogEntry(const LogRecordData& data)
+{
+    if (isCurrentRecordLogged())
+        putByte(0xE0 + 31);
+    BinarySinkBase::endLogEntry(data);
+}
+
+void BinarySink::setBlockSize(unsigned size) noexcept
+{
+    m_blockSize = size;
+}
+
+unsigned BinarySink::blockSize() const noexcept
+{
+    return m_blockSize;
+}
+
+void BinarySink::completeBlock()
+{
+    if (!m_isBlockOpen)
+        return;
+
+    m_isBlockOpen = false;
+    m_block.size = uint32_t(m_offset - m_block.offset);
+    blockCompleted(m_block);
+}
+
+void BinarySink::blockCompleted(const BlockInfo&)
+{
+}
+
+void BinarySink::restartOutput() noexcept
+{
+    clearStringDictionary();
+    m_dictionaryResetRequested = false;
+    m_offset = 0;
+    m_blockSequence = 0;
+    m_isBlockOpen = false;
+}
+
+void BinarySink::setStringDictionaryEnabled(bool enable) noexcept
+{
+    m_dictionaryEnabled = enable;
+}
+
+bool BinarySink::isStringDictionaryEnabled() const noexcept
+{
+    return m_dictionaryEnabled;
+}
+
+void BinarySink::setSequenceNumbersEnabled(bool enable) noexcept
+{
+    m_sequenceNumbersEnabled = enable;
+}
+
+bool BinarySink::areSequenceNumbersEnabled() const noexcept
+{
+    return m_sequenceNumbersEnabled;
+}
+
+void BinarySink::resetStringDictionary() noexcept
+{
+    m_dictionaryResetRequested = true;
+}
+
 // -----------------------------------------------------------------------------
 //     Bool & char output
 // -----------------------------------------------------------------------------
@@ -59,7 +185,7 @@ void BinarySink::write(bool value)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(value ? 0xE0 : 0xE1);
+    putByte(value ? 0xE0 + 1 : 0xE0 + 0);
 }
 
 void BinarySink::write(char ch)
@@ -67,8 +193,8 @@ void BinarySink::write(char ch)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0x41);
-    writeByte(byte(ch));
+    putByte(0x41);
+    putByte(byte(ch));
 }
 
 // -----------------------------------------------------------------------------
@@ -164,8 +290,8 @@ void BinarySink::write(float value)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0xE0 + 8);
-    writeBytes(reinterpret_cast<byte*>(&value), sizeof(value));
+    putByte(0xE0 + 8);
+    putBytes(reinterpret_cast<byte*>(&value), sizeof(value));
 }
 
 void BinarySink::write(double value)
@@ -173,8 +299,8 @@ void BinarySink::write(double value)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0xE0 + 9);
-    writeBytes(reinterpret_cast<byte*>(&value), sizeof(value));
+    putByte(0xE0 + 9);
+    putBytes(reinterpret_cast<byte*>(&value), sizeof(value));
 }
 
 void BinarySink::write(long double value)
@@ -182,8 +308,8 @@ void BinarySink::write(long double value)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0xE0 + 10);
-    writeBytes(reinterpret_cast<byte*>(&value), sizeof(value));
+    putByte(0xE0 + 10);
+    putBytes(reinterpret_cast<byte*>(&value), sizeof(value));
 }
 
 // -----------------------------------------------------------------------------
@@ -199,22 +325,22 @@ void BinarySink::write(const void* ptr)
 
     if (value == 0)
     {
-        writeByte(0xE0 + 2);
+        putByte(0xE0 + 2);
     }
     else if (value < std::uintptr_t(1) << 24)
     {
-        writeByte(0xE0 + 16);
-        writeBytes(reinterpret_cast<const byte*>(&value), 3);
+        putByte(0xE0 + 16);
+        putBytes(reinterpret_cast<const byte*>(&value), 3);
     }
     else if (sizeof(value) == 4)
     {
-        writeByte(0xE0 + 17);
-        writeBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
+        putByte(0xE0 + 17);
+        putBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
     }
     else
     {
-        writeByte(0xE0 + 18);
-        writeBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
+        putByte(0xE0 + 18);
+        putBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
     }
 }
 
@@ -228,26 +354,50 @@ void BinarySink::write(Immutable<const char*> str,
     if (!isCurrentRecordLogged())
         return;
 
-    std::uintptr_t value = std::uintptr_t(str.get()) - immutableStringSpaceBegin;
-
     if (str.get() == nullptr)
     {
-        writeByte(0x40);
+        putByte(0x40);
+        return;
     }
-    else if (value < std::uintptr_t(1) << 24)
+
+    if (m_dictionaryEnabled)
+    {
+        if (m_dictionaryResetRequested.exchange(false))
+            clearStringDictionary();
+
+        DictionaryEntry& entry = findDictionaryEntry(str.get());
+        if (entry.str)
+        {
+            putByte(0xA0 + 1);
+            writeUnsignedInteger(entry.id);
+        }
+        else
+        {
+            entry.str = str.get();
+            ++m_dictionarySize;
+            putByte(0xA0 + 0);
+            writeUnsignedInteger(entry.id);
+            write(SplitStringView{str.get(), strlen(str.get()), nullptr, 0});
+        }
+        return;
+    }
+
+    std::uintptr_t value = std::uintptr_t(str.get()) - immutableStringSpaceBegin;
+
+    if (value < std::uintptr_t(1) << 24)
     {
-        writeByte(0xE0 + 20);
-        writeBytes(reinterpret_cast<const byte*>(&value), 3);
+        putByte(0xE0 + 20);
+        putBytes(reinterpret_cast<const byte*>(&value), 3);
     }
     else if (sizeof(value) == 4)
     {
-        writeByte(0xE0 + 21);
-        writeBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
+        putByte(0xE0 + 21);
+        putBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
     }
     else
     {
-        writeByte(0xE0 + 22);
-        writeBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
+        putByte(0xE0 + 22);
+        putBytes(reinterpret_cast<const byte*>(&value), sizeof(value));
     }
 }
 
@@ -256,27 +406,106 @@ void BinarySink::write(const SplitStringView& str)
     if (!isCurrentRecordLogged())
         return;
 
-    auto totalSize = str.length1 + str.length2;
+    // The length has 16 bits, so a longer string is clipped.
+    auto length1 = str.length1 < 0xFFFF ? str.length1 : 0xFFFF;
+    auto length2 = str.length2 < 0xFFFF - length1 ? str.length2
+                                                  : 0xFFFF - length1;
+    auto totalSize = length1 + length2;
     if (totalSize < 30)
     {
-        writeByte(0x40 + totalSize);
+        putByte(0x40 + totalSize);
     }
     else if (totalSize < 256)
     {
-        writeByte(0x40 + 30);
-        writeByte(totalSize);
+        putByte(0x40 + 30);
+        putByte(totalSize);
     }
     else
     {
-        writeByte(0x40 + 31);
-        writeByte(totalSize);
-        writeByte(totalSize >> 8);
+        putByte(0x40 + 31);
+        putByte(totalSize);
+        putByte(totalSize >> 8);
     }
 
-    if (str.length1)
-        writeBytes(reinterpret_cast<const byte*>(str.begin1), str.length1);
-    if (str.length2)
-        writeBytes(reinterpret_cast<const byte*>(str.begin2), str.length2);
+    if (length1)
+        putBytes(reinterpret_cast<const byte*>(str.begin1), length1);
+    if (length2)
+        putBytes(reinterpret_cast<const byte*>(str.begin2), length2);
+}
+
+void BinarySink::beginBlock()
+{
+    // Every block starts with an empty string dictionary, so that it can
+    // be decoded without the preceding blocks.
+    clearStringDictionary();
+    m_dictionaryResetRequested = false;
+
+    completeBlock();
+    m_block = BlockInfo();
+    m_block.offset = m_offset;
+    m_isBlockOpen = true;
+    putByte(0x60 + 19);
+    putBytes(blockMarker, sizeof(blockMarker));
+    writeUnsignedInteger(m_blockSequence++);
+}
+
+void BinarySink::clearStringDictionary() noexcept
+{
+    for (unsigned idx = 0; idx < m_dictionaryCapacity; ++idx)
+        m_dictionary[idx].str = nullptr;
+    m_dictionarySize = 0;
+}
+
+BinarySink::DictionaryEntry& BinarySink::findDictionaryEntry(const char* str)
+{
+    // Grow the table when it is filled to 3/4.
+    if (4 * (m_dictionarySize + 1) > 3 * m_dictionaryCapacity)
+    {
+        unsigned newCapacity = m_dictionaryCapacity ? 2 * m_dictionaryCapacity : 64;
+        DictionaryEntry* newDictionary = new DictionaryEntry[newCapacity];
+        for (unsigned idx = 0; idx < newCapacity; ++idx)
+            newDictionary[idx].str = nullptr;
+
+        DictionaryEntry* oldDictionary = m_dictionary;
+        unsigned oldCapacity = m_dictionaryCapacity;
+        m_dictionary = newDictionary;
+        m_dictionaryCapacity = newCapacity;
+        for (unsigned idx = 0; idx < oldCapacity; ++idx)
+        {
+            if (oldDictionary[idx].str)
+                findDictionaryEntry(oldDictionary[idx].str) = oldDictionary[idx];
+        }
+        if (oldDictionary)
+            delete[] oldDictionary;
+    }
+
+    auto hash = std::uintptr_t(str) * std::uintptr_t(0x9E3779B97F4A7C15ull);
+    unsigned idx = (hash >> (sizeof(std::uintptr_t) * 8 - 24))
+                   & (m_dictionaryCapacity - 1);
+    while (m_dictionary[idx].str && m_dictionary[idx].str != str)
+        idx = (idx + 1) & (m_dictionaryCapacity - 1);
+
+    if (!m_dictionary[idx].str)
+        m_dictionary[idx].id = m_dictionarySize;
+    return m_dictionary[idx];
+}
+
+// -----------------------------------------------------------------------------
+//     Array output
+// -----------------------------------------------------------------------------
+
+void BinarySink::writeArray(ArrayElementType type, std::size_t count,
+                            const SplitStringView& data)
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    putByte(0x80 + static_cast<byte>(type));
+    writeUnsignedInteger(count);
+    if (data.length1)
+        putBytes(reinterpret_cast<const byte*>(data.begin1), data.length1);
+    if (data.length2)
+        putBytes(reinterpret_cast<const byte*>(data.begin2), data.length2);
 }
 
 // -----------------------------------------------------------------------------
@@ -288,7 +517,7 @@ void BinarySink::beginFormatTuple()
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0x60 + 16);
+    putByte(0x60 + 16);
 }
 
 void BinarySink::endFormatTuple()
@@ -296,7 +525,15 @@ void BinarySink::endFormatTuple()
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0xE0 + 31);
+    putByte(0xE0 + 31);
+}
+
+void BinarySink::beginField()
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    putByte(0x60 + 17);
 }
 
 void BinarySink::beginStruct(std::uint32_t tag)
@@ -306,29 +543,29 @@ void BinarySink::beginStruct(std::uint32_t tag)
 
     if (tag < std::uint32_t(1) << 8)
     {
-        writeByte(0x60 + 0);
-        writeByte(tag);
+        putByte(0x60 + 0);
+        putByte(tag);
     }
     else if (tag < std::uint32_t(1) << 16)
     {
-        writeByte(0x60 + 1);
-        writeByte(tag >> 0);
-        writeByte(tag >> 8);
+        putByte(0x60 + 1);
+        putByte(tag >> 0);
+        putByte(tag >> 8);
     }
     else if (tag < std::uint32_t(1) << 24)
     {
-        writeByte(0x60 + 2);
-        writeByte(tag >>  0);
-        writeByte(tag >>  8);
-        writeByte(tag >> 16);
+        putByte(0x60 + 2);
+        putByte(tag >>  0);
+        putByte(tag >>  8);
+        putByte(tag >> 16);
     }
     else
     {
-        writeByte(0x60 + 3);
-        writeByte(tag >>  0);
-        writeByte(tag >>  8);
-        writeByte(tag >> 16);
-        writeByte(tag >> 24);
+        putByte(0x60 + 3);
+        putByte(tag >>  0);
+        putByte(tag >>  8);
+        putByte(tag >> 16);
+        putByte(tag >> 24);
     }
 }
 
@@ -337,7 +574,7 @@ void BinarySink::endStruct(std::uint32_t /*tag*/)
     if (!isCurrentRecordLogged())
         return;
 
-    writeByte(0xE0 + 31);
+    putByte(0xE0 + 31);
 }
 
 void BinarySink::writeEnum(std::uint32_t tag, std::int64_t value)
@@ -347,29 +584,29 @@ void BinarySink::writeEnum(std::uint32_t tag, std::int64_t value)
 
     if (tag < std::uint32_t(1) << 8)
     {
-        writeByte(0x60 + 4);
-        writeByte(tag);
+        putByte(0x60 + 4);
+        putByte(tag);
     }
     else if (tag < std::uint32_t(1) << 16)
     {
-        writeByte(0x60 + 5);
-        writeByte(tag >> 0);
-        writeByte(tag >> 8);
+        putByte(0x60 + 5);
+        putByte(tag >> 0);
+        putByte(tag >> 8);
     }
     else if (tag < std::uint32_t(1) << 24)
     {
-        writeByte(0x60 + 6);
-        writeByte(tag >>  0);
-        writeByte(tag >>  8);
-        writeByte(tag >> 16);
+        putByte(0x60 + 6);
+        putByte(tag >>  0);
+        putByte(tag >>  8);
+        putByte(tag >> 16);
     }
     else
     {
-        writeByte(0x60 + 7);
-        writeByte(tag >>  0);
-        writeByte(tag >>  8);
-        writeByte(tag >> 16);
-        writeByte(tag >> 24);
+        putByte(0x60 + 7);
+        putByte(tag >>  0);
+        putByte(tag >>  8);
+        putByte(tag >> 16);
+        putByte(tag >> 24);
     }
     writeSignedInteger(value);
 }
@@ -385,7 +622,7 @@ void BinarySink::writeUnsignedInteger(std::uint64_t value, byte tag)
 
     if (value < 24)
     {
-        writeByte(tag + value);
+        putByte(tag + value);
     }
     else
     {
@@ -396,7 +633,7 @@ void BinarySink::writeUnsignedInteger(std::uint64_t value, byte tag)
             buffer[idx++] = value & 0xFF;
             value >>= 8;
         }
-        writeBytes(&buffer[0], idx);
+        putBytes(&buffer[0], idx);
     }
 }
 
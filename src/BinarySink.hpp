@@ -31,7 +31,9 @@
 #define LOG11_BINARYSINK_HPP
 
 #include "BinarySinkBase.hpp"
+#include "BlockIndex.hpp"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 
@@ -66,9 +68,38 @@ namespace log11
 //                        6 ... enum with 3 byte ID
 //                        7 ... enum with 4 byte ID
 //                       16 ... format tuple begin
+//                       17 ... field (followed by key string and value)
+//                       18 ... record begin, followed by the flags (as
+//                              positive integer; bits 0-2: severity, bit 3:
+//                              truncated, bit 4: has sequence number), the
+//                              time in nanoseconds since the clock's epoch
+//                              (as positive integer), the sequence number
+//                              of the record (as positive integer; only if
+//                              bit 4 is set), the arguments and a break
+//                       19 ... block begin, followed by the block marker
+//                              (8 bytes) and the sequence number of the
+//                              block (as positive integer)
+//
+// 0x80: 100x xxxx ... typed array, followed by the number of elements
+//                     (as positive integer) and the raw elements
+//                        0 ... int8
+//                        1 ... uint8
+//                        2 ... int16
+//                        3 ... uint16
+//                        4 ... int32
+//                        5 ... uint32
+//                        6 ... int64
+//                        7 ... uint64
+//                        8 ... float
+//                        9 ... double
+//                       10 ... long double
+//
+// 0xA0: 101x xxxx ... string dictionary
+//                        0 ... definition, followed by the ID (as positive
+//                              integer) and the string
+//                        1 ... reference, followed by the ID (as positive
+//                              integer)
 //
-// 0x80: reserved
-// 0xA0: reserved
 // 0xC0: reserved
 //
 // 0xE0: 111x xxxx ... simple types
@@ -86,17 +117,90 @@ namespace log11
 //                       22 ... char* (8 byte)
 //                       31 ... break
 //
-// TODO:
-// - arrays
+// Immutable strings are written to a string dictionary by default. The first
+// occurrence of a string emits a definition, which assigns the next free ID
+// (starting at zero) to the string. Later occurrences emit a reference to the
+// ID. If the dictionary is disabled, immutable strings are written as offsets
+// into the immutable string space (0xE0 + 20, 21, 22).
+//
+// The output is divided into blocks of about 64 KiB. A block begins with a
+// block header in front of a record. The header contains a marker, which
+// allows a reader to find the block boundaries without decoding the
+// preceding data. The string dictionary is reset at the beginning of every
+// block, so the blocks can be decoded independently of each other. When a
+// block is complete, the sink passes a summary of it to blockCompleted(),
+// which a derived class can use to build an index.
 class BinarySink : public BinarySinkBase
 {
 public:
+    //! The marker in a block header.
+    static const byte blockMarker[8];
+
+    BinarySink();
+
+    virtual
+    ~BinarySink();
+
     virtual
     void writeByte(byte data) = 0;
 
     virtual
     void writeBytes(const byte* data, unsigned size);
 
+    //! \brief Sets the block size.
+    //!
+    //! Sets the minimum \p size of a block in bytes. A new block is started
+    //! in front of the first record, which begins after the current block
+    //! has reached the given size. A size of zero disables the blocks.
+    //! The default size is 64 KiB.
+    void setBlockSize(unsigned size) noexcept;
+
+    //! \brief Returns the block size.
+    unsigned blockSize() const noexcept;
+
+    //! \brief Completes the current block.
+    //!
+    //! Passes the summary of the current block to blockCompleted(). The next
+    //! record starts a new block. This method must not be called while the
+    //! sink is attached to a log core.
+    void completeBlock();
+
+    //! \brief Enables or disables the string dictionary.
+    //!
+    //! If \p enable is set, immutable strings are written to the string
+    //! dictionary, which makes the output self-contained. Otherwise,
+    //! immutable strings are written as offsets, which can only be decoded
+    //! with the program image. By default, the dictionary is enabled.
+    void setStringDictionaryEnabled(bool enable) noexcept;
+
+    //! \brief Checks if the string dictionary is enabled.
+    bool isStringDictionaryEnabled() const noexcept;
+
+    //! \brief Enables or disables the sequence numbers.
+    //!
+    //! If \p enable is set, the sequence number of every record is written
+    //! to the output. A reader can use it to detect records, which have
+    //! been dropped. By default, the sequence numbers are disabled.
+    void setSequenceNumbersEnabled(bool enable) noexcept;
+
+    //! \brief Checks if the sequence numbers are enabled.
+    bool areSequenceNumbersEnabled() const noexcept;
+
+    //! \brief Resets the string dictionary.
+    //!
+    //! Forgets all strings in the dictionary, such that the next use of
+    //! every string emits a definition again. A derived class calls this
+    //! method when it starts a new output file, for example. The method
+    //! may be called from any thread. The reset happens before the next
+    //! string is written.
+    void resetStringDictionary() noexcept;
+
+    virtual
+    void beginLogEntry(const LogRecordData& data) override;
+
+    virtual
+    void endLogEntry(const LogRecordData& data) override;
+
 protected:
     virtual
     void write(bool value) override;
@@ -153,12 +257,19 @@ protected:
     virtual
     void write(const SplitStringView& str) override;
 
+    virtual
+    void writeArray(ArrayElementType type, std::size_t count,
+                    const SplitStringView& data) override;
+
     virtual
     void beginFormatTuple() override;
 
     virtual
     void endFormatTuple() override;
 
+    virtual
+    void beginField() override;
+
     virtual
     void beginStruct(std::uint32_t tag) override;
 
@@ -172,6 +283,80 @@ protected:
 
     void writeUnsignedInteger(std::uint64_t value, byte tag = 0x00);
     void writeSignedInteger(std::int64_t value);
+
+    //! \brief Called when a block is complete.
+    //!
+    //! The \p block summarizes the block, which has been written just now.
+    //! The default implementation does nothing.
+    virtual
+    void blockCompleted(const BlockInfo& block);
+
+    //! \brief Restarts the output.
+    //!
+    //! Starts counting the bytes from zero and resets the string dictionary
+    //! and the block sequence. A derived class calls this method when it
+    //! starts a new output file. The current block is discarded without
+    //! calling blockCompleted(). This method must not be called while the
+    //! sink is attached to a log core.
+    void restartOutput() noexcept;
+
+private:
+    struct DictionaryEntry
+    {
+        const char* str;
+        std::uint32_t id;
+    };
+
+    //! An open-addressing hash table which maps strings to their IDs.
+    DictionaryEntry* m_dictionary;
+    //! The capacity of the dictionary (a power of two).
+    unsigned m_dictionaryCapacity;
+    //! The number of strings in the dictionary.
+    unsigned m_dictionarySize;
+    //! Set if the string dictionary is enabled.
+    std::atomic<bool> m_dictionaryEnabled;
+    //! Set if the string dictionary has to be reset.
+    std::atomic<bool> m_dictionaryResetRequested;
+    //! Set if the sequence numbers are written.
+    std::atomic<bool> m_sequenceNumbersEnabled;
+
+    //! The minimum size of a block.
+    std::atomic<unsigned> m_blockSize;
+    //! The number of bytes which have been written so far.
+    std::uint64_t m_offset;
+    //! The summary of the current block.
+    BlockInfo m_block;
+    //! The sequence number of the next block.
+    std::uint64_t m_blockSequence;
+    //! Set if a block has been started.
+    bool m_isBlockOpen;
+
+
+    //! Writes the byte \p data and counts it for the current block.
+    void putByte(byte data)
+    {
+        ++m_offset;
+        writeByte(data);
+    }
+
+    //! Writes the \p size bytes in \p data and counts them for the
+    //! current block.
+    void putBytes(const byte* data, unsigned size)
+    {
+        m_offset += size;
+        writeBytes(data, size);
+    }
+
+    //! Writes a block header.
+    void beginBlock();
+
+    void clearStringDictionary() noexcept;
+
+
+    //! Returns the dictionary entry for the string \p str. If the string
+    //! is not in the dictionary yet, the ID of the returned entry is set to
+    //! the dictionary's size and the string pointer is null.
+    DictionaryEntry& findDictionaryEntry(const char* str);
 };
 
 } // namespace log11
@@ -119,12 +119,25 @@ public:
 
 
 
+    //! Writes an array of \p count elements of the given \p type. The
+    //! elements are passed as raw bytes in \p data, which can be split
+    //! into two parts.
+    virtual
+    void writeArray(ArrayElementType type, std::size_t count,
+                    const SplitStringView& data) = 0;
+
+
+
     virtual
     void beginFormatTuple() = 0;
 
     virtual
     void endFormatTuple() = 0;
 
+    //! Starts a structured field. The key (a string) and the value follow.
+    virtual
+    void beginField() = 0;
+
     virtual
     void beginStruct(std::uint32_t tag) = 0;
 
@@ -54,10 +54,15 @@ struct TypeTraits;
 
 namespace log11_detail
 {
+class EncodedArgumentsSerdes;
 class FormatTupleSerdes;
+class KeyValueSerdes;
 class SerdesOptions;
 class TupleSerdes;
 
+template <typename T>
+class ArraySerdes;
+
 template <typename T>
 class Serdes;
 
@@ -211,11 +216,21 @@ private:
     log11_detail::SerdesOptions& m_options;
 
 
+    friend
+    class log11_detail::EncodedArgumentsSerdes;
+
     friend
     class log11_detail::FormatTupleSerdes;
 
+    friend
+    class log11_detail::KeyValueSerdes;
+
     friend
     class log11_detail::TupleSerdes;
+
+    template <typename T>
+    friend
+    class log11_detail::ArraySerdes;
 };
 
 } // namespace log11
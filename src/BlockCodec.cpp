@@ -0,0 +1,318 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "BlockCodec.hpp"
+#include "Utility.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace log11
+{
+
+namespace log11_detail
+{
+
+// The parameters of the LZ4 block format. A match is at least 4 bytes long.
+// The last 5 bytes are always literals and the last match must start at
+// least 12 bytes before the end of the block.
+constexpr size_t lz4MinMatch = 4;
+constexpr size_t lz4LastLiterals = 5;
+constexpr size_t lz4MatchLimit = 12;
+constexpr size_t lz4MaxOffset = 65535;
+constexpr unsigned lz4HashBits = 14;
+
+inline
+uint32_t read32(const uint8_t* data) noexcept
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline
+uint32_t lz4Hash(uint32_t value) noexcept
+{
+    return (value * 2654435761u) >> (32 - lz4HashBits);
+}
+
+//! Writes a length extension of the LZ4 format.
+inline
+uint8_t* writeLz4Length(uint8_t* iter, size_t length) noexcept
+{
+    while (length >= 255)
+    {
+        *iter++ = 255;
+        length -= 255;
+    }
+    *iter++ = uint8_t(length);
+    return iter;
+}
+
+//! Reads a length extension of the LZ4 format.
+inline
+bool readLz4Length(const uint8_t*& iter, const uint8_t* end,
+                   size_t& length) noexcept
+{
+    uint8_t value;
+    do
+    {
+        if (iter == end)
+            return false;
+        value = *iter++;
+        length += value;
+    } while (value == 255);
+    return true;
+}
+
+} // namespace log11_detail
+
+using namespace log11_detail;
+
+// ----=====================================================================----
+//     BlockCodec
+// ----=====================================================================----
+
+BlockCodec::~BlockCodec()
+{
+}
+
+// ----=====================================================================----
+//     Lz4Codec
+// ----=====================================================================----
+
+constexpr uint8_t Lz4Codec::codecId;
+
+Lz4Codec::Lz4Codec()
+    : m_hashTable(new uint32_t[size_t(1) << lz4HashBits])
+{
+}
+
+Lz4Codec::~Lz4Codec()
+{
+    delete[] m_hashTable;
+}
+
+uint8_t Lz4Codec::id() const noexcept
+{
+    return codecId;
+}
+
+size_t Lz4Codec::maxCompressedSize(size_t size) const noexcept
+{
+    return size + size / 255 + 16;
+}
+
+size_t Lz4Codec::compress(const uint8_t* source, size_t size,
+                          uint8_t* dest, size_t capacity)
+{
+    uint8_t* out = dest;
+    uint8_t* outEnd = dest + capacity;
+    size_t anchor = 0;
+
+    // Emits the literals from the anchor up to 'position' followed by a
+    // match of 'length' bytes at 'offset'. A length of zero emits the
+    // final literals.
+    auto emit = [&](size_t position, size_t offset, size_t length) {
+        size_t numLiterals = position - anchor;
+        if (size_t(outEnd - out) < 1 + numLiterals + numLiterals / 255 + 1
+                                   + 2 + length / 255 + 1)
+        {
+            return false;
+        }
+        uint8_t* token = out++;
+        *token = uint8_t((numLiterals < 15 ? numLiterals : 15) << 4);
+        if (numLiterals >= 15)
+            out = writeLz4Length(out, numLiterals - 15);
+        if (numLiterals)
+            memcpy(out, source + anchor, numLiterals);
+        out += numLiterals;
+        if (length)
+        {
+            *out++ = uint8_t(offset);
+            *out++ = uint8_t(offset >> 8);
+            length -= lz4MinMatch;
+            *token |= uint8_t(length < 15 ? length : 15);
+            if (length >= 15)
+                out = writeLz4Length(out, length - 15);
+        }
+        return true;
+    };
+
+    if (size > lz4MatchLimit)
+    {
+        memset(m_hashTable, 0, sizeof(uint32_t) << lz4HashBits);
+        size_t limit = size - lz4MatchLimit;
+        size_t matchEnd = size - lz4LastLiterals;
+        size_t position = 0;
+        while (position < limit)
+        {
+            uint32_t sequence = read32(source + position);
+            uint32_t& slot = m_hashTable[lz4Hash(sequence)];
+            size_t candidate = slot;
+            slot = uint32_t(position + 1);
+            if (   candidate == 0
+                || position - (candidate - 1) > lz4MaxOffset
+                || read32(source + candidate - 1) != sequence)
+            {
+                // Skip faster through incompressible data.
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            size_t match = candidate - 1;
+            while (position > anchor && match > 0
+                   && source[position - 1] == source[match - 1])
+            {
+                --position;
+                --match;
+            }
+            size_t length = lz4MinMatch;
+            while (position + length + sizeof(uint64_t) <= matchEnd)
+            {
+                uint64_t a, b;
+                memcpy(&a, source + position + length, sizeof(a));
+                memcpy(&b, source + match + length, sizeof(b));
+                if (a != b)
+                    break;
+                length += sizeof(uint64_t);
+            }
+            while (position + length < matchEnd
+                   && source[position + length] == source[match + length])
+            {
+                ++length;
+            }
+
+            if (!emit(position, position - match, length))
+                return 0;
+            position += length;
+            anchor = position;
+            if (position < limit)
+            {
+                m_hashTable[lz4Hash(read32(source + position - 2))]
+                        = uint32_t(position - 1);
+            }
+        }
+    }
+
+    if (!emit(size, 0, 0))
+        return 0;
+    return out - dest;
+}
+
+bool Lz4Codec::decompress(const uint8_t* source, size_t size,
+                          uint8_t* dest, size_t rawSize) const
+{
+    const uint8_t* in = source;
+    const uint8_t* inEnd = source + size;
+    uint8_t* out = dest;
+    uint8_t* outEnd = dest + rawSize;
+
+    while (in < inEnd)
+    {
+        uint8_t token = *in++;
+
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLz4Length(in, inEnd, numLiterals))
+            return false;
+        if (   size_t(inEnd - in) < numLiterals
+            || size_t(outEnd - out) < numLiterals)
+        {
+            return false;
+        }
+        if (numLiterals)
+            memcpy(out, in, numLiterals);
+        in += numLiterals;
+        out += numLiterals;
+
+        // The last sequence has no match.
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+        size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > size_t(out - dest))
+            return false;
+
+        size_t length = token & 0x0F;
+        if (length == 15 && !readLz4Length(in, inEnd, length))
+            return false;
+        length += lz4MinMatch;
+        if (size_t(outEnd - out) < length)
+            return false;
+
+        // The match may overlap with the output.
+        const uint8_t* match = out - offset;
+        if (offset >= length)
+        {
+            memcpy(out, match, length);
+            out += length;
+        }
+        else
+        {
+            while (length--)
+                *out++ = *match++;
+        }
+    }
+
+    return out == outEnd;
+}
+
+// ----=====================================================================----
+//     BlockFrame
+// ----=====================================================================----
+
+const uint8_t BlockFrame::magic[4] = { 'L', '1', '1', 'Z' };
+
+constexpr size_t BlockFrame::headerSize;
+
+void BlockFrame::encodeHeader(uint8_t* buffer) const noexcept
+{
+    memcpy(buffer, magic, sizeof(magic));
+    buffer[4] = codec;
+    buffer[5] = buffer[6] = buffer[7] = 0;
+    storeLittleEndian(rawSize, buffer + 8);
+    storeLittleEndian(payloadSize, buffer + 12);
+}
+
+bool BlockFrame::decodeHeader(const uint8_t* buffer, size_t size) noexcept
+{
+    if (size < headerSize || memcmp(buffer, magic, sizeof(magic)) != 0)
+        return false;
+    codec = buffer[4];
+    rawSize = loadLittleEndian<uint32_t>(buffer + 8);
+    payloadSize = loadLittleEndian<uint32_t>(buffer + 12);
+    return size - headerSize >= payloadSize;
+}
+
+} // namespace log11
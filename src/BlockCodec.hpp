@@ -0,0 +1,156 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_BLOCKCODEC_HPP
+#define LOG11_BLOCKCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace log11
+{
+
+//! \brief An interface for block compression.
+//!
+//! A BlockCodec compresses and decompresses independent blocks of data.
+//! Every codec has a unique ID, which is stored in the frame of a block
+//! (see BlockFrame). The ID 0 is reserved for uncompressed blocks.
+class BlockCodec
+{
+public:
+    virtual
+    ~BlockCodec();
+
+    //! Returns the ID of the codec.
+    virtual
+    std::uint8_t id() const noexcept = 0;
+
+    //! Returns the maximum size of the compressed form of \p size bytes.
+    virtual
+    std::size_t maxCompressedSize(std::size_t size) const noexcept = 0;
+
+    //! \brief Compresses a block.
+    //!
+    //! Compresses the \p size bytes in \p source into \p dest, which has a
+    //! space for \p capacity bytes. Returns the size of the compressed data
+    //! or zero if the data does not fit.
+    virtual
+    std::size_t compress(const std::uint8_t* source, std::size_t size,
+                         std::uint8_t* dest, std::size_t capacity) = 0;
+
+    //! \brief Decompresses a block.
+    //!
+    //! Decompresses the \p size bytes in \p source into \p dest, which must
+    //! be exactly \p rawSize bytes large. Returns false if the data is
+    //! malformed. This method may be called from multiple threads
+    //! concurrently.
+    virtual
+    bool decompress(const std::uint8_t* source, std::size_t size,
+                    std::uint8_t* dest, std::size_t rawSize) const = 0;
+};
+
+//! \brief A codec for the LZ4 block format.
+//!
+//! The Lz4Codec is a fast LZ77-type codec, which produces the block format
+//! of LZ4. It does not need any memory beyond a hash table of 64 KiB.
+//! Because of this table, a codec must be used by one thread at a time
+//! for compression. Decompression is stateless.
+class Lz4Codec : public BlockCodec
+{
+public:
+    //! The ID of the codec.
+    static constexpr std::uint8_t codecId = 1;
+
+    Lz4Codec();
+
+    virtual
+    ~Lz4Codec();
+
+    Lz4Codec(const Lz4Codec&) = delete;
+    Lz4Codec& operator=(const Lz4Codec&) = delete;
+
+    virtual
+    std::uint8_t id() const noexcept override;
+
+    virtual
+    std::size_t maxCompressedSize(std::size_t size) const noexcept override;
+
+    virtual
+    std::size_t compress(const std::uint8_t* source, std::size_t size,
+                         std::uint8_t* dest, std::size_t capacity) override;
+
+    virtual
+    bool decompress(const std::uint8_t* source, std::size_t size,
+                    std::uint8_t* dest, std::size_t rawSize) const override;
+
+private:
+    //! The hash table which maps a hash of 4 bytes to their position + 1.
+    std::uint32_t* m_hashTable;
+};
+
+//! \brief The frame of a compressed block.
+//!
+//! A compressed file is a sequence of frames, each holding one block. A
+//! frame begins with a header of 16 bytes, which is followed by the
+//! payload. All numbers are stored in little-endian byte order.
+//! \code
+//! magic        4 bytes ('L', '1', '1', 'Z')
+//! codec        1 byte (0 if the payload is not compressed)
+//! reserved     3 bytes (zero)
+//! rawSize      4 bytes
+//! payloadSize  4 bytes
+//! \endcode
+struct BlockFrame
+{
+    //! The magic bytes at the start of a frame.
+    static const std::uint8_t magic[4];
+
+    //! The size of the frame header.
+    static constexpr std::size_t headerSize = 16;
+
+    //! The ID of the codec.
+    std::uint8_t codec = 0;
+    //! The size of the decompressed block.
+    std::uint32_t rawSize = 0;
+    //! The size of the payload.
+    std::uint32_t payloadSize = 0;
+
+    //! Encodes the frame header into the \p buffer, which must have a size of
+    //! at least headerSize bytes.
+    void encodeHeader(std::uint8_t* buffer) const noexcept;
+
+    //! Decodes a frame header from the \p size bytes in the \p buffer.
+    //! Returns false if the buffer does not start with a valid header.
+    bool decodeHeader(const std::uint8_t* buffer, std::size_t size) noexcept;
+};
+
+} // namespace log11
+
+#endif // LOG11_BLOCKCODEC_HPP
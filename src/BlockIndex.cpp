@@ -0,0 +1,76 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "BlockIndex.hpp"
+#include "Utility.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace log11
+{
+
+using namespace log11_detail;
+
+// ----=====================================================================----
+//     BlockIndex
+// ----=====================================================================----
+
+const uint8_t BlockIndex::magic[8] = {
+    'L', 'O', 'G', '1', '1', 'I', 'D', 'X'
+};
+
+constexpr size_t BlockIndex::entrySize;
+
+void BlockIndex::encode(const BlockInfo& block, uint8_t* buffer) noexcept
+{
+    storeLittleEndian(block.offset, buffer);
+    storeLittleEndian(block.size, buffer + 8);
+    storeLittleEndian(block.numRecords, buffer + 12);
+    storeLittleEndian(block.firstTime, buffer + 16);
+    storeLittleEndian(block.lastTime, buffer + 24);
+    buffer[32] = block.severities;
+    memset(buffer + 33, 0, entrySize - 33);
+}
+
+BlockInfo BlockIndex::decode(const uint8_t* buffer) noexcept
+{
+    BlockInfo block;
+    block.offset = loadLittleEndian<uint64_t>(buffer);
+    block.size = loadLittleEndian<uint32_t>(buffer + 8);
+    block.numRecords = loadLittleEndian<uint32_t>(buffer + 12);
+    block.firstTime = loadLittleEndian<uint64_t>(buffer + 16);
+    block.lastTime = loadLittleEndian<uint64_t>(buffer + 24);
+    block.severities = buffer[32];
+    return block;
+}
+
+} // namespace log11
@@ -0,0 +1,134 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_BLOCKINDEX_HPP
+#define LOG11_BLOCKINDEX_HPP
+
+#include "Severity.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+
+namespace log11
+{
+
+//! \brief A summary of a block in the output of a BinarySink.
+//!
+//! The times are given in nanoseconds since the epoch of the high resolution
+//! clock, which is the same unit as in the binary format.
+struct BlockInfo
+{
+    //! The offset of the block header in the output.
+    std::uint64_t offset = 0;
+    //! The size of the block in bytes including the header.
+    std::uint32_t size = 0;
+    //! The number of records in the block.
+    std::uint32_t numRecords = 0;
+    //! The earliest time of a record in the block.
+    std::uint64_t firstTime = 0;
+    //! The latest time of a record in the block.
+    std::uint64_t lastTime = 0;
+    //! A bit mask of the severities in the block. Bit \p n is set if the
+    //! block contains a record with the severity \p n.
+    std::uint8_t severities = 0;
+};
+
+//! \brief A filter for log records.
+//!
+//! A record passes the filter if its time lies in the closed interval
+//! [beginTime, endTime] and if the bit for its severity is set in the
+//! severity mask. The default filter passes all records.
+struct RecordFilter
+{
+    std::uint64_t beginTime = 0;
+    std::uint64_t endTime = std::numeric_limits<std::uint64_t>::max();
+    std::uint8_t severities = 0xFF;
+
+    //! Returns a severity mask, which contains \p severity and all higher
+    //! severities.
+    static
+    std::uint8_t atLeast(Severity severity) noexcept
+    {
+        return std::uint8_t(0xFF << static_cast<unsigned>(severity));
+    }
+
+    //! Checks if a record with the given \p severity and \p time passes the
+    //! filter.
+    bool matches(Severity severity, std::uint64_t time) const noexcept
+    {
+        return (severities & (1u << static_cast<unsigned>(severity))) != 0
+               && time >= beginTime && time <= endTime;
+    }
+
+    //! Checks if the \p block may contain records which pass the filter.
+    bool matches(const BlockInfo& block) const noexcept
+    {
+        return (severities & block.severities) != 0
+               && block.firstTime <= endTime && block.lastTime >= beginTime;
+    }
+};
+
+//! \brief The encoding of a block index.
+//!
+//! A block index is a sequence of fixed-size entries, one per block, which
+//! is preceded by the magic bytes. All numbers are stored in little-endian
+//! byte order.
+//! \code
+//! offset      8 bytes
+//! size        4 bytes
+//! numRecords  4 bytes
+//! firstTime   8 bytes
+//! lastTime    8 bytes
+//! severities  1 byte
+//! reserved    7 bytes (zero)
+//! \endcode
+struct BlockIndex
+{
+    //! The magic bytes at the start of an index.
+    static const std::uint8_t magic[8];
+
+    //! The size of an entry in bytes.
+    static constexpr std::size_t entrySize = 40;
+
+    //! Encodes the \p block into the \p buffer, which must have a size of
+    //! at least entrySize bytes.
+    static
+    void encode(const BlockInfo& block, std::uint8_t* buffer) noexcept;
+
+    //! Decodes a block from the \p buffer, which must have a size of
+    //! at least entrySize bytes.
+    static
+    BlockInfo decode(const std::uint8_t* buffer) noexcept;
+};
+
+} // namespace log11
+
+#endif // LOG11_BLOCKINDEX_HPP
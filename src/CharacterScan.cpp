@@ -0,0 +1,197 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "CharacterScan.hpp"
+
+#if defined(LOG11_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(LOG11_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <cstring>
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+// ----=====================================================================----
+//     Utilities
+// ----=====================================================================----
+
+#if defined(LOG11_HAVE_SSE2) || defined(LOG11_HAVE_AVX2)
+static inline
+unsigned countTrailingZeros(unsigned mask) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+static inline
+bool isJsonSpecialCharacter(unsigned char ch) noexcept
+{
+    return ch < 0x20 || ch == '"' || ch == '\\';
+}
+
+// ----=====================================================================----
+//     Character search
+// ----=====================================================================----
+
+const char* findCharacter(const char* begin, const char* end,
+                          char ch) noexcept
+{
+#if defined(LOG11_HAVE_AVX2)
+    const __m256i needle32 = _mm256_set1_epi8(ch);
+    while (end - begin >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(
+                            reinterpret_cast<const __m256i*>(begin));
+        unsigned mask = _mm256_movemask_epi8(
+                            _mm256_cmpeq_epi8(chunk, needle32));
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 32;
+    }
+#endif // LOG11_HAVE_AVX2
+
+#if defined(LOG11_HAVE_SSE2)
+    const __m128i needle = _mm_set1_epi8(ch);
+    while (end - begin >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 16;
+    }
+
+    for (; begin != end; ++begin)
+    {
+        if (*begin == ch)
+            break;
+    }
+    return begin;
+#else
+    // Without SIMD support, rely on the (usually optimized) C library.
+    if (begin == end)
+        return end;
+    const void* found = std::memchr(begin, ch, end - begin);
+    return found ? static_cast<const char*>(found) : end;
+#endif // LOG11_HAVE_SSE2
+}
+
+// ----=====================================================================----
+//     JSON escaping
+// ----=====================================================================----
+
+const char* findJsonSpecialCharacter(const char* begin,
+                                     const char* end) noexcept
+{
+#if defined(LOG11_HAVE_AVX2)
+    const __m256i quotes32 = _mm256_set1_epi8('"');
+    const __m256i backslashes32 = _mm256_set1_epi8('\\');
+    const __m256i controls32 = _mm256_set1_epi8(0x1F);
+    while (end - begin >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(
+                            reinterpret_cast<const __m256i*>(begin));
+        // A character is a control character if min(ch, 0x1F) == ch.
+        __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quotes32),
+                                _mm256_cmpeq_epi8(chunk, backslashes32)),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(chunk, controls32), chunk));
+        unsigned mask = _mm256_movemask_epi8(special);
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 32;
+    }
+#endif // LOG11_HAVE_AVX2
+
+#if defined(LOG11_HAVE_SSE2)
+    const __m128i quotes = _mm_set1_epi8('"');
+    const __m128i backslashes = _mm_set1_epi8('\\');
+    const __m128i controls = _mm_set1_epi8(0x1F);
+    while (end - begin >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(chunk, quotes),
+                             _mm_cmpeq_epi8(chunk, backslashes)),
+                _mm_cmpeq_epi8(_mm_min_epu8(chunk, controls), chunk));
+        unsigned mask = _mm_movemask_epi8(special);
+        if (mask)
+            return begin + countTrailingZeros(mask);
+        begin += 16;
+    }
+#endif // LOG11_HAVE_SSE2
+
+    for (; begin != end; ++begin)
+    {
+        if (isJsonSpecialCharacter(*begin))
+            break;
+    }
+    return begin;
+}
+
+unsigned escapeJsonCharacter(char ch, char* dest) noexcept
+{
+    static const char hex_digits[] = "0123456789abcdef";
+
+    dest[0] = '\\';
+    switch (ch)
+    {
+    case '"':  dest[1] = '"'; return 2;
+    case '\\': dest[1] = '\\'; return 2;
+    case '\n': dest[1] = 'n'; return 2;
+    case '\r': dest[1] = 'r'; return 2;
+    case '\t': dest[1] = 't'; return 2;
+    default:
+        dest[1] = 'u';
+        dest[2] = '0';
+        dest[3] = '0';
+        dest[4] = hex_digits[static_cast<unsigned char>(ch) >> 4];
+        dest[5] = hex_digits[static_cast<unsigned char>(ch) & 0xF];
+        return 6;
+    }
+}
+
+} // namespace log11_detail
+} // namespace log11
@@ -0,0 +1,61 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_CHARACTERSCAN_HPP
+#define LOG11_CHARACTERSCAN_HPP
+
+#include "Config.hpp"
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+//! Returns a pointer to the first occurrence of the character \p ch in the
+//! range <tt>[begin, end)</tt>. If there is no such character, \p end is
+//! returned.
+const char* findCharacter(const char* begin, const char* end,
+                          char ch) noexcept;
+
+//! Returns a pointer to the first character in the range <tt>[begin, end)</tt>
+//! which has to be escaped in a JSON string, i.e. a quote, a backslash or a
+//! control character. If there is no such character, \p end is returned.
+const char* findJsonSpecialCharacter(const char* begin,
+                                     const char* end) noexcept;
+
+//! Writes the JSON escape sequence for the character \p ch to \p dest,
+//! which must be able to hold at least 6 characters. Returns the length of
+//! the escape sequence.
+unsigned escapeJsonCharacter(char ch, char* dest) noexcept;
+
+} // namespace log11_detail
+} // namespace log11
+
+#endif // LOG11_CHARACTERSCAN_HPP
@@ -62,5 +62,26 @@
     #define LOG11_EXCEPTION(x)   x
 #endif // LOG11_USE_WEOS
 
+// ----=====================================================================----
+//     SIMD
+// ----=====================================================================----
+
+#if !defined(LOG11_DISABLE_SIMD)
+    #if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define LOG11_HAVE_SSE2
+    #endif
+    #if defined(__AVX2__)
+        #define LOG11_HAVE_AVX2
+    #endif
+#endif // LOG11_DISABLE_SIMD
+
+// ----=====================================================================----
+//     Format cache
+// ----=====================================================================----
+
+#if !defined(LOG11_FORMAT_CACHE_SIZE)
+    #define LOG11_FORMAT_CACHE_SIZE   64
+#endif // LOG11_FORMAT_CACHE_SIZE
+
 #endif // LOG11_CONFIG_HPP
 
@@ -0,0 +1,288 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "DeferredLogScope.hpp"
+
+#include <memory>
+
+using namespace std;
+
+
+namespace log11
+{
+
+using namespace log11_detail;
+
+namespace
+{
+
+//! An arena, which is kept for the next scope of the thread.
+thread_local unique_ptr<RingBuffer> cachedArena;
+
+} // anonymous namespace
+
+// ----=====================================================================----
+//     DeferredLogScope
+// ----=====================================================================----
+
+DeferredLogScope::DeferredLogScope(LogCore* core, size_t size,
+                                   LogCore::ClaimPolicy policy)
+    : m_core(core),
+      m_arena(acquireArena(size)),
+      m_policy(policy),
+      m_hasFailed(false),
+      m_numDropped{}
+{
+}
+
+DeferredLogScope::DeferredLogScope(DeferredLogScope&& other) noexcept
+    : m_core(other.m_core),
+      m_arena(other.m_arena),
+      m_policy(other.m_policy),
+      m_hasFailed(other.m_hasFailed)
+{
+    for (unsigned idx = 0; idx < LogStatistics::numSeverities; ++idx)
+        m_numDropped[idx] = other.m_numDropped[idx];
+    other.m_core = nullptr;
+    other.m_arena = nullptr;
+}
+
+DeferredLogScope& DeferredLogScope::operator=(DeferredLogScope&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_hasFailed)
+            flush();
+        else
+            discard();
+
+        m_core = other.m_core;
+        m_arena = other.m_arena;
+        m_policy = other.m_policy;
+        m_hasFailed = other.m_hasFailed;
+        for (unsigned idx = 0; idx < LogStatistics::numSeverities; ++idx)
+            m_numDropped[idx] = other.m_numDropped[idx];
+        other.m_core = nullptr;
+        other.m_arena = nullptr;
+    }
+    return *this;
+}
+
+DeferredLogScope::~DeferredLogScope()
+{
+    if (m_hasFailed)
+        flush();
+    else
+        discard();
+}
+
+void DeferredLogScope::fail() noexcept
+{
+    m_hasFailed = true;
+}
+
+bool DeferredLogScope::hasFailed() const noexcept
+{
+    return m_hasFailed;
+}
+
+void DeferredLogScope::discard()
+{
+    if (!m_core)
+        return;
+
+    // Rewinding the arena only moves its read position.
+    while (m_arena->occupancy())
+        m_arena->consume(m_arena->wait());
+    releaseArena();
+    m_core = nullptr;
+}
+
+void DeferredLogScope::flush()
+{
+    if (!m_core)
+        return;
+
+    // A batch must leave the space reserved for the higher severities.
+    auto& fifo = m_core->m_messageFifo;
+    unsigned headroom = m_core->headroom(Severity::Trace);
+    unsigned maxBatchSize = fifo.maxClaimSize() > headroom
+                            ? fifo.maxClaimSize() - headroom : 0;
+
+    while (m_arena->occupancy())
+    {
+        // Collect the records, which fit into one claim.
+        auto first = m_arena->wait();
+        auto block = first;
+        unsigned numRecords = 0;
+        unsigned batchSize = 0;
+        Severity severity = Severity::Trace;
+        for (;;)
+        {
+            if (numRecords && batchSize + block.size() > maxBatchSize)
+                break;
+            Directive directive;
+            if (   block.stream(*m_arena).read(&directive, 1)
+                && directive.severityOrCommand > static_cast<unsigned>(severity))
+            {
+                severity = static_cast<Severity>(directive.severityOrCommand);
+            }
+            ++numRecords;
+            batchSize += block.size();
+            if (batchSize == m_arena->occupancy())
+                break;
+            block = m_arena->next(block);
+        }
+
+        // A single record may have to be truncated.
+        if (numRecords == 1)
+        {
+            publish(first);
+            m_arena->consume(first);
+        }
+        else
+        {
+            publishBatch(numRecords, batchSize, severity);
+        }
+    }
+    releaseArena();
+
+    // Report the records, which have been evicted from the arena.
+    for (unsigned idx = 0; idx < LogStatistics::numSeverities; ++idx)
+    {
+        if (m_numDropped[idx])
+        {
+            m_core->m_statistics.countDropped(static_cast<Severity>(idx),
+                                              m_numDropped[idx]);
+        }
+    }
+    m_core = nullptr;
+}
+
+void DeferredLogScope::publish(RingBuffer::Block block)
+{
+    auto inStream = block.stream(*m_arena);
+    Directive directive;
+    if (!inStream.read(&directive, 1))
+        return;
+
+    auto severity = static_cast<Severity>(directive.severityOrCommand);
+    auto claimed = m_core->claim(m_policy, severity,
+                                 block.length() - LogCore::headerSize);
+    if (claimed.length() == 0)
+        return;
+
+    // Copy the serialized record. The time in its header is kept. The
+    // record is truncated if the claim is shorter than the record.
+    auto outStream = claimed.stream(m_core->m_messageFifo);
+    outStream.write(Directive::entry(
+                        severity,
+                        directive.isTruncated || claimed.length() < block.length()));
+    SplitStringView view;
+    inStream.readString(view, block.length());
+    outStream.writeString(view.begin1, view.length1);
+    outStream.writeString(view.begin2, view.length2);
+
+    if (m_policy == LogCore::Block || m_policy == LogCore::BlockUntil)
+        m_core->m_messageFifo.publish(claimed);
+    else
+        m_core->m_messageFifo.tryPublish(claimed);
+}
+
+void DeferredLogScope::publishBatch(unsigned numRecords, unsigned size,
+                                    Severity severity)
+{
+    // The claim adds the header of a single block.
+    auto first = m_arena->wait();
+    auto claimed = m_core->claimBatch(m_policy, severity,
+                                      size - (first.size() - first.length()));
+
+    auto rest = claimed;
+    for (unsigned idx = 0; idx < numRecords; ++idx)
+    {
+        auto block = m_arena->wait();
+        auto inStream = block.stream(*m_arena);
+        Directive directive;
+        inStream.read(&directive, 1);
+        auto recordSeverity = static_cast<Severity>(directive.severityOrCommand);
+        if (claimed.length() == 0)
+        {
+            m_core->m_statistics.countDropped(recordSeverity);
+            m_arena->consume(block);
+            continue;
+        }
+
+        // The record is copied as it is, including its directive and the
+        // time in its header.
+        auto part = m_core->m_messageFifo.split(rest, block.length());
+        auto outStream = part.stream(m_core->m_messageFifo);
+        outStream.write(directive);
+        SplitStringView view;
+        inStream.readString(view, block.length());
+        outStream.writeString(view.begin1, view.length1);
+        outStream.writeString(view.begin2, view.length2);
+        m_core->m_statistics.countRecord(recordSeverity, block.length(),
+                                         directive.isTruncated);
+        m_arena->consume(block);
+    }
+    if (claimed.length() == 0)
+        return;
+
+    if (m_policy == LogCore::Block || m_policy == LogCore::BlockUntil)
+        m_core->m_messageFifo.publish(claimed);
+    else
+        m_core->m_messageFifo.tryPublish(claimed);
+}
+
+void DeferredLogScope::evictOldestRecord() noexcept
+{
+    auto block = m_arena->wait();
+    Directive directive;
+    if (block.stream(*m_arena).read(&directive, 1))
+        ++m_numDropped[directive.severityOrCommand];
+    m_arena->consume(block);
+}
+
+void DeferredLogScope::releaseArena() noexcept
+{
+    if (!cachedArena || cachedArena->size() < m_arena->size())
+        cachedArena.reset(m_arena);
+    else
+        delete m_arena;
+    m_arena = nullptr;
+}
+
+RingBuffer* DeferredLogScope::acquireArena(size_t size)
+{
+    if (cachedArena && cachedArena->size() >= size)
+        return cachedArena.release();
+    return new RingBuffer(size);
+}
+
+} // namespace log11
@@ -0,0 +1,225 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_DEFERREDLOGSCOPE_HPP
+#define LOG11_DEFERREDLOGSCOPE_HPP
+
+#include "LogCore.hpp"
+#include "RingBuffer.hpp"
+#include "Serdes.hpp"
+#include "Severity.hpp"
+#include "Utility.hpp"
+
+#include <cstddef>
+
+
+namespace log11
+{
+
+//! \brief A scope whose records are only logged if it fails.
+//!
+//! A DeferredLogScope collects the records of a unit of work, e.g. a
+//! request, in a private arena instead of passing them to the log core.
+//! The records are serialized immediately but they are neither published
+//! nor formatted. If the scope is marked as failed with fail(), its records
+//! are passed to the log core when the scope ends. Otherwise, they are
+//! dropped by rewinding the arena, which costs the consumer nothing.
+//! \code
+//! DeferredLogScope scope = log.deferredScope(8192);
+//! scope.debug("Request {} from {}", id, peer);
+//! if (!process(request))
+//!     scope.fail();
+//! \endcode
+//!
+//! The arena is taken from a per-thread cache, so a scope usually does not
+//! allocate memory. When the arena is full, the oldest records are dropped
+//! to make room for new ones, so the records leading to a failure are kept.
+//! The dropped records are reported as drops if the scope fails. The records
+//! keep the time at which they have been created.
+class DeferredLogScope
+{
+public:
+    //! \brief Creates a deferred scope.
+    //!
+    //! Creates a scope for the log \p core with an arena of at least \p size
+    //! bytes. When the scope fails, its records are passed to the core with
+    //! the given claim \p policy.
+    explicit
+    DeferredLogScope(LogCore* core, std::size_t size,
+                     LogCore::ClaimPolicy policy = LogCore::Block);
+
+    DeferredLogScope(DeferredLogScope&& other) noexcept;
+    DeferredLogScope& operator=(DeferredLogScope&& other) noexcept;
+
+    DeferredLogScope(const DeferredLogScope&) = delete;
+    DeferredLogScope& operator=(const DeferredLogScope&) = delete;
+
+    //! \brief Destroys the scope.
+    //!
+    //! Flushes the records if the scope has failed and discards them
+    //! otherwise.
+    ~DeferredLogScope();
+
+    //! \brief Marks the scope as failed.
+    void fail() noexcept;
+
+    //! \brief Checks if the scope has failed.
+    bool hasFailed() const noexcept;
+
+    //! \brief Discards the records.
+    //!
+    //! Drops all records and closes the scope, so that no more records can
+    //! be added.
+    void discard();
+
+    //! \brief Flushes the records.
+    //!
+    //! Passes all records to the log core, whether the scope has failed or
+    //! not, and closes the scope. The records are claimed in as few batches
+    //! as the ring buffer of the core permits, usually in a single one, so
+    //! that records of other threads do not interleave with them.
+    void flush();
+
+    //! \brief Adds a record.
+    //!
+    //! Adds a record with the given \p severity, which is created by
+    //! interpolating the \p message with the \p args.
+    template <typename... TArgs>
+    void log(Severity severity, const char* message, TArgs&&... args)
+    {
+        if (m_core)
+        {
+            add(severity, log11_detail::makeFormatTuple(
+                              message, log11_detail::decayArgument(args)...));
+        }
+    }
+
+    //! \brief A convenience function for trace records.
+    template <typename... TArgs>
+    void trace(const char* message, TArgs&&... args)
+    {
+        this->log(Severity::Trace, message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for debug records.
+    template <typename... TArgs>
+    void debug(const char* message, TArgs&&... args)
+    {
+        this->log(Severity::Debug, message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for info records.
+    template <typename... TArgs>
+    void info(const char* message, TArgs&&... args)
+    {
+        this->log(Severity::Info, message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for warning records.
+    template <typename... TArgs>
+    void warn(const char* message, TArgs&&... args)
+    {
+        this->log(Severity::Warn, message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for error records.
+    template <typename... TArgs>
+    void error(const char* message, TArgs&&... args)
+    {
+        this->log(Severity::Error, message, std::forward<TArgs>(args)...);
+    }
+
+private:
+    LogCore* m_core;
+    RingBuffer* m_arena;
+    LogCore::ClaimPolicy m_policy;
+    bool m_hasFailed;
+    //! The number of records per severity, which have been evicted from
+    //! the arena.
+    unsigned m_numDropped[LogStatistics::numSeverities];
+
+
+    //! Serializes a record with the given \p severity into the arena.
+    template <typename TArg>
+    void add(Severity severity, TArg&& arg);
+
+    //! Passes the record in the arena \p block to the log core.
+    void publish(RingBuffer::Block block);
+
+    //! Passes the next \p numRecords records in the arena, which occupy
+    //! \p size elements, to the log core with a single claim. The highest
+    //! severity of the records is \p severity.
+    void publishBatch(unsigned numRecords, unsigned size, Severity severity);
+
+    //! Drops the oldest record in the arena to make room for a new one.
+    void evictOldestRecord() noexcept;
+
+    //! Returns the arena to the per-thread cache.
+    void releaseArena() noexcept;
+
+    static
+    RingBuffer* acquireArena(std::size_t size);
+};
+
+template <typename TArg>
+void DeferredLogScope::add(Severity severity, TArg&& arg)
+{
+    using namespace std;
+    using namespace log11_detail;
+
+    // We cannot rely on the serdes options if a change is going on.
+    if (m_core->m_crossThreadChangeOngoing)
+    {
+        m_core->m_crossThreadChangeDone.expect(
+                    m_core->m_crossThreadChangeOngoing, false);
+    }
+
+    size_t totalSize = SerdesVisitor::requiredSize(m_core->m_serdesOptions, arg)
+                       + LogCore::headerSize;
+
+    // A record which is larger than the arena is truncated.
+    unsigned size = totalSize + 4 <= m_arena->size() ? totalSize
+                                                     : m_arena->size() - 4;
+    auto claimed = m_arena->tryClaim(size, size);
+    while (claimed.length() == 0)
+    {
+        evictOldestRecord();
+        claimed = m_arena->tryClaim(size, size);
+    }
+
+    auto stream = claimed.stream(*m_arena);
+    LogCore::writeRecordHeader(
+                stream, Directive::entry(severity, size < totalSize));
+    SerdesVisitor::serialize(m_core->m_serdesOptions, stream, arg);
+    m_arena->publish(claimed);
+}
+
+} // namespace log11
+
+#endif // LOG11_DEFERREDLOGSCOPE_HPP
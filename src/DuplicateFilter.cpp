@@ -0,0 +1,154 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "DuplicateFilter.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+DuplicateFilter::DuplicateFilter() noexcept
+    : m_numPendingRuns(0),
+      m_useCounter(0),
+      m_severity(Severity::Trace),
+      m_length(0)
+{
+    clear();
+}
+
+bool DuplicateFilter::isRepeat(Severity severity, time_point time,
+                               RingBuffer::Stream stream) noexcept
+{
+    m_severity = severity;
+    m_length = stream.length();
+    if (m_length == 0 || m_length > maxArgumentSize)
+    {
+        m_length = 0;
+        return false;
+    }
+    stream.read(m_arguments, m_length);
+
+    for (auto& entry : m_entries)
+    {
+        if (   entry.length == m_length && entry.severity == severity
+            && memcmp(entry.arguments, m_arguments, m_length) == 0)
+        {
+            entry.lastUse = ++m_useCounter;
+            if (entry.run.numRepeats++ == 0)
+            {
+                entry.run.firstTime = time;
+                ++m_numPendingRuns;
+            }
+            entry.run.lastTime = time;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DuplicateFilter::remember(uint64_t sequence, Run& evicted) noexcept
+{
+    if (m_length == 0)
+        return false;
+
+    Entry* victim = &m_entries[0];
+    for (auto& entry : m_entries)
+    {
+        if (entry.lastUse < victim->lastUse)
+            victim = &entry;
+    }
+
+    bool hasEvicted = false;
+    if (victim->run.numRepeats)
+    {
+        evicted = victim->run;
+        --m_numPendingRuns;
+        hasEvicted = true;
+    }
+
+    victim->severity = m_severity;
+    victim->length = m_length;
+    victim->lastUse = ++m_useCounter;
+    victim->run.severity = m_severity;
+    victim->run.sequence = sequence;
+    victim->run.numRepeats = 0;
+    memcpy(victim->arguments, m_arguments, m_length);
+    m_length = 0;
+    return hasEvicted;
+}
+
+bool DuplicateFilter::takeRun(time_point dueTime, Run& run) noexcept
+{
+    if (m_numPendingRuns == 0)
+        return false;
+
+    for (auto& entry : m_entries)
+    {
+        if (entry.run.numRepeats && entry.run.firstTime <= dueTime)
+        {
+            run = entry.run;
+            entry.run.numRepeats = 0;
+            --m_numPendingRuns;
+            return true;
+        }
+    }
+    return false;
+}
+
+auto DuplicateFilter::firstRepeatTime() const noexcept -> time_point
+{
+    auto firstTime = time_point::max();
+    for (const auto& entry : m_entries)
+    {
+        if (entry.run.numRepeats && entry.run.firstTime < firstTime)
+            firstTime = entry.run.firstTime;
+    }
+    return firstTime;
+}
+
+void DuplicateFilter::clear() noexcept
+{
+    for (auto& entry : m_entries)
+    {
+        entry.length = 0;
+        entry.lastUse = 0;
+        entry.run.numRepeats = 0;
+    }
+    m_numPendingRuns = 0;
+    m_length = 0;
+}
+
+} // namespace log11_detail
+} // namespace log11
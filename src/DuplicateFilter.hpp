@@ -0,0 +1,148 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_DUPLICATEFILTER_HPP
+#define LOG11_DUPLICATEFILTER_HPP
+
+#include "RingBuffer.hpp"
+#include "Severity.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+//! \brief Detects repeated records.
+//!
+//! The filter remembers the serialized arguments of the last few distinct
+//! records. A record, whose severity and arguments are equal byte by byte
+//! to a remembered one, is a repeat. Since the arguments start with the
+//! serializers and the format string (or a pointer to it, if it is
+//! immutable), only records from the same call site with the same
+//! arguments can be repeats. The repeats are counted instead of being
+//! written and reported as runs.
+class DuplicateFilter
+{
+public:
+    using time_point = std::chrono::high_resolution_clock::time_point;
+
+    //! The number of remembered records.
+    static constexpr unsigned numEntries = 4;
+    //! Records with larger arguments are never considered as repeats.
+    static constexpr unsigned maxArgumentSize = 256;
+
+    //! The repeats of a record.
+    struct Run
+    {
+        //! The severity of the record.
+        Severity severity;
+        //! The sequence number of the record, which has been written.
+        std::uint64_t sequence;
+        //! The number of repeats.
+        std::uint64_t numRepeats;
+        //! The time of the first repeat.
+        time_point firstTime;
+        //! The time of the last repeat.
+        time_point lastTime;
+    };
+
+    DuplicateFilter() noexcept;
+
+    DuplicateFilter(const DuplicateFilter&) = delete;
+    DuplicateFilter& operator=(const DuplicateFilter&) = delete;
+
+    //! Checks if a record with the \p severity and the \p time, whose
+    //! arguments are in the \p stream, repeats a remembered record. If so,
+    //! the repeat is counted and \p true is returned.
+    bool isRepeat(Severity severity, time_point time,
+                  RingBuffer::Stream stream) noexcept;
+
+    //! Remembers the record, which has been passed to the last call of
+    //! isRepeat(), under the \p sequence number. The least recently used
+    //! record is forgotten. If it has repeats, which have not been
+    //! reported, its run is stored in \p evicted and \p true is returned.
+    //! Must only be called if isRepeat() has returned \p false.
+    bool remember(std::uint64_t sequence, Run& evicted) noexcept;
+
+    //! Returns \p true if there are repeats, which have not been reported.
+    bool hasRepeats() const noexcept
+    {
+        return m_numPendingRuns != 0;
+    }
+
+    //! Takes a run, whose first repeat has happened at or before
+    //! \p dueTime, and stores it in \p run. The record is still remembered,
+    //! so later repeats start a new run. Returns \p false if there is no
+    //! such run.
+    bool takeRun(time_point dueTime, Run& run) noexcept;
+
+    //! Returns the time of the earliest first repeat of all runs, which
+    //! have not been reported. Must only be called if hasRepeats() returns
+    //! \p true.
+    time_point firstRepeatTime() const noexcept;
+
+    //! Forgets all records.
+    void clear() noexcept;
+
+private:
+    struct Entry
+    {
+        //! The severity of the record.
+        Severity severity;
+        //! The size of the arguments or zero, if the entry is unused.
+        unsigned length;
+        //! Used to find the least recently used entry.
+        std::uint64_t lastUse;
+        //! The pending repeats.
+        Run run;
+        //! The serialized arguments.
+        RingBuffer::byte arguments[maxArgumentSize];
+    };
+
+    //! The remembered records.
+    Entry m_entries[numEntries];
+    //! The number of entries with pending repeats.
+    unsigned m_numPendingRuns;
+    //! Incremented whenever an entry is used.
+    std::uint64_t m_useCounter;
+
+    //! The record passed to isRepeat().
+    Severity m_severity;
+    unsigned m_length;
+    RingBuffer::byte m_arguments[maxArgumentSize];
+};
+
+} // namespace log11_detail
+} // namespace log11
+
+#endif // LOG11_DUPLICATEFILTER_HPP
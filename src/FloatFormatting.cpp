@@ -0,0 +1,1064 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "FloatFormatting.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+namespace
+{
+
+// The double-to-string conversion uses the Grisu3 algorithm and its variant
+// for a fixed number of digits as described in
+//   Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+//   with Integers", PLDI 2010.
+// Grisu3 detects the (rare) cases, in which it cannot guarantee a correct
+// result. Then the conversion falls back to an exact algorithm using big
+// integers (Steele & White, Burger & Dybvig). The bignum algorithm is also
+// used for long doubles.
+
+// ----=====================================================================----
+//     DiyFp
+// ----=====================================================================----
+
+//! A do-it-yourself floating-point number f * 2^e.
+struct DiyFp
+{
+    uint64_t f;
+    int e;
+};
+
+DiyFp normalize(DiyFp x) noexcept
+{
+    while ((x.f & (uint64_t(1) << 63)) == 0)
+    {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+//! Multiplies \p a by \p b. The result is rounded.
+DiyFp multiply(DiyFp a, DiyFp b) noexcept
+{
+    const uint64_t mask = 0xFFFFFFFF;
+    uint64_t ah = a.f >> 32, al = a.f & mask;
+    uint64_t bh = b.f >> 32, bl = b.f & mask;
+    uint64_t hh = ah * bh;
+    uint64_t hl = ah * bl;
+    uint64_t lh = al * bh;
+    uint64_t ll = al * bl;
+    uint64_t temp = (ll >> 32) + (hl & mask) + (lh & mask);
+    temp += uint64_t(1) << 31; // round
+    return DiyFp{hh + (hl >> 32) + (lh >> 32) + (temp >> 32), a.e + b.e + 64};
+}
+
+//! The significand and the exponent of a double or a float. Only finite,
+//! positive values are supported.
+template <typename T>
+struct Ieee;
+
+template <>
+struct Ieee<double>
+{
+    static DiyFp decompose(double value) noexcept
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint64_t significand = bits & ((uint64_t(1) << 52) - 1);
+        int biasedExponent = int(bits >> 52) & 0x7FF;
+        if (biasedExponent)
+            return DiyFp{significand | (uint64_t(1) << 52),
+                         biasedExponent - 1075};
+        else
+            return DiyFp{significand, -1074};
+    }
+
+    static bool isLowerBoundaryCloser(double value) noexcept
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & ((uint64_t(1) << 52) - 1)) == 0 && (bits >> 52) > 1;
+    }
+};
+
+template <>
+struct Ieee<float>
+{
+    static DiyFp decompose(float value) noexcept
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t significand = bits & ((uint32_t(1) << 23) - 1);
+        int biasedExponent = int(bits >> 23) & 0xFF;
+        if (biasedExponent)
+            return DiyFp{significand | (uint32_t(1) << 23),
+                         biasedExponent - 150};
+        else
+            return DiyFp{significand, -149};
+    }
+
+    static bool isLowerBoundaryCloser(float value) noexcept
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return (bits & ((uint32_t(1) << 23) - 1)) == 0 && (bits >> 23) > 1;
+    }
+};
+
+//! Computes the normalized boundaries m- and m+ of a \p value. Every number
+//! in the open interval (m-, m+) is rounded to \p value.
+template <typename T>
+void boundaries(T value, DiyFp& minus, DiyFp& plus) noexcept
+{
+    DiyFp v = Ieee<T>::decompose(value);
+    plus = normalize(DiyFp{(v.f << 1) + 1, v.e - 1});
+    if (Ieee<T>::isLowerBoundaryCloser(value))
+        minus = DiyFp{(v.f << 2) - 1, v.e - 2};
+    else
+        minus = DiyFp{(v.f << 1) - 1, v.e - 1};
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+}
+
+// ----=====================================================================----
+//     Cached powers of ten
+// ----=====================================================================----
+
+struct CachedPower
+{
+    uint64_t significand;
+    int16_t binaryExponent;
+    int16_t decimalExponent;
+};
+
+// The normalized and rounded powers 10^k for k = -348, -340, ..., 340.
+const CachedPower cachedPowers[] = {
+    {0xfa8fd5a0081c0288, -1220, -348},
+    {0xbaaee17fa23ebf76, -1193, -340},
+    {0x8b16fb203055ac76, -1166, -332},
+    {0xcf42894a5dce35ea, -1140, -324},
+    {0x9a6bb0aa55653b2d, -1113, -316},
+    {0xe61acf033d1a45df, -1087, -308},
+    {0xab70fe17c79ac6ca, -1060, -300},
+    {0xff77b1fcbebcdc4f, -1034, -292},
+    {0xbe5691ef416bd60c, -1007, -284},
+    {0x8dd01fad907ffc3c,  -980, -276},
+    {0xd3515c2831559a83,  -954, -268},
+    {0x9d71ac8fada6c9b5,  -927, -260},
+    {0xea9c227723ee8bcb,  -901, -252},
+    {0xaecc49914078536d,  -874, -244},
+    {0x823c12795db6ce57,  -847, -236},
+    {0xc21094364dfb5637,  -821, -228},
+    {0x9096ea6f3848984f,  -794, -220},
+    {0xd77485cb25823ac7,  -768, -212},
+    {0xa086cfcd97bf97f4,  -741, -204},
+    {0xef340a98172aace5,  -715, -196},
+    {0xb23867fb2a35b28e,  -688, -188},
+    {0x84c8d4dfd2c63f3b,  -661, -180},
+    {0xc5dd44271ad3cdba,  -635, -172},
+    {0x936b9fcebb25c996,  -608, -164},
+    {0xdbac6c247d62a584,  -582, -156},
+    {0xa3ab66580d5fdaf6,  -555, -148},
+    {0xf3e2f893dec3f126,  -529, -140},
+    {0xb5b5ada8aaff80b8,  -502, -132},
+    {0x87625f056c7c4a8b,  -475, -124},
+    {0xc9bcff6034c13053,  -449, -116},
+    {0x964e858c91ba2655,  -422, -108},
+    {0xdff9772470297ebd,  -396, -100},
+    {0xa6dfbd9fb8e5b88f,  -369,  -92},
+    {0xf8a95fcf88747d94,  -343,  -84},
+    {0xb94470938fa89bcf,  -316,  -76},
+    {0x8a08f0f8bf0f156b,  -289,  -68},
+    {0xcdb02555653131b6,  -263,  -60},
+    {0x993fe2c6d07b7fac,  -236,  -52},
+    {0xe45c10c42a2b3b06,  -210,  -44},
+    {0xaa242499697392d3,  -183,  -36},
+    {0xfd87b5f28300ca0e,  -157,  -28},
+    {0xbce5086492111aeb,  -130,  -20},
+    {0x8cbccc096f5088cc,  -103,  -12},
+    {0xd1b71758e219652c,   -77,   -4},
+    {0x9c40000000000000,   -50,    4},
+    {0xe8d4a51000000000,   -24,   12},
+    {0xad78ebc5ac620000,     3,   20},
+    {0x813f3978f8940984,    30,   28},
+    {0xc097ce7bc90715b3,    56,   36},
+    {0x8f7e32ce7bea5c70,    83,   44},
+    {0xd5d238a4abe98068,   109,   52},
+    {0x9f4f2726179a2245,   136,   60},
+    {0xed63a231d4c4fb27,   162,   68},
+    {0xb0de65388cc8ada8,   189,   76},
+    {0x83c7088e1aab65db,   216,   84},
+    {0xc45d1df942711d9a,   242,   92},
+    {0x924d692ca61be758,   269,  100},
+    {0xda01ee641a708dea,   295,  108},
+    {0xa26da3999aef774a,   322,  116},
+    {0xf209787bb47d6b85,   348,  124},
+    {0xb454e4a179dd1877,   375,  132},
+    {0x865b86925b9bc5c2,   402,  140},
+    {0xc83553c5c8965d3d,   428,  148},
+    {0x952ab45cfa97a0b3,   455,  156},
+    {0xde469fbd99a05fe3,   481,  164},
+    {0xa59bc234db398c25,   508,  172},
+    {0xf6c69a72a3989f5c,   534,  180},
+    {0xb7dcbf5354e9bece,   561,  188},
+    {0x88fcf317f22241e2,   588,  196},
+    {0xcc20ce9bd35c78a5,   614,  204},
+    {0x98165af37b2153df,   641,  212},
+    {0xe2a0b5dc971f303a,   667,  220},
+    {0xa8d9d1535ce3b396,   694,  228},
+    {0xfb9b7cd9a4a7443c,   720,  236},
+    {0xbb764c4ca7a44410,   747,  244},
+    {0x8bab8eefb6409c1a,   774,  252},
+    {0xd01fef10a657842c,   800,  260},
+    {0x9b10a4e5e9913129,   827,  268},
+    {0xe7109bfba19c0c9d,   853,  276},
+    {0xac2820d9623bf429,   880,  284},
+    {0x80444b5e7aa7cf85,   907,  292},
+    {0xbf21e44003acdd2d,   933,  300},
+    {0x8e679c2f5e44ff8f,   960,  308},
+    {0xd433179d9c8cb841,   986,  316},
+    {0x9e19db92b4e31ba9,  1013,  324},
+    {0xeb96bf6ebadf77d9,  1039,  332},
+    {0xaf87023b9bf0ee6b,  1066,  340},
+};
+
+const int cachedPowersOffset = 348;
+const int cachedPowersDistance = 8;
+
+// The binary exponent of the scaled value is kept in this range.
+const int minTargetExponent = -60;
+const int maxTargetExponent = -32;
+
+//! Returns a cached power of ten 10^k, such that the exponent of the product
+//! with a normalized number with exponent \p e is in the range
+//! [minTargetExponent, maxTargetExponent].
+DiyFp cachedPowerFor(int e, int& k) noexcept
+{
+    int minExponent = minTargetExponent - (e + 64);
+    int approximation = int(ceil((minExponent + 63) * 0.30102999566398114));
+    int index = (cachedPowersOffset + approximation - 1) / cachedPowersDistance
+                + 1;
+    const CachedPower& power = cachedPowers[index];
+    k = power.decimalExponent;
+    return DiyFp{power.significand, power.binaryExponent};
+}
+
+//! Returns the biggest power of ten, which is less than or equal to
+//! \p number. The exponent plus one is stored in \p exponentPlusOne.
+uint32_t biggestPowerOfTen(uint32_t number, int& exponentPlusOne) noexcept
+{
+    static const uint32_t powers[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000
+    };
+
+    int exponent = 9;
+    while (exponent > 0 && number < powers[exponent])
+        --exponent;
+    exponentPlusOne = exponent + 1;
+    return powers[exponent];
+}
+
+// ----=====================================================================----
+//     Grisu3 (shortest)
+// ----=====================================================================----
+
+//! Adjusts the last digit of the \p buffer such that it is closest to w.
+//! Returns \p false, if the result is not guaranteed to be correct.
+bool roundWeed(char* buffer, int length, uint64_t distanceTooHighW,
+               uint64_t unsafeInterval, uint64_t rest, uint64_t tenKappa,
+               uint64_t unit) noexcept
+{
+    uint64_t smallDistance = distanceTooHighW - unit;
+    uint64_t bigDistance = distanceTooHighW + unit;
+
+    while (rest < smallDistance
+           && unsafeInterval - rest >= tenKappa
+           && (rest + tenKappa < smallDistance
+               || smallDistance - rest >= rest + tenKappa - smallDistance))
+    {
+        --buffer[length - 1];
+        rest += tenKappa;
+    }
+
+    if (rest < bigDistance
+        && unsafeInterval - rest >= tenKappa
+        && (rest + tenKappa < bigDistance
+            || bigDistance - rest > rest + tenKappa - bigDistance))
+    {
+        return false;
+    }
+
+    return 2 * unit <= rest && rest <= unsafeInterval - 4 * unit;
+}
+
+//! Generates the shortest digits of w, which lie within the boundaries
+//! \p low and \p high. All three numbers have to be scaled to the same
+//! exponent, which is in the target range.
+bool generateShortestDigits(DiyFp low, DiyFp w, DiyFp high,
+                            char* buffer, int& length, int& kappa) noexcept
+{
+    uint64_t unit = 1;
+    DiyFp tooLow{low.f - unit, low.e};
+    DiyFp tooHigh{high.f + unit, high.e};
+    uint64_t unsafeInterval = tooHigh.f - tooLow.f;
+    int shift = -w.e;
+    uint64_t one = uint64_t(1) << shift;
+
+    uint32_t integrals = uint32_t(tooHigh.f >> shift);
+    uint64_t fractionals = tooHigh.f & (one - 1);
+    uint32_t divisor = biggestPowerOfTen(integrals, kappa);
+    length = 0;
+
+    while (kappa > 0)
+    {
+        buffer[length++] = char('0' + integrals / divisor);
+        integrals %= divisor;
+        --kappa;
+        uint64_t rest = (uint64_t(integrals) << shift) + fractionals;
+        if (rest < unsafeInterval)
+        {
+            return roundWeed(buffer, length, tooHigh.f - w.f, unsafeInterval,
+                             rest, uint64_t(divisor) << shift, unit);
+        }
+        divisor /= 10;
+    }
+
+    for (;;)
+    {
+        fractionals *= 10;
+        unit *= 10;
+        unsafeInterval *= 10;
+        buffer[length++] = char('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        --kappa;
+        if (fractionals < unsafeInterval)
+        {
+            return roundWeed(buffer, length, (tooHigh.f - w.f) * unit,
+                             unsafeInterval, fractionals, one, unit);
+        }
+    }
+}
+
+template <typename T>
+bool grisuShortest(T value, char* buffer, int& length,
+                   int& decimalPoint) noexcept
+{
+    DiyFp minus, plus;
+    boundaries(value, minus, plus);
+    DiyFp w = normalize(Ieee<T>::decompose(value));
+
+    int mk;
+    DiyFp tenMk = cachedPowerFor(w.e, mk);
+    DiyFp scaledW = multiply(w, tenMk);
+    DiyFp scaledMinus = multiply(minus, tenMk);
+    DiyFp scaledPlus = multiply(plus, tenMk);
+
+    int kappa;
+    bool result = generateShortestDigits(scaledMinus, scaledW, scaledPlus,
+                                         buffer, length, kappa);
+    decimalPoint = length + kappa - mk;
+    return result;
+}
+
+// ----=====================================================================----
+//     Grisu3 (counted)
+// ----=====================================================================----
+
+//! Rounds the digits in the \p buffer with the given \p rest. Returns
+//! \p false, if the rounding direction cannot be determined.
+bool roundWeedCounted(char* buffer, int length, uint64_t rest,
+                      uint64_t tenKappa, uint64_t unit, int& kappa) noexcept
+{
+    if (unit >= tenKappa || tenKappa - unit <= unit)
+        return false;
+    if (tenKappa - rest > rest && tenKappa - 2 * rest >= 2 * unit)
+        return true;
+    if (rest > unit && tenKappa - (rest - unit) <= rest - unit)
+    {
+        ++buffer[length - 1];
+        for (int idx = length - 1; idx > 0; --idx)
+        {
+            if (buffer[idx] != '0' + 10)
+                break;
+            buffer[idx] = '0';
+            ++buffer[idx - 1];
+        }
+        if (buffer[0] == '0' + 10)
+        {
+            buffer[0] = '1';
+            ++kappa;
+        }
+        return true;
+    }
+    return false;
+}
+
+//! Generates digits of \p w. If \p numFractionalDigits is negative,
+//! \p numDigits significant digits are generated. Otherwise, the number of
+//! digits is chosen such that \p numFractionalDigits digits follow the
+//! decimal point.
+bool generateCountedDigits(DiyFp w, int mk, int numDigits,
+                           int numFractionalDigits,
+                           char* buffer, int& length, int& kappa) noexcept
+{
+    uint64_t error = 1;
+    int shift = -w.e;
+    uint64_t one = uint64_t(1) << shift;
+
+    uint32_t integrals = uint32_t(w.f >> shift);
+    uint64_t fractionals = w.f & (one - 1);
+    uint32_t divisor = biggestPowerOfTen(integrals, kappa);
+    if (numFractionalDigits >= 0)
+    {
+        numDigits = kappa - mk + numFractionalDigits;
+        if (numDigits <= 0)
+            return false;
+    }
+    length = 0;
+
+    while (kappa > 0)
+    {
+        buffer[length++] = char('0' + integrals / divisor);
+        integrals %= divisor;
+        --kappa;
+        if (--numDigits == 0)
+        {
+            uint64_t rest = (uint64_t(integrals) << shift) + fractionals;
+            return roundWeedCounted(buffer, length, rest,
+                                    uint64_t(divisor) << shift, error, kappa);
+        }
+        divisor /= 10;
+    }
+
+    while (numDigits > 0 && fractionals > error)
+    {
+        fractionals *= 10;
+        error *= 10;
+        buffer[length++] = char('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        --kappa;
+        --numDigits;
+    }
+    if (numDigits != 0)
+        return false;
+    return roundWeedCounted(buffer, length, fractionals, one, error, kappa);
+}
+
+bool grisuCounted(double value, int numDigits, int numFractionalDigits,
+                  char* buffer, int& length, int& decimalPoint) noexcept
+{
+    DiyFp w = normalize(Ieee<double>::decompose(value));
+    int mk;
+    DiyFp tenMk = cachedPowerFor(w.e, mk);
+    DiyFp scaledW = multiply(w, tenMk);
+
+    int kappa;
+    bool result = generateCountedDigits(scaledW, mk, numDigits,
+                                        numFractionalDigits,
+                                        buffer, length, kappa);
+    decimalPoint = length + kappa - mk;
+    return result;
+}
+
+// ----=====================================================================----
+//     Bignum
+// ----=====================================================================----
+
+//! An unsigned integer with a fixed capacity of \p TSize 32-bit limbs.
+template <unsigned TSize>
+class Bignum
+{
+public:
+    Bignum() noexcept
+        : m_size(0)
+    {
+    }
+
+    void assign(const uint32_t* limbs, unsigned size) noexcept
+    {
+        m_size = size;
+        for (unsigned idx = 0; idx < size; ++idx)
+            m_limbs[idx] = limbs[idx];
+        clamp();
+    }
+
+    void assign(uint32_t value) noexcept
+    {
+        m_limbs[0] = value;
+        m_size = 1;
+        clamp();
+    }
+
+    bool isZero() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    void shiftLeft(unsigned bits) noexcept
+    {
+        if (m_size == 0)
+            return;
+        unsigned limbShift = bits / 32;
+        unsigned bitShift = bits % 32;
+        if (bitShift)
+        {
+            uint32_t carry = 0;
+            for (unsigned idx = 0; idx < m_size; ++idx)
+            {
+                uint32_t limb = m_limbs[idx];
+                m_limbs[idx] = (limb << bitShift) | carry;
+                carry = limb >> (32 - bitShift);
+            }
+            if (carry)
+                m_limbs[m_size++] = carry;
+        }
+        if (limbShift)
+        {
+            for (unsigned idx = m_size; idx-- > 0;)
+                m_limbs[idx + limbShift] = m_limbs[idx];
+            for (unsigned idx = 0; idx < limbShift; ++idx)
+                m_limbs[idx] = 0;
+            m_size += limbShift;
+        }
+    }
+
+    void multiply(uint32_t factor) noexcept
+    {
+        uint64_t carry = 0;
+        for (unsigned idx = 0; idx < m_size; ++idx)
+        {
+            uint64_t product = uint64_t(m_limbs[idx]) * factor + carry;
+            m_limbs[idx] = uint32_t(product);
+            carry = product >> 32;
+        }
+        if (carry)
+            m_limbs[m_size++] = uint32_t(carry);
+    }
+
+    void multiplyByPowerOfTen(unsigned exponent) noexcept
+    {
+        // 5^13 is the largest power of five which fits into 32 bits.
+        static const uint32_t powersOfFive[] = {
+            1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125,
+            9765625, 48828125, 244140625, 1220703125
+        };
+
+        unsigned remaining = exponent;
+        while (remaining >= 13)
+        {
+            multiply(powersOfFive[13]);
+            remaining -= 13;
+        }
+        if (remaining)
+            multiply(powersOfFive[remaining]);
+        shiftLeft(exponent);
+    }
+
+    void add(const Bignum& other) noexcept
+    {
+        uint64_t carry = 0;
+        unsigned size = m_size > other.m_size ? m_size : other.m_size;
+        for (unsigned idx = 0; idx < size; ++idx)
+        {
+            uint64_t sum = carry;
+            if (idx < m_size)
+                sum += m_limbs[idx];
+            if (idx < other.m_size)
+                sum += other.m_limbs[idx];
+            m_limbs[idx] = uint32_t(sum);
+            carry = sum >> 32;
+        }
+        m_size = size;
+        if (carry)
+            m_limbs[m_size++] = uint32_t(carry);
+    }
+
+    //! Subtracts \p other, which must not be larger than this number.
+    void subtract(const Bignum& other) noexcept
+    {
+        int64_t borrow = 0;
+        for (unsigned idx = 0; idx < m_size; ++idx)
+        {
+            int64_t difference = int64_t(m_limbs[idx]) - borrow;
+            if (idx < other.m_size)
+                difference -= other.m_limbs[idx];
+            borrow = difference < 0;
+            m_limbs[idx] = uint32_t(difference);
+        }
+        clamp();
+    }
+
+    //! Divides this number by \p divisor and returns the quotient, which
+    //! must be smaller than 2^32. The remainder is kept in this number.
+    uint32_t divideModulo(const Bignum& divisor) noexcept
+    {
+        if (compare(*this, divisor) < 0)
+            return 0;
+
+        // Estimate the quotient from the leading 64 bits. The estimate
+        // is never too large.
+        unsigned shift = bitLength() > 64 ? bitLength() - 64 : 0;
+        uint64_t divisorBits = divisor.bits(shift);
+        uint32_t quotient = divisorBits == UINT64_MAX
+                            ? 1 : uint32_t(bits(shift) / (divisorBits + 1));
+        if (quotient)
+            subtractMultiple(divisor, quotient);
+        while (compare(*this, divisor) >= 0)
+        {
+            subtract(divisor);
+            ++quotient;
+        }
+        return quotient;
+    }
+
+    //! Compares \p a and \p b and returns a negative value, zero or a
+    //! positive value if a < b, a == b or a > b, respectively.
+    friend
+    int compare(const Bignum& a, const Bignum& b) noexcept
+    {
+        if (a.m_size != b.m_size)
+            return a.m_size < b.m_size ? -1 : 1;
+        for (unsigned idx = a.m_size; idx-- > 0;)
+            if (a.m_limbs[idx] != b.m_limbs[idx])
+                return a.m_limbs[idx] < b.m_limbs[idx] ? -1 : 1;
+        return 0;
+    }
+
+    //! Compares a + b with c.
+    friend
+    int plusCompare(const Bignum& a, const Bignum& b, const Bignum& c) noexcept
+    {
+        Bignum sum(a);
+        sum.add(b);
+        return compare(sum, c);
+    }
+
+private:
+    uint32_t m_limbs[TSize];
+    unsigned m_size;
+
+
+    void clamp() noexcept
+    {
+        while (m_size > 0 && m_limbs[m_size - 1] == 0)
+            --m_size;
+    }
+
+    unsigned bitLength() const noexcept
+    {
+        if (m_size == 0)
+            return 0;
+        unsigned length = 32 * (m_size - 1);
+        for (uint32_t top = m_limbs[m_size - 1]; top; top >>= 1)
+            ++length;
+        return length;
+    }
+
+    //! Returns the lowest 64 bits of this number shifted right by \p shift.
+    uint64_t bits(unsigned shift) const noexcept
+    {
+        uint64_t result = 0;
+        unsigned limb = shift / 32;
+        unsigned bitShift = shift % 32;
+        for (unsigned idx = 0; idx < 3 && limb + idx < m_size; ++idx)
+        {
+            uint64_t value = m_limbs[limb + idx];
+            if (idx == 0)
+                result = value >> bitShift;
+            else if (32 * idx - bitShift < 64)
+                result |= value << (32 * idx - bitShift);
+        }
+        return result;
+    }
+
+    void subtractMultiple(const Bignum& other, uint32_t factor) noexcept
+    {
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (unsigned idx = 0; idx < m_size; ++idx)
+        {
+            uint64_t product = carry;
+            if (idx < other.m_size)
+                product += uint64_t(other.m_limbs[idx]) * factor;
+            carry = product >> 32;
+            int64_t difference = int64_t(m_limbs[idx]) - borrow
+                                 - int64_t(uint32_t(product));
+            borrow = difference < 0;
+            m_limbs[idx] = uint32_t(difference);
+        }
+        clamp();
+    }
+};
+
+// ----=====================================================================----
+//     Exact conversion
+// ----=====================================================================----
+
+//! The binary representation of a floating-point value as
+//! mantissa * 2^exponent.
+struct BinaryFloat
+{
+    uint32_t mantissa[4];
+    unsigned size;
+    unsigned bitLength;
+    int exponent;
+    bool isLowerBoundaryCloser;
+};
+
+template <typename T>
+BinaryFloat toBinary(T value) noexcept
+{
+    static_assert(numeric_limits<T>::digits <= 128, "Unsupported type");
+    static_assert(numeric_limits<T>::radix == 2, "Unsupported type");
+
+    const int digits = numeric_limits<T>::digits;
+    const int minExponent = numeric_limits<T>::min_exponent - digits;
+
+    int exponent;
+    frexp(value, &exponent);
+    exponent -= digits;
+    if (exponent < minExponent)
+        exponent = minExponent;
+
+    BinaryFloat result;
+    result.exponent = exponent;
+    result.size = 0;
+    T mantissa = ldexp(value, -exponent);
+    bool isPowerOfTwo = mantissa == ldexp(T(1), digits - 1);
+    result.isLowerBoundaryCloser = isPowerOfTwo && exponent > minExponent;
+    while (mantissa != 0)
+    {
+        T low = fmod(mantissa, T(4294967296.0));
+        result.mantissa[result.size++] = uint32_t(low);
+        mantissa = (mantissa - low) / T(4294967296.0);
+    }
+
+    result.bitLength = 32 * (result.size - 1);
+    for (uint32_t top = result.mantissa[result.size - 1]; top; top >>= 1)
+        ++result.bitLength;
+    return result;
+}
+
+//! Returns an estimate of ceil(log10(v)) for a number v with the given
+//! bit length of the mantissa and the binary \p exponent. The estimate is
+//! either correct or one too small.
+int estimatePowerOfTen(const BinaryFloat& v) noexcept
+{
+    return int(ceil((int(v.bitLength) + v.exponent - 1) * 0.30102999566398114
+                    - 1e-10));
+}
+
+//! The bignum capacity needed for a type \p T.
+template <typename T>
+constexpr
+unsigned bignumSize() noexcept
+{
+    return ((numeric_limits<T>::max_exponent
+             > numeric_limits<T>::digits - numeric_limits<T>::min_exponent
+             ? numeric_limits<T>::max_exponent
+             : numeric_limits<T>::digits - numeric_limits<T>::min_exponent)
+            + numeric_limits<T>::digits + 96) / 32;
+}
+
+template <typename T>
+int exactShortest(T value, char* buffer, int& decimalPoint) noexcept
+{
+    using bignum = Bignum<bignumSize<T>()>;
+
+    BinaryFloat v = toBinary(value);
+    bool isEven = (v.mantissa[0] & 1) == 0;
+
+    // value = numerator / denominator. The boundaries are
+    // value - deltaMinus / denominator and value + deltaPlus / denominator.
+    bignum numerator, denominator, deltaMinus, deltaPlus;
+    numerator.assign(v.mantissa, v.size);
+    unsigned boundaryShift = v.isLowerBoundaryCloser ? 2 : 1;
+    numerator.shiftLeft(boundaryShift);
+    if (v.exponent >= 0)
+    {
+        numerator.shiftLeft(v.exponent);
+        denominator.assign(1);
+        deltaMinus.assign(1);
+        deltaMinus.shiftLeft(v.exponent);
+    }
+    else
+    {
+        denominator.assign(1);
+        denominator.shiftLeft(-v.exponent);
+        deltaMinus.assign(1);
+    }
+    denominator.shiftLeft(boundaryShift);
+    deltaPlus = deltaMinus;
+    if (v.isLowerBoundaryCloser)
+        deltaPlus.shiftLeft(1);
+
+    int k = estimatePowerOfTen(v);
+    if (k >= 0)
+    {
+        denominator.multiplyByPowerOfTen(k);
+    }
+    else
+    {
+        numerator.multiplyByPowerOfTen(-k);
+        deltaMinus.multiplyByPowerOfTen(-k);
+        deltaPlus.multiplyByPowerOfTen(-k);
+    }
+
+    // Fix the estimate, such that the first digit is in [1, 9].
+    int comparison = plusCompare(numerator, deltaPlus, denominator);
+    if (isEven ? comparison >= 0 : comparison > 0)
+    {
+        decimalPoint = k + 1;
+    }
+    else
+    {
+        decimalPoint = k;
+        numerator.multiply(10);
+        deltaMinus.multiply(10);
+        deltaPlus.multiply(10);
+    }
+
+    int length = 0;
+    for (;;)
+    {
+        uint32_t digit = numerator.divideModulo(denominator);
+        buffer[length++] = char('0' + digit);
+
+        int lowComparison = compare(numerator, deltaMinus);
+        int highComparison = plusCompare(numerator, deltaPlus, denominator);
+        bool isLow = isEven ? lowComparison <= 0 : lowComparison < 0;
+        bool isHigh = isEven ? highComparison >= 0 : highComparison > 0;
+        if (!isLow && !isHigh)
+        {
+            numerator.multiply(10);
+            deltaMinus.multiply(10);
+            deltaPlus.multiply(10);
+            continue;
+        }
+
+        if (isLow && isHigh)
+        {
+            // Both the current digit and the next larger one are within the
+            // boundaries. Pick the closer one and round to even on a tie.
+            comparison = plusCompare(numerator, numerator, denominator);
+            if (comparison > 0 || (comparison == 0 && (digit & 1)))
+                ++buffer[length - 1];
+        }
+        else if (isHigh)
+        {
+            ++buffer[length - 1];
+        }
+        return length;
+    }
+}
+
+//! Generates \p numDigits digits of numerator / denominator, where the
+//! quotient is in the range [1, 10). Returns the number of digits, which
+//! is smaller than \p numDigits if the remaining digits are all zero.
+template <typename TBignum>
+int generateExactDigits(TBignum& numerator, const TBignum& denominator,
+                        int numDigits, char* buffer,
+                        int& decimalPoint) noexcept
+{
+    int length = 0;
+    for (;;)
+    {
+        uint32_t digit = numerator.divideModulo(denominator);
+        buffer[length++] = char('0' + digit);
+        if (numerator.isZero())
+            return length;
+        if (length == numDigits)
+            break;
+        numerator.multiply(10);
+    }
+
+    // Round the last digit. Ties are rounded to even.
+    int comparison = plusCompare(numerator, numerator, denominator);
+    if (comparison > 0 || (comparison == 0 && (buffer[length - 1] & 1)))
+    {
+        int idx = length - 1;
+        while (idx >= 0 && buffer[idx] == '9')
+            --idx;
+        if (idx < 0)
+        {
+            buffer[0] = '1';
+            length = 1;
+            ++decimalPoint;
+        }
+        else
+        {
+            ++buffer[idx];
+            length = idx + 1;
+        }
+    }
+    return length;
+}
+
+//! Scales the \p value, such that numerator / denominator is in [1, 10).
+//! Returns the decimal point.
+template <typename TBignum>
+int scaleExactly(const BinaryFloat& v,
+                 TBignum& numerator, TBignum& denominator) noexcept
+{
+    numerator.assign(v.mantissa, v.size);
+    denominator.assign(1);
+    if (v.exponent >= 0)
+        numerator.shiftLeft(v.exponent);
+    else
+        denominator.shiftLeft(-v.exponent);
+
+    int k = estimatePowerOfTen(v);
+    if (k >= 0)
+        denominator.multiplyByPowerOfTen(k);
+    else
+        numerator.multiplyByPowerOfTen(-k);
+
+    if (compare(numerator, denominator) >= 0)
+        return k + 1;
+    numerator.multiply(10);
+    return k;
+}
+
+template <typename T>
+int exactPrecision(T value, int numDigits,
+                   char* buffer, int& decimalPoint) noexcept
+{
+    using bignum = Bignum<bignumSize<T>()>;
+
+    bignum numerator, denominator;
+    decimalPoint = scaleExactly(toBinary(value), numerator, denominator);
+    return generateExactDigits(numerator, denominator, numDigits,
+                               buffer, decimalPoint);
+}
+
+template <typename T>
+int exactFixed(T value, int numFractionalDigits,
+               char* buffer, int& decimalPoint) noexcept
+{
+    using bignum = Bignum<bignumSize<T>()>;
+
+    bignum numerator, denominator;
+    decimalPoint = scaleExactly(toBinary(value), numerator, denominator);
+    int numDigits = decimalPoint + numFractionalDigits;
+    if (numDigits > 0)
+    {
+        return generateExactDigits(numerator, denominator, numDigits,
+                                   buffer, decimalPoint);
+    }
+    else if (numDigits == 0)
+    {
+        // The value is in [0.1, 1) * 10^decimalPoint and is rounded either
+        // to zero or to 10^decimalPoint. Ties are rounded to the even zero.
+        denominator.multiply(10);
+        if (plusCompare(numerator, numerator, denominator) > 0)
+        {
+            buffer[0] = '1';
+            ++decimalPoint;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+// ----=====================================================================----
+//     Public interface
+// ----=====================================================================----
+
+int shortestDigits(float value, char* buffer, int& decimalPoint) noexcept
+{
+    int length;
+    if (grisuShortest(value, buffer, length, decimalPoint))
+        return length;
+    return exactShortest(value, buffer, decimalPoint);
+}
+
+int shortestDigits(double value, char* buffer, int& decimalPoint) noexcept
+{
+    int length;
+    if (grisuShortest(value, buffer, length, decimalPoint))
+        return length;
+    return exactShortest(value, buffer, decimalPoint);
+}
+
+int shortestDigits(long double value, char* buffer,
+                   int& decimalPoint) noexcept
+{
+    return exactShortest(value, buffer, decimalPoint);
+}
+
+int precisionDigits(double value, int numDigits,
+                    char* buffer, int& decimalPoint) noexcept
+{
+    int length;
+    if (grisuCounted(value, numDigits, -1, buffer, length, decimalPoint))
+        return length;
+    return exactPrecision(value, numDigits, buffer, decimalPoint);
+}
+
+int precisionDigits(long double value, int numDigits,
+                    char* buffer, int& decimalPoint) noexcept
+{
+    return exactPrecision(value, numDigits, buffer, decimalPoint);
+}
+
+int fixedDigits(double value, int numFractionalDigits,
+                char* buffer, int& decimalPoint) noexcept
+{
+    int length;
+    if (grisuCounted(value, 0, numFractionalDigits,
+                     buffer, length, decimalPoint))
+    {
+        return length;
+    }
+    return exactFixed(value, numFractionalDigits, buffer, decimalPoint);
+}
+
+int fixedDigits(long double value, int numFractionalDigits,
+                char* buffer, int& decimalPoint) noexcept
+{
+    return exactFixed(value, numFractionalDigits, buffer, decimalPoint);
+}
+
+} // namespace log11_detail
+} // namespace log11
@@ -0,0 +1,112 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_FLOATFORMATTING_HPP
+#define LOG11_FLOATFORMATTING_HPP
+
+#include "Config.hpp"
+
+#include <limits>
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+//! \brief The maximum number of significant decimal digits of a \p T.
+//!
+//! Returns an upper bound for the number of significant digits in the exact
+//! decimal expansion of a finite floating-point number of type \p T.
+template <typename T>
+constexpr
+int maxDecimalDigits() noexcept
+{
+    return (std::numeric_limits<T>::digits * 30103
+            + (std::numeric_limits<T>::digits
+               - std::numeric_limits<T>::min_exponent) * 69897) / 100000 + 2;
+}
+
+// All of the following functions convert a positive, finite and non-zero
+// \p value to a sequence of decimal digits. The digits are written as ASCII
+// characters to the \p buffer (without a terminating NUL) and their number is
+// returned. The \p decimalPoint is set such that
+//   value ~= 0.DIGITS * 10^decimalPoint.
+// The buffer must be able to hold maxDecimalDigits<T>() characters.
+
+//! \brief Converts a value to the shortest round-trip digits.
+//!
+//! Computes the shortest sequence of digits, which converts back to the
+//! same \p value when it is read with round-to-nearest. If there are several
+//! such sequences, the one closest to \p value is chosen.
+int shortestDigits(float value, char* buffer, int& decimalPoint) noexcept;
+int shortestDigits(double value, char* buffer, int& decimalPoint) noexcept;
+int shortestDigits(long double value, char* buffer, int& decimalPoint) noexcept;
+
+//! \brief Converts a value to a given number of significant digits.
+//!
+//! Computes the \p value correctly rounded to \p numDigits significant
+//! digits. Ties are rounded to even. If the exact decimal expansion of the
+//! value ends before \p numDigits, fewer digits are returned and the
+//! remaining digits are zero. \p numDigits must be positive.
+int precisionDigits(double value, int numDigits,
+                    char* buffer, int& decimalPoint) noexcept;
+int precisionDigits(long double value, int numDigits,
+                    char* buffer, int& decimalPoint) noexcept;
+
+//! \brief Converts a value to a given number of fractional digits.
+//!
+//! Computes the \p value correctly rounded to \p numFractionalDigits digits
+//! after the decimal point. Ties are rounded to even. If the value rounds to
+//! zero, no digits are returned. As with precisionDigits(), trailing zeros
+//! may be omitted.
+int fixedDigits(double value, int numFractionalDigits,
+                char* buffer, int& decimalPoint) noexcept;
+int fixedDigits(long double value, int numFractionalDigits,
+                char* buffer, int& decimalPoint) noexcept;
+
+inline
+int precisionDigits(float value, int numDigits,
+                    char* buffer, int& decimalPoint) noexcept
+{
+    return precisionDigits(double(value), numDigits, buffer, decimalPoint);
+}
+
+inline
+int fixedDigits(float value, int numFractionalDigits,
+                char* buffer, int& decimalPoint) noexcept
+{
+    return fixedDigits(double(value), numFractionalDigits,
+                       buffer, decimalPoint);
+}
+
+} // namespace log11_detail
+} // namespace log11
+
+#endif // LOG11_FLOATFORMATTING_HPP
@@ -0,0 +1,173 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "FormatCache.hpp"
+#include "CharacterScan.hpp"
+
+#include <cstring>
+
+
+using namespace std;
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+// ----=====================================================================----
+//     FormatCache
+// ----=====================================================================----
+
+FormatCache::FormatCache(unsigned capacity)
+    : m_entries(nullptr),
+      m_numSets(0),
+      m_useCounter(0)
+{
+    if (capacity)
+    {
+        m_numSets = 1;
+        while (m_numSets * numWays < capacity)
+            m_numSets *= 2;
+    }
+}
+
+FormatCache::~FormatCache()
+{
+    if (m_entries)
+        delete[] m_entries;
+}
+
+const FormatCache::Entry* FormatCache::lookup(const char* format)
+{
+    if (!m_numSets)
+        return nullptr;
+
+    if (!m_entries)
+    {
+        m_entries = new Entry[m_numSets * numWays];
+        clear();
+    }
+
+    // Format strings are at least byte-aligned and usually close to each
+    // other. A multiplicative hash spreads them over the sets.
+    auto hash = reinterpret_cast<uintptr_t>(format) * uintptr_t(0x9E3779B97F4A7C15ull);
+    Entry* set = m_entries
+                 + ((hash >> (sizeof(uintptr_t) * 8 - 16)) & (m_numSets - 1))
+                   * numWays;
+
+    ++m_useCounter;
+    Entry* victim = set;
+    for (unsigned way = 0; way < numWays; ++way)
+    {
+        Entry& entry = set[way];
+        if (entry.key == format)
+        {
+            entry.lastUse = m_useCounter;
+            return entry.isUncacheable ? nullptr : &entry;
+        }
+
+        // Free entries have a use time of zero and are taken first. The
+        // counter may wrap around, which merely results in a sub-optimal
+        // eviction.
+        if (entry.lastUse < victim->lastUse)
+            victim = &entry;
+    }
+
+    victim->key = format;
+    victim->lastUse = m_useCounter;
+    parse(format, *victim);
+    return victim->isUncacheable ? nullptr : victim;
+}
+
+void FormatCache::clear() noexcept
+{
+    if (!m_entries)
+        return;
+    for (unsigned idx = 0; idx < m_numSets * numWays; ++idx)
+    {
+        m_entries[idx].key = nullptr;
+        m_entries[idx].lastUse = 0;
+    }
+    m_useCounter = 0;
+}
+
+void FormatCache::parse(const char* format, Entry& entry)
+{
+    entry.isUncacheable = true;
+    entry.numFields = 0;
+    entry.tailOffset = 0;
+    entry.tailLength = 0;
+
+    auto length = strlen(format);
+    if (length > UINT16_MAX)
+        return;
+
+    // The splitting has to match TextStream::doFormat() exactly.
+    const char* iter = format;
+    const char* end = format + length;
+    for (;;)
+    {
+        const char* brace = findCharacter(iter, end, '{');
+        const char* closing = brace != end
+                              ? findCharacter(brace + 1, end, '}') : end;
+        if (closing == end)
+        {
+            // An unterminated replacement field ends the format string.
+            entry.tailOffset = iter - format;
+            entry.tailLength = brace - iter;
+            break;
+        }
+
+        if (entry.numFields == maxFields)
+            return;
+        Field& field = entry.fields[entry.numFields++];
+        field.literalOffset = iter - format;
+        field.literalLength = brace - iter;
+        field.format = TextStream::Format();
+
+        auto specLength = closing - (brace + 1);
+        if (specLength)
+        {
+            char spec[32];
+            if (specLength >= static_cast<decltype(specLength)>(sizeof(spec)))
+                return;
+            memcpy(spec, brace + 1, specLength);
+            spec[specLength] = '\0';
+            field.format.parse(spec);
+        }
+
+        iter = closing + 1;
+    }
+
+    entry.isUncacheable = false;
+}
+
+} // namespace log11_detail
+} // namespace log11
@@ -0,0 +1,132 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_FORMATCACHE_HPP
+#define LOG11_FORMATCACHE_HPP
+
+#include "Config.hpp"
+#include "TextStream.hpp"
+
+#include <cstdint>
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+//! \brief A cache for parsed format strings.
+//!
+//! The cache maps the address of an immutable format string to the literal
+//! segments and the parsed replacement fields of the string. As an immutable
+//! string never changes, its address is a sufficient key.
+//!
+//! The cache is a set-associative hash table with a fixed number of entries.
+//! Every set holds up to four format strings. When a set is full, the least
+//! recently used entry is evicted.
+//!
+//! The cache is used only by the consumer thread. It is not thread-safe.
+class FormatCache
+{
+public:
+    //! The maximum number of replacement fields in a cached format string.
+    static constexpr unsigned maxFields = 8;
+    //! The number of entries per set.
+    static constexpr unsigned numWays = 4;
+
+    //! A replacement field and the literal text which precedes it.
+    struct Field
+    {
+        //! The offset of the literal text in the format string.
+        std::uint16_t literalOffset;
+        //! The length of the literal text.
+        std::uint16_t literalLength;
+        //! The parsed format specification.
+        TextStream::Format format;
+    };
+
+    //! A cached format string.
+    struct Entry
+    {
+        //! The address of the format string or null for an unused entry.
+        const char* key;
+        //! The time of the last use (for the LRU eviction).
+        std::uint32_t lastUse;
+        //! The offset of the literal text after the last field.
+        std::uint16_t tailOffset;
+        //! The length of the literal text after the last field.
+        std::uint16_t tailLength;
+        //! Set if the format string cannot be cached.
+        bool isUncacheable;
+        //! The number of replacement fields.
+        std::uint8_t numFields;
+        //! The replacement fields.
+        Field fields[maxFields];
+    };
+
+    //! Creates a cache with room for \p capacity format strings. The capacity
+    //! is rounded up to a power of two. A capacity of zero disables the cache.
+    explicit
+    FormatCache(unsigned capacity);
+
+    ~FormatCache();
+
+    FormatCache(const FormatCache&) = delete;
+    FormatCache& operator=(const FormatCache&) = delete;
+
+    //! \brief Looks up a format string.
+    //!
+    //! Returns the cached entry for the immutable format string \p format.
+    //! If the string is not in the cache, it is parsed and inserted.
+    //! A null pointer is returned if the string cannot be cached, e.g.
+    //! because it has too many replacement fields.
+    //!
+    //! The returned entry is valid until the next call to lookup() or
+    //! clear().
+    const Entry* lookup(const char* format);
+
+    //! Removes all entries from the cache.
+    void clear() noexcept;
+
+private:
+    //! The entries. The memory is allocated upon the first lookup.
+    Entry* m_entries;
+    //! The number of sets (a power of two).
+    unsigned m_numSets;
+    //! A counter, which is incremented with every lookup.
+    std::uint32_t m_useCounter;
+
+    static
+    void parse(const char* format, Entry& entry);
+};
+
+} // namespace log11_detail
+} // namespace log11
+
+#endif // LOG11_FORMATCACHE_HPP
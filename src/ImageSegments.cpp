@@ -0,0 +1,147 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "ImageSegments.hpp"
+#include "LogCore.hpp"
+
+#if defined(__linux__) && !defined(LOG11_USE_WEOS)
+#define LOG11_HAVE_DL_ITERATE_PHDR
+#include <link.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+
+using namespace std;
+
+
+namespace log11
+{
+
+#ifdef LOG11_HAVE_DL_ITERATE_PHDR
+
+namespace
+{
+
+struct SegmentCollector
+{
+    std::initializer_list<const char*> libraries;
+    uintptr_t pageSize;
+    bool isExecutable;
+
+    //! The collected memory areas. Adjacent segments are merged.
+    log11_detail::SerdesOptions::Range ranges[log11_detail::SerdesOptions::maxImmutableRanges];
+    unsigned numRanges;
+
+    bool wants(const char* path) const noexcept
+    {
+        // The executable is always the first object.
+        if (isExecutable)
+            return true;
+        if (!path || !*path)
+            return false;
+        for (const char* library : libraries)
+            if (strstr(path, library))
+                return true;
+        return false;
+    }
+
+    void add(uintptr_t begin, uintptr_t end) noexcept
+    {
+        // The last page of a segment is mapped with the segment's
+        // protection, so the end can be rounded up to the page boundary.
+        end = (end + pageSize - 1) & ~(pageSize - 1);
+        for (unsigned idx = 0; idx < numRanges; ++idx)
+        {
+            if (begin <= ranges[idx].end && end >= ranges[idx].begin)
+            {
+                if (begin < ranges[idx].begin)
+                    ranges[idx].begin = begin;
+                if (end > ranges[idx].end)
+                    ranges[idx].end = end;
+                return;
+            }
+        }
+        if (numRanges < log11_detail::SerdesOptions::maxImmutableRanges)
+            ranges[numRanges++] = {begin, end};
+    }
+};
+
+int collectSegments(struct dl_phdr_info* info, size_t, void* data)
+{
+    auto& collector = *static_cast<SegmentCollector*>(data);
+    if (collector.wants(info->dlpi_name))
+    {
+        for (unsigned idx = 0; idx < info->dlpi_phnum; ++idx)
+        {
+            const auto& header = info->dlpi_phdr[idx];
+            if (   header.p_type == PT_LOAD
+                && (header.p_flags & PF_R)
+                && !(header.p_flags & PF_W))
+            {
+                uintptr_t begin = info->dlpi_addr + header.p_vaddr;
+                collector.add(begin, begin + header.p_memsz);
+            }
+        }
+    }
+    collector.isExecutable = false;
+    return 0;
+}
+
+} // anonymous namespace
+
+unsigned registerReadOnlySegments(
+        LogCore& core, std::initializer_list<const char*> libraries)
+{
+    SegmentCollector collector;
+    collector.libraries = libraries;
+    collector.pageSize = sysconf(_SC_PAGESIZE);
+    collector.isExecutable = true;
+    collector.numRanges = 0;
+    dl_iterate_phdr(&collectSegments, &collector);
+
+    for (unsigned idx = 0; idx < collector.numRanges; ++idx)
+        core.addImmutableStringSpace(collector.ranges[idx].begin,
+                                     collector.ranges[idx].end);
+    return collector.numRanges;
+}
+
+#else
+
+unsigned registerReadOnlySegments(
+        LogCore&, std::initializer_list<const char*>)
+{
+    return 0;
+}
+
+#endif // LOG11_HAVE_DL_ITERATE_PHDR
+
+} // namespace log11
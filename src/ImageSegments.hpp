@@ -0,0 +1,62 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_IMAGESEGMENTS_HPP
+#define LOG11_IMAGESEGMENTS_HPP
+
+#include "Config.hpp"
+
+#include <initializer_list>
+
+
+namespace log11
+{
+class LogCore;
+
+//! \brief Registers the read-only segments of the program image.
+//!
+//! Adds the read-only segments of the executable to the immutable string
+//! space of the \p core. String literals reside in these segments, so they
+//! are passed to the sinks as pointers instead of being copied. In
+//! addition, the read-only segments of every loaded shared library whose
+//! path contains one of the \p libraries is registered, e.g.
+//! \code
+//! registerReadOnlySegments(core, {"libnetwork.so"});
+//! \endcode
+//!
+//! The segments are found with \c dl_iterate_phdr(). On other platforms,
+//! the function does nothing. A shared library must not be unloaded after
+//! its segments have been registered. Returns the number of memory areas
+//! which have been added.
+unsigned registerReadOnlySegments(
+        LogCore& core, std::initializer_list<const char*> libraries = {});
+
+} // namespace log11
+
+#endif // LOG11_IMAGESEGMENTS_HPP
@@ -0,0 +1,208 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "JsonLinesSink.hpp"
+#include "CharacterScan.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+
+namespace log11
+{
+
+// ----=====================================================================----
+//     JsonLinesSink
+// ----=====================================================================----
+
+JsonLinesSink::JsonLinesSink()
+    : m_buffer(256),
+      m_fields(64),
+      m_inField(false),
+      m_sequenceNumbersEnabled(false)
+{
+    setFieldStyle(FieldStyle::Json);
+}
+
+void JsonLinesSink::beginLogEntry(const LogRecordData& data)
+{
+    TextSink::beginLogEntry(data);
+    if (!isCurrentRecordLogged())
+        return;
+
+    static const char* severity_texts[] = {
+        "\"TRACE\"",
+        "\"DEBUG\"",
+        "\"INFO\"",
+        "\"WARN\"",
+        "\"ERROR\""
+    };
+
+    auto pushUnsigned = [this] (std::uint64_t value) {
+        char digits[20];
+        unsigned numDigits = 0;
+        do
+        {
+            digits[sizeof(digits) - ++numDigits] = '0' + value % 10;
+            value /= 10;
+        } while (value);
+        m_buffer.push(digits + sizeof(digits) - numDigits, numDigits);
+    };
+
+    m_buffer.clear();
+    m_buffer.push("{\"time\":", 8);
+
+    // Convert the time stamp to nanoseconds.
+    std::int64_t time = chrono::duration_cast<chrono::nanoseconds>(
+                            data.time.time_since_epoch()).count();
+    if (time < 0)
+        m_buffer.push('-');
+    pushUnsigned(time < 0 ? -std::uint64_t(time) : std::uint64_t(time));
+
+    m_buffer.push(",\"severity\":", 12);
+    const char* severity = severity_texts[static_cast<unsigned>(data.severity)];
+    m_buffer.push(severity, std::strlen(severity));
+    if (data.isTruncated)
+        m_buffer.push(",\"truncated\":true", 17);
+    if (data.sequence && m_sequenceNumbersEnabled)
+    {
+        m_buffer.push(",\"seq\":", 7);
+        pushUnsigned(data.sequence);
+    }
+    m_buffer.push(",\"message\":\"", 12);
+    m_fields.clear();
+    m_inField = false;
+}
+
+void JsonLinesSink::setSequenceNumbersEnabled(bool enable) noexcept
+{
+    m_sequenceNumbersEnabled = enable;
+}
+
+bool JsonLinesSink::areSequenceNumbersEnabled() const noexcept
+{
+    return m_sequenceNumbersEnabled;
+}
+
+void JsonLinesSink::endLogEntry(const LogRecordData& /*data*/)
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    // The fields follow the message, even if arguments, which are no
+    // fields, have been written after them.
+    m_buffer.push('"');
+    m_buffer.push(m_fields.data(), m_fields.size());
+    m_buffer.push("}\n", 2);
+    writeLine(m_buffer.data(), m_buffer.size());
+}
+
+void JsonLinesSink::writeChar(char ch)
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    if (m_inField)
+        m_fields.push(ch);
+    else
+        pushEscaped(&ch, 1);
+}
+
+void JsonLinesSink::writeString(const char* text, std::size_t size)
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    // A string which wraps around the end of the ring buffer arrives in
+    // two calls. As escape sequences never span more than one input
+    // character, both halves can be escaped independently.
+    if (m_inField)
+        m_fields.push(text, size);
+    else
+        pushEscaped(text, size);
+}
+
+void JsonLinesSink::writeHeader(const char* /*header*/, std::size_t /*size*/)
+{
+}
+
+void JsonLinesSink::beginField(const char* key, std::size_t size,
+                               unsigned /*index*/)
+{
+    if (!isCurrentRecordLogged())
+        return;
+
+    // The fields are members of the record object. They are collected
+    // separately because the message may go on after a field.
+    m_fields.push(",\"", 2);
+    pushEscaped(m_fields, key, size);
+    m_fields.push("\":", 2);
+    m_inField = true;
+}
+
+void JsonLinesSink::endField()
+{
+    m_inField = false;
+}
+
+void JsonLinesSink::endFields(unsigned /*count*/)
+{
+}
+
+// ----=====================================================================----
+//     Private methods
+// ----=====================================================================----
+
+void JsonLinesSink::pushEscaped(const char* text, std::size_t size)
+{
+    pushEscaped(m_buffer, text, size);
+}
+
+void JsonLinesSink::pushEscaped(log11_detail::ScratchPad& buffer,
+                                const char* text, std::size_t size)
+{
+    const char* end = text + size;
+    for (;;)
+    {
+        const char* special = log11_detail::findJsonSpecialCharacter(text, end);
+        if (special != text)
+            buffer.push(text, special - text);
+        if (special == end)
+            break;
+
+        char escaped[6];
+        buffer.push(escaped, log11_detail::escapeJsonCharacter(*special, escaped));
+        text = special + 1;
+    }
+}
+
+} // namespace log11
@@ -0,0 +1,127 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_JSONLINESSINK_HPP
+#define LOG11_JSONLINESSINK_HPP
+
+#include "TextSink.hpp"
+#include "Utility.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace log11
+{
+
+//! \brief A sink for JSON Lines.
+//!
+//! The JsonLinesSink renders every log record as a single JSON object
+//! followed by a newline, e.g.
+//! \code
+//! {"time":1474209912000000000,"severity":"INFO","message":"Done","user":42}
+//! \endcode
+//! The time is given in nanoseconds since the epoch of the high resolution
+//! clock. If enabled, the member "seq" holds the sequence number of the
+//! record. Structured fields (see kv()) become members of the object. Other arguments without
+//! a placeholder stay part of the message, even if they follow a field. The
+//! text header of the log core is not used.
+//!
+//! A record is assembled in an internal buffer and passed to writeLine()
+//! as a whole.
+class JsonLinesSink : public TextSink
+{
+public:
+    JsonLinesSink();
+
+    JsonLinesSink(const JsonLinesSink&) = delete;
+    JsonLinesSink& operator=(const JsonLinesSink&) = delete;
+
+    //! \brief Outputs a record.
+    //!
+    //! Outputs the JSON object \p line, which is a string of length \p size
+    //! including the terminating newline.
+    virtual
+    void writeLine(const char* line, std::size_t size) = 0;
+
+    //! \brief Enables or disables the sequence numbers.
+    //!
+    //! If \p enable is set, the sequence number of every record is written
+    //! as the member "seq". A reader can use it to detect records, which
+    //! have been dropped. By default, the sequence numbers are disabled.
+    void setSequenceNumbersEnabled(bool enable) noexcept;
+
+    //! \brief Checks if the sequence numbers are enabled.
+    bool areSequenceNumbersEnabled() const noexcept;
+
+    virtual
+    void beginLogEntry(const LogRecordData& data) override;
+
+    virtual
+    void endLogEntry(const LogRecordData& data) override;
+
+    virtual
+    void writeChar(char ch) override;
+
+    virtual
+    void writeString(const char* text, std::size_t size) override;
+
+    virtual
+    void writeHeader(const char* header, std::size_t size) override;
+
+    virtual
+    void beginField(const char* key, std::size_t size, unsigned index) override;
+
+    virtual
+    void endField() override;
+
+    virtual
+    void endFields(unsigned count) override;
+
+private:
+    //! The buffer for the current record.
+    log11_detail::ScratchPad m_buffer;
+    //! The structured fields of the current record.
+    log11_detail::ScratchPad m_fields;
+    //! Set while the value of a field is written.
+    bool m_inField;
+    //! Set if the sequence numbers are written.
+    std::atomic<bool> m_sequenceNumbersEnabled;
+
+
+    void pushEscaped(const char* text, std::size_t size);
+
+    static
+    void pushEscaped(log11_detail::ScratchPad& buffer,
+                     const char* text, std::size_t size);
+};
+
+} // namespace log11
+
+#endif // LOG11_JSONLINESSINK_HPP
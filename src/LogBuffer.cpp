@@ -48,7 +48,7 @@ LogBuffer::LogBuffer(LogCore* core,
       m_policy(policy),
       m_hadEnoughSpace(true)
 {
-    m_claimed = m_core->claim(policy, size);
+    m_claimed = m_core->claim(policy, severity, size);
     m_stream = m_claimed.stream(m_core->m_messageFifo);
     m_stream.skip(LogCore::headerSize);
 }
@@ -89,7 +89,8 @@ void LogBuffer::discard()
     // Rewind the stream and write a directive to skip the entry.
     m_stream = m_claimed.stream(m_core->m_messageFifo);
     m_stream.write(Directive::command(Directive::Skip));
-    if (m_policy == LogCore::ClaimPolicy::Block)
+    if (   m_policy == LogCore::ClaimPolicy::Block
+        || m_policy == LogCore::ClaimPolicy::BlockUntil)
         m_core->m_messageFifo.publish(m_claimed);
     else
         m_core->m_messageFifo.tryPublish(m_claimed);
@@ -110,7 +111,8 @@ void LogBuffer::flush()
     LogCore::writeRecordHeader(
                 m_stream,
                 Directive::entry(m_severity, !m_hadEnoughSpace));
-    if (m_policy == LogCore::ClaimPolicy::Block)
+    if (   m_policy == LogCore::ClaimPolicy::Block
+        || m_policy == LogCore::ClaimPolicy::BlockUntil)
         m_core->m_messageFifo.publish(m_claimed);
     else
         m_core->m_messageFifo.tryPublish(m_claimed);
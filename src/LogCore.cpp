@@ -33,6 +33,7 @@
 #include "Utility.hpp"
 
 #include <chrono>
+#include <cstdio>
 #include <cstring>
 
 
@@ -57,6 +58,7 @@ void prepareSerializer(TypeList<>)
     ImmutableCharStarSerdes::instance();
     MutableCharStarSerdes::instance();
     FormatTupleSerdes::instance();
+    KeyValueSerdes::instance();
 }
 
 } // namespace log11_detail
@@ -76,11 +78,38 @@ LogCore::LogCore(std::size_t bufferSize)
 #endif
     : m_messageFifo(bufferSize)
     , m_scratchPad(32)
+    , m_formatCache(LOG11_FORMAT_CACHE_SIZE)
     , m_crossThreadChangeOngoing(false)
     , m_binarySink(nullptr)
     , m_textSink(nullptr)
     , m_headerGenerator(nullptr)
+    , m_numConsumed(0)
+    , m_consumerLag(0)
+    , m_maxConsumerLag(0)
+    , m_bufferOccupancy(0)
+    , m_bufferHighWaterMark(0)
+    , m_statisticsInterval(0)
+    , m_sequence(0)
+    , m_flightRecorder(nullptr)
+    , m_flightRecorderLevel(Severity::Info)
+    , m_flightRecorderTriggerLevel(Severity::Error)
+    , m_flightRecorderTriggered(false)
+    , m_numRetainedDiscarded(0)
+    , m_spillFile(nullptr)
+    , m_spillThreshold(0)
+    , m_numSpilled(0)
+    , m_spillBacklog(0)
+    , m_overloadControlEnabled(false)
+    , m_overloadLagLimit(0)
+    , m_overloadLevel(OverloadLevel::Normal)
+    , m_numOverloadTransitions(0)
+    , m_duplicateInterval(0)
+    , m_numRepeats(0)
+    , m_syntheticFifo(1024)
 {
+    for (auto& reserved : m_reservedSpace)
+        reserved = 0;
+
     log11_detail::prepareSerializer(log11_detail::BuiltInTypes());
 
     m_headerGenerator = RecordHeaderGenerator::parse("[{D}d {H}:{M}:{S}.{us} {L}] ");
@@ -153,6 +182,19 @@ void LogCore::setImmutableStringSpace(
     m_messageFifo.publish(claimed);
 }
 
+void LogCore::addImmutableStringSpace(
+        uintptr_t beginAddress, uintptr_t endAddress)
+{
+    m_crossThreadChangeOngoing = true;
+
+    auto claimed = m_messageFifo.claim(m_messageFifo.size());
+    auto stream = claimed.stream(m_messageFifo);
+    stream.write(Directive::command(Directive::AddImmutableSpace));
+    stream.write(beginAddress);
+    stream.write(endAddress);
+    m_messageFifo.publish(claimed);
+}
+
 void LogCore::setTextHeader(const char* header)
 {
     auto* generator = RecordHeaderGenerator::parse(header);
@@ -161,41 +203,289 @@ void LogCore::setTextHeader(const char* header)
     m_headerGenerator = generator;
 }
 
+LogStatistics LogCore::stats() const
+{
+    LogStatistics statistics;
+    m_statistics.addTo(statistics);
+    statistics.numConsumed = m_numConsumed.load(memory_order_relaxed);
+    statistics.consumerLag = chrono::nanoseconds(
+            m_consumerLag.load(memory_order_relaxed));
+    statistics.maxConsumerLag = chrono::nanoseconds(
+            m_maxConsumerLag.load(memory_order_relaxed));
+    statistics.bufferSize = m_messageFifo.size();
+    statistics.bufferOccupancy = m_bufferOccupancy.load(memory_order_relaxed);
+    statistics.bufferHighWaterMark
+            = m_bufferHighWaterMark.load(memory_order_relaxed);
+    statistics.numSpilled = m_numSpilled.load(memory_order_relaxed);
+    statistics.spillBacklog = m_spillBacklog.load(memory_order_relaxed);
+    statistics.numRepeats = m_numRepeats.load(memory_order_relaxed);
+    statistics.numRetainedDiscarded
+            = m_numRetainedDiscarded.load(memory_order_relaxed);
+    statistics.overloadLevel = m_overloadLevel.load(memory_order_relaxed);
+    statistics.numOverloadTransitions
+            = m_numOverloadTransitions.load(memory_order_relaxed);
+    return statistics;
+}
+
+void LogCore::setStatisticsInterval(chrono::milliseconds interval)
+{
+    m_statisticsInterval = interval.count();
+}
+
+void LogCore::setFlightRecorder(size_t size, Severity level,
+                                Severity triggerLevel)
+{
+    RingBuffer* recorder = size ? new RingBuffer(size) : nullptr;
+
+    auto claimed = m_messageFifo.claim(m_messageFifo.size());
+    auto stream = claimed.stream(m_messageFifo);
+    stream.write(Directive::command(Directive::SetFlightRecorder));
+    stream.write(&recorder, sizeof(RingBuffer*));
+    stream.write(level);
+    stream.write(triggerLevel);
+    m_messageFifo.publish(claimed);
+}
+
+void LogCore::dumpFlightRecorder()
+{
+    auto claimed = m_messageFifo.claim(m_messageFifo.size());
+    claimed.stream(m_messageFifo).write(
+                Directive::command(Directive::DumpFlightRecorder));
+    m_messageFifo.publish(claimed);
+}
+
+void LogCore::triggerFlightRecorder() noexcept
+{
+    m_flightRecorderTriggered.store(true, memory_order_relaxed);
+}
+
+bool LogCore::enableSpilling(size_t threshold, const char* path)
+{
+    FILE* file = fopen(path, "w+b");
+    if (!file)
+        return false;
+
+    auto* spillFile = new SpillFile(file, path);
+    unsigned spillThreshold = threshold < 2 ? 2 : threshold;
+    auto claimed = m_messageFifo.claim(m_messageFifo.size());
+    auto stream = claimed.stream(m_messageFifo);
+    stream.write(Directive::command(Directive::SetSpillFile));
+    stream.write(&spillFile, sizeof(SpillFile*));
+    stream.write(spillThreshold);
+    m_messageFifo.publish(claimed);
+    return true;
+}
+
+void LogCore::disableSpilling()
+{
+    SpillFile* spillFile = nullptr;
+    unsigned spillThreshold = 0;
+    auto claimed = m_messageFifo.claim(m_messageFifo.size());
+    auto stream = claimed.stream(m_messageFifo);
+    stream.write(Directive::command(Directive::SetSpillFile));
+    stream.write(&spillFile, sizeof(SpillFile*));
+    stream.write(spillThreshold);
+    m_messageFifo.publish(claimed);
+}
+
+void LogCore::setOverloadControl(bool enable, chrono::milliseconds lagLimit)
+{
+    m_overloadLagLimit = chrono::duration_cast<chrono::nanoseconds>(
+                             lagLimit).count();
+    m_overloadControlEnabled = enable;
+}
+
+OverloadLevel LogCore::overloadLevel() const noexcept
+{
+    return m_overloadLevel.load(memory_order_relaxed);
+}
+
+void LogCore::reserveSpace(Severity severity, std::size_t size)
+{
+    if (size > m_messageFifo.size())
+        size = m_messageFifo.size();
+    m_reservedSpace[static_cast<unsigned>(severity)] = size;
+}
+
+void LogCore::setDuplicateSuppression(chrono::milliseconds interval)
+{
+    m_duplicateInterval = interval.count();
+}
+
 // ----=====================================================================----
 //     Private methods
 // ----=====================================================================----
 
 void LogCore::writeRecordHeader(RingBuffer::Stream& stream,
                                 Directive directive)
+{
+    writeRecordHeader(stream, directive, chrono::high_resolution_clock::now());
+}
+
+void LogCore::writeRecordHeader(RingBuffer::Stream& stream,
+                                Directive directive,
+                                chrono::high_resolution_clock::time_point time)
 {
     stream.write(directive);
-    auto durationSinceEpoche
-            = chrono::high_resolution_clock::now().time_since_epoch().count();
+    auto durationSinceEpoche = time.time_since_epoch().count();
     stream.write(&durationSinceEpoche, sizeof(durationSinceEpoche));
 }
 
-RingBuffer::Block LogCore::claim(ClaimPolicy policy, std::size_t argumentSize)
+RingBuffer::Block LogCore::claim(ClaimPolicy policy, Severity severity,
+                                 std::size_t argumentSize,
+                                 chrono::steady_clock::time_point deadline)
 {
     // We cannot rely on the serdes options if a change is going on.
-    if (m_crossThreadChangeOngoing)
+    if (m_crossThreadChangeOngoing && !awaitCrossThreadChange(policy, deadline))
     {
-        if (policy != Block)
-            return RingBuffer::Block();
-        m_crossThreadChangeDone.expect(m_crossThreadChangeOngoing, false);
+        m_statistics.countDropped(severity);
+        return RingBuffer::Block();
     }
 
     auto totalSize = argumentSize + headerSize;
+
+    // Degrade the low severities under overload.
+    unsigned reserved = headroom(severity);
+    auto overload = m_overloadLevel.load(memory_order_relaxed);
+    if (overload != OverloadLevel::Normal && severity < Severity::Warn)
+        degradePolicy(overload, policy, severity, reserved);
+
     RingBuffer::Block claimed;
+    chrono::nanoseconds waitTime;
     switch (policy)
     {
-    case Block:    claimed = m_messageFifo.claim(totalSize); break;
-    case Truncate: claimed = m_messageFifo.tryClaim(headerSize, totalSize); break;
-    case Discard:  claimed = m_messageFifo.tryClaim(totalSize, totalSize); break;
+    case Block:
+        claimed = m_messageFifo.claim(totalSize, &waitTime, reserved);
+        if (waitTime.count())
+            m_statistics.countBlocked(waitTime);
+        break;
+    case Truncate:
+        claimed = m_messageFifo.tryClaim(headerSize, totalSize, reserved);
+        break;
+    case Discard:
+        claimed = m_messageFifo.tryClaim(totalSize, totalSize, reserved);
+        break;
+    case BlockUntil:
+        claimed = m_messageFifo.claimUntil(totalSize, deadline,
+                                           &waitTime, reserved);
+        if (waitTime.count())
+            m_statistics.countBlocked(waitTime);
+        break;
+    }
+
+    if (claimed.length() == 0)
+        m_statistics.countDropped(severity);
+    else
+        m_statistics.countRecord(severity, claimed.length(),
+                                 claimed.length() < totalSize);
+    return claimed;
+}
+
+RingBuffer::Block LogCore::claimBatch(ClaimPolicy policy, Severity severity,
+                                      std::size_t size)
+{
+    if (   m_crossThreadChangeOngoing
+        && !awaitCrossThreadChange(policy, chrono::steady_clock::time_point::max()))
+    {
+        return RingBuffer::Block();
     }
 
+    unsigned reserved = headroom(severity);
+    auto overload = m_overloadLevel.load(memory_order_relaxed);
+    if (overload != OverloadLevel::Normal && severity < Severity::Warn)
+        degradePolicy(overload, policy, severity, reserved);
+
+    RingBuffer::Block claimed;
+    chrono::nanoseconds waitTime;
+    switch (policy)
+    {
+    case Block:
+    case BlockUntil:
+        claimed = m_messageFifo.claim(size, &waitTime, reserved);
+        if (waitTime.count())
+            m_statistics.countBlocked(waitTime);
+        break;
+    case Truncate:
+    case Discard:
+        claimed = m_messageFifo.tryClaim(size, size, reserved);
+        break;
+    }
     return claimed;
 }
 
+bool LogCore::awaitCrossThreadChange(
+        ClaimPolicy policy, chrono::steady_clock::time_point deadline) const
+{
+    switch (policy)
+    {
+    case Block:
+        m_crossThreadChangeDone.expect(m_crossThreadChangeOngoing, false);
+        return true;
+    case BlockUntil:
+        return m_crossThreadChangeDone.expect_until(
+                    m_crossThreadChangeOngoing,
+                    [&] { return !m_crossThreadChangeOngoing; },
+                    deadline);
+    default:
+        return false;
+    }
+}
+
+void LogCore::degradePolicy(OverloadLevel level, ClaimPolicy& policy,
+                            Severity severity, unsigned& headroom) const noexcept
+{
+    if (level == OverloadLevel::Critical)
+    {
+        // Keep at least a quarter of the ring buffer for warnings and
+        // errors.
+        auto quarter = m_messageFifo.size() / 4;
+        if (headroom < quarter)
+            headroom = quarter;
+    }
+
+    if (severity <= Severity::Debug || level == OverloadLevel::Critical)
+        policy = Discard;
+    else if (level == OverloadLevel::High && policy == Block)
+        policy = Truncate;
+}
+
+void LogCore::updateOverloadLevel(unsigned occupancy, int64_t lag) noexcept
+{
+    // The pressure at which a level is entered. A level is left when the
+    // pressure has fallen below this value by the hysteresis.
+    static const unsigned enterPressure[] = { 0, 50, 75, 90 };
+    static const unsigned hysteresis = 20;
+
+    auto current = m_overloadLevel.load(memory_order_relaxed);
+    unsigned level = 0;
+    if (m_overloadControlEnabled.load(memory_order_relaxed))
+    {
+        uint64_t pressure = 100 * uint64_t(occupancy) / m_messageFifo.size();
+        auto lagLimit = m_overloadLagLimit.load(memory_order_relaxed);
+        if (lagLimit > 0 && lag > 0)
+        {
+            uint64_t lagPressure = 100 * uint64_t(lag) / uint64_t(lagLimit);
+            if (lagPressure > pressure)
+                pressure = lagPressure;
+        }
+
+        level = static_cast<unsigned>(current);
+        while (level < 3 && pressure >= enterPressure[level + 1])
+            ++level;
+        while (level > 0 && pressure + hysteresis < enterPressure[level])
+            --level;
+    }
+
+    if (level != static_cast<unsigned>(current))
+    {
+        m_overloadLevel.store(static_cast<OverloadLevel>(level),
+                              memory_order_relaxed);
+        m_numOverloadTransitions.store(
+                m_numOverloadTransitions.load(memory_order_relaxed) + 1,
+                memory_order_relaxed);
+    }
+}
+
 void LogCore::consumeFifoEntries()
 {
     using namespace std::chrono;
@@ -217,11 +507,83 @@ void LogCore::consumeFifoEntries()
         RingBuffer::Block& m_block;
     };
 
+    // Set if a block has been consumed since the last timed out wait.
+    bool hasConsumed = false;
     for (;;)
     {
-        auto block = m_messageFifo.wait();
+        // Write the spilled records when the ring buffer has drained.
+        if (   m_spillFile && m_spillFile->hasPending()
+            && m_messageFifo.occupancy() < m_spillThreshold / 2)
+        {
+            replaySpilledRecord();
+            continue;
+        }
+
+        // The pressure is gone when the ring buffer runs empty.
+        if (m_messageFifo.occupancy() == 0)
+        {
+            updateOverloadLevel(0, 0);
+
+            // All records, which have been claimed before the drops, have
+            // been written, so the drops are reported now rather than with
+            // the next record.
+            if (m_statistics.hasNewDrops())
+            {
+                writeDropMarker();
+                continue;
+            }
+        }
+
+        // A producer may count its drop just after the consumer has
+        // looked. So the consumer looks once more shortly after it has
+        // become idle.
+        auto deadline = steady_clock::time_point::max();
+        if (hasConsumed)
+            deadline = steady_clock::now() + milliseconds(10);
+
+        // A run of repeats is reported when its interval has elapsed, even
+        // if no further records arrive. So the consumer waits at most until
+        // the oldest run is due.
+        if (m_duplicateFilter.hasRepeats())
+        {
+            auto interval = milliseconds(
+                    m_duplicateInterval.load(memory_order_relaxed));
+            auto now = high_resolution_clock::now();
+            auto dueTime = m_duplicateFilter.firstRepeatTime() + interval;
+            if (dueTime <= now)
+            {
+                writeRepeatMarkers(now - interval);
+                continue;
+            }
+            auto repeatDeadline = steady_clock::now()
+                    + duration_cast<steady_clock::duration>(dueTime - now);
+            if (repeatDeadline < deadline)
+                deadline = repeatDeadline;
+        }
+
+        RingBuffer::Block block;
+        if (deadline != steady_clock::time_point::max())
+        {
+            if (!m_messageFifo.waitUntil(deadline, block))
+            {
+                hasConsumed = false;
+                continue;
+            }
+        }
+        else
+        {
+            block = m_messageFifo.wait();
+        }
+        hasConsumed = true;
         BlockConsumer consumer(m_messageFifo, block);
 
+        // Track the occupancy of the ring buffer. Only the consumer writes
+        // these values.
+        auto occupancy = m_messageFifo.occupancy();
+        m_bufferOccupancy.store(occupancy, memory_order_relaxed);
+        if (occupancy > m_bufferHighWaterMark.load(memory_order_relaxed))
+            m_bufferHighWaterMark.store(occupancy, memory_order_relaxed);
+
         auto stream = block.stream(m_messageFifo);
 
         // Deserialize the header.
@@ -235,10 +597,63 @@ void LogCore::consumeFifoEntries()
             auto command = static_cast<Directive::Command>(directive.severityOrCommand);
             if (command == Directive::Skip)
                 continue;
-            if (command == Directive::SetImmutableSpace)
+
+            // The spilled records have been enqueued before the command,
+            // which may change the sinks.
+            replaySpillFile();
+
+            // The flight recorder and the spill file do not affect the
+            // producers, so these commands are not cross-thread changes.
+            if (command == Directive::SetFlightRecorder)
+            {
+                RingBuffer* recorder;
+                Severity level, triggerLevel;
+                if (   stream.read(&recorder, sizeof(RingBuffer*))
+                    && stream.read(&level, sizeof(Severity))
+                    && stream.read(&triggerLevel, sizeof(Severity)))
+                {
+                    discardFlightRecorder();
+                    m_flightRecorder = recorder;
+                    m_flightRecorderLevel = level;
+                    m_flightRecorderTriggerLevel = triggerLevel;
+                }
+                continue;
+            }
+            if (command == Directive::DumpFlightRecorder)
+            {
+                writeRetainedRecords();
+                continue;
+            }
+            if (command == Directive::SetSpillFile)
+            {
+                SpillFile* spillFile;
+                unsigned threshold;
+                if (   stream.read(&spillFile, sizeof(SpillFile*))
+                    && stream.read(&threshold, sizeof(unsigned)))
+                {
+                    delete m_spillFile;
+                    m_spillFile = spillFile;
+                    m_spillThreshold = threshold;
+                }
+                continue;
+            }
+            if (   command == Directive::SetImmutableSpace
+                || command == Directive::AddImmutableSpace)
             {
-                stream.read(&m_serdesOptions.immutableStringBegin, sizeof(uintptr_t));
-                stream.read(&m_serdesOptions.immutableStringEnd, sizeof(uintptr_t));
+                uintptr_t begin, end;
+                if (   stream.read(&begin, sizeof(uintptr_t))
+                    && stream.read(&end, sizeof(uintptr_t)))
+                {
+                    if (command == Directive::SetImmutableSpace)
+                    {
+                        m_serdesOptions.setImmutableRange(begin, end);
+                        m_formatCache.clear();
+                    }
+                    else
+                    {
+                        m_serdesOptions.addImmutableRange(begin, end);
+                    }
+                }
             }
             if (   command == Directive::SetBinarySink
                 || command == Directive::SetBothSinks)
@@ -258,65 +673,397 @@ void LogCore::consumeFifoEntries()
             m_crossThreadChangeDone.notify(m_crossThreadChangeOngoing, false);
 
             if (command == Directive::Terminate)
+            {
+                if (m_duplicateFilter.hasRepeats())
+                    writeRepeatMarkers(high_resolution_clock::time_point::max());
+                if (m_statistics.hasNewDrops())
+                    writeDropMarker();
                 break;
+            }
             else
                 continue;
         }
 
         // Read the log record's header.
         LogRecordData record;
-        record.severity = static_cast<Severity>(directive.severityOrCommand);
-        record.isTruncated = directive.isTruncated;
+        if (!readRecordHeader(directive, stream, record))
+            continue;
+
+        // Track the time from the creation of the record to its consumption.
+        auto now = high_resolution_clock::now();
+        auto lag = duration_cast<nanoseconds>(now - record.time).count();
+        m_consumerLag.store(lag, memory_order_relaxed);
+        if (lag > m_maxConsumerLag.load(memory_order_relaxed))
+            m_maxConsumerLag.store(lag, memory_order_relaxed);
+        m_numConsumed.store(m_numConsumed.load(memory_order_relaxed) + 1,
+                            memory_order_relaxed);
+
+        updateOverloadLevel(occupancy, lag);
+
+        // Move the record to the spill file if the ring buffer fills up.
+        // Once there are spilled records, all records are spilled to keep
+        // their order.
+        if (   m_spillFile
+            && (m_spillFile->hasPending() || occupancy >= m_spillThreshold))
         {
-            high_resolution_clock::duration::rep durationSinceEpoche;
-            if (!stream.read(&durationSinceEpoche, sizeof(durationSinceEpoche)))
+            if (m_spillFile->append(record, stream, m_serdesOptions))
+            {
+                m_numSpilled.store(m_numSpilled.load(memory_order_relaxed) + 1,
+                                   memory_order_relaxed);
+                m_spillBacklog.store(m_spillFile->pendingSize(),
+                                     memory_order_relaxed);
                 continue;
-            record.time = high_resolution_clock::time_point(
-                    high_resolution_clock::duration(durationSinceEpoche));
+            }
+            // The record follows the ones, which have been spilled before.
+            replaySpillFile();
         }
 
-        // Write the entry to the binary sink.
-        if (m_binarySink)
+        processRecord(record, m_messageFifo, block, stream);
+    }
+
+    discardFlightRecorder();
+    delete m_spillFile;
+    m_spillFile = nullptr;
+
+    lock_guard<mutex> lock(m_consumerThreadMutex);
+    m_consumerState = Terminated;
+    m_consumerThreadCv.notify_one();
+}
+
+void LogCore::processRecord(LogRecordData& record,
+                            RingBuffer& buffer, RingBuffer::Block block,
+                            RingBuffer::Stream& stream)
+{
+    using namespace std::chrono;
+
+    // Records which have been created after a drop follow the marker.
+    if (   m_statistics.hasNewDrops()
+        && record.time >= m_statistics.firstDropTime())
+    {
+        writeDropMarker();
+    }
+
+    // Repeated records are only counted. Their runs are reported
+    // periodically.
+    auto repeatInterval = milliseconds(
+            m_duplicateInterval.load(memory_order_relaxed));
+    bool isRepeat = false;
+    if (repeatInterval.count())
+    {
+        isRepeat = m_duplicateFilter.isRepeat(record.severity, record.time,
+                                              stream);
+        if (m_duplicateFilter.hasRepeats())
+            writeRepeatMarkers(record.time - repeatInterval);
+    }
+    else if (m_duplicateFilter.hasRepeats())
+    {
+        writeRepeatMarkers(high_resolution_clock::time_point::max());
+    }
+
+    if (isRepeat)
+    {
+        m_numRepeats.store(m_numRepeats.load(memory_order_relaxed) + 1,
+                           memory_order_relaxed);
+    }
+    else
+    {
+        // Low-severity records go to the flight recorder, if there is one.
+        // A record with a high severity is preceded by the retained records.
+        bool isRetained = m_flightRecorder
+                          && record.severity < m_flightRecorderLevel
+                          && retainRecord(buffer, block);
+        if (m_flightRecorderTriggered.load(memory_order_relaxed))
         {
-            m_binarySink->beginLogEntry(record);
-            writeToBinary(stream);
-            m_binarySink->endLogEntry(record);
+            m_flightRecorderTriggered.store(false, memory_order_relaxed);
+            writeRetainedRecords();
         }
-
-        // Write the entry to the text sink.
-        if (m_textSink)
+        if (!isRetained)
         {
-            m_scratchPad.clear();
-            m_textSink->beginLogEntry(record);
-            if (m_headerGenerator)
+            if (   m_flightRecorder
+                && record.severity >= m_flightRecorderTriggerLevel)
             {
-                m_headerGenerator->generate(record, m_scratchPad);
-                m_textSink->writeHeader(m_scratchPad.data(), m_scratchPad.size());
+                writeRetainedRecords();
             }
-            else
+
+            // The records are numbered in the order in which they are
+            // written. A retained record is numbered when it is dumped, so
+            // the records, which are never dumped, leave no gaps.
+            record.sequence = ++m_sequence;
+
+            DuplicateFilter::Run evicted;
+            if (   repeatInterval.count()
+                && m_duplicateFilter.remember(record.sequence, evicted))
             {
-                m_textSink->writeHeader("", 0);
+                writeRepeatMarker(evicted);
             }
-            writeToText(stream);
-            m_textSink->endLogEntry(record);
+            writeRecord(record, stream);
         }
     }
 
-    lock_guard<mutex> lock(m_consumerThreadMutex);
-    m_consumerState = Terminated;
-    m_consumerThreadCv.notify_one();
+    // Write the statistics if the interval has elapsed.
+    auto interval = milliseconds(
+            m_statisticsInterval.load(memory_order_relaxed));
+    if (interval.count())
+    {
+        auto now = high_resolution_clock::now();
+        if (m_lastStatisticsTime == high_resolution_clock::time_point())
+        {
+            m_lastStatisticsTime = now;
+        }
+        else if (now - m_lastStatisticsTime >= interval)
+        {
+            m_lastStatisticsTime = now;
+            writeStatisticsRecord();
+        }
+    }
+}
+
+void LogCore::replaySpilledRecord()
+{
+    DecodedRecord spilled;
+    bool hasRecord = m_spillFile->readNext(spilled);
+    m_spillBacklog.store(m_spillFile->pendingSize(), memory_order_relaxed);
+    if (!hasRecord)
+        return;
+
+    // The decoded arguments are passed on as a single argument, so the
+    // record can be processed like the records from the ring buffer.
+    auto& buffer = m_spillFile->buffer();
+    auto size = headerSize
+                + EncodedArgumentsSerdes::requiredSize(spilled.end
+                                                       - spilled.begin)
+                + sizeof(void*);
+    auto claimed = buffer.tryClaim(size, size);
+    auto outStream = claimed.stream(buffer);
+    writeRecordHeader(outStream,
+                      Directive::entry(spilled.data.severity,
+                                       spilled.data.isTruncated),
+                      spilled.data.time);
+    EncodedArgumentsSerdes::serialize(outStream, spilled.begin, spilled.end);
+    SerdesBase* terminator = nullptr;
+    outStream.write(&terminator, sizeof(void*));
+    buffer.publish(claimed);
+
+    RingBuffer::Block block = buffer.wait();
+    auto stream = block.stream(buffer);
+    Directive directive;
+    LogRecordData record;
+    if (   stream.read(&directive, 1)
+        && readRecordHeader(directive, stream, record))
+    {
+        processRecord(record, buffer, block, stream);
+    }
+    buffer.consume(block);
+}
+
+void LogCore::replaySpillFile()
+{
+    while (m_spillFile && m_spillFile->hasPending())
+        replaySpilledRecord();
+}
+
+bool LogCore::readRecordHeader(Directive directive, RingBuffer::Stream& stream,
+                               LogRecordData& record)
+{
+    using namespace std::chrono;
+
+    record.severity = static_cast<Severity>(directive.severityOrCommand);
+    record.isTruncated = directive.isTruncated;
+
+    high_resolution_clock::duration::rep durationSinceEpoche;
+    if (!stream.read(&durationSinceEpoche, sizeof(durationSinceEpoche)))
+        return false;
+    record.time = high_resolution_clock::time_point(
+            high_resolution_clock::duration(durationSinceEpoche));
+    return true;
+}
+
+void LogCore::writeRecord(const LogRecordData& record,
+                          RingBuffer::Stream& stream)
+{
+    // Write the entry to the binary sink.
+    if (m_binarySink)
+    {
+        m_binarySink->beginLogEntry(record);
+        writeToBinary(stream);
+        m_binarySink->endLogEntry(record);
+    }
+
+    // Write the entry to the text sink.
+    if (m_textSink)
+    {
+        LogRecordData headerRecord = record;
+        m_scratchPad.clear();
+        m_textSink->beginLogEntry(record);
+        if (m_headerGenerator)
+        {
+            m_headerGenerator->generate(headerRecord, m_scratchPad);
+            m_textSink->writeHeader(m_scratchPad.data(), m_scratchPad.size());
+        }
+        else
+        {
+            m_textSink->writeHeader("", 0);
+        }
+        writeToText(stream);
+        m_textSink->endLogEntry(record);
+    }
+}
+
+void LogCore::writeStatisticsRecord()
+{
+    auto statistics = stats();
+    writeSyntheticRecord(
+            Severity::Info,
+            makeFormatTuple(
+                "log11 statistics",
+                kv("records", statistics.numRecords),
+                kv("bytes", statistics.numBytes),
+                kv("dropped", statistics.totalDropped()),
+                kv("truncated", statistics.totalTruncated()),
+                kv("blocked_claims", statistics.numBlockedClaims),
+                kv("blocked_ns", uint64_t(statistics.blockedTime.count())),
+                kv("max_blocked_ns", uint64_t(statistics.maxBlockedTime.count())),
+                kv("max_lag_ns", uint64_t(statistics.maxConsumerLag.count())),
+                kv("high_water_mark", statistics.bufferHighWaterMark),
+                kv("buffer_size", statistics.bufferSize),
+                kv("overload_level", unsigned(statistics.overloadLevel))));
+}
+
+void LogCore::writeDropMarker()
+{
+    DropReport report;
+    if (!m_statistics.takeDropReport(report))
+        return;
+
+    // The dropped records leave a gap in the sequence numbers.
+    m_sequence += report.total();
+
+    // Report with the severity of the most severe dropped record but do not
+    // let a marker be filtered out as noise.
+    auto severity = Severity::Warn;
+    if (report.numDropped[static_cast<unsigned>(Severity::Error)])
+        severity = Severity::Error;
+
+    using namespace std::chrono;
+    writeSyntheticRecord(
+            severity,
+            makeFormatTuple(
+                "log11 dropped {} records",
+                report.total(),
+                kv("trace", report.numDropped[0]),
+                kv("debug", report.numDropped[1]),
+                kv("info", report.numDropped[2]),
+                kv("warn", report.numDropped[3]),
+                kv("error", report.numDropped[4]),
+                kv("first_ns", uint64_t(duration_cast<nanoseconds>(
+                                   report.firstTime.time_since_epoch()).count())),
+                kv("last_ns", uint64_t(duration_cast<nanoseconds>(
+                                  report.lastTime.time_since_epoch()).count()))));
+}
+
+void LogCore::writeRepeatMarkers(
+        chrono::high_resolution_clock::time_point dueTime)
+{
+    DuplicateFilter::Run run;
+    while (m_duplicateFilter.takeRun(dueTime, run))
+        writeRepeatMarker(run);
+}
+
+void LogCore::writeRepeatMarker(const DuplicateFilter::Run& run)
+{
+    using namespace std::chrono;
+    writeSyntheticRecord(
+            run.severity,
+            makeFormatTuple(
+                "log11 record {} repeated {} times",
+                run.sequence,
+                run.numRepeats,
+                kv("first_ns", uint64_t(duration_cast<nanoseconds>(
+                                   run.firstTime.time_since_epoch()).count())),
+                kv("last_ns", uint64_t(duration_cast<nanoseconds>(
+                                  run.lastTime.time_since_epoch()).count()))));
+}
+
+bool LogCore::retainRecord(RingBuffer& buffer, RingBuffer::Block block)
+{
+    // An entry in the flight recorder is the serialized record including
+    // its header.
+    unsigned size = block.length();
+    if (size + 4 > m_flightRecorder->size())
+        return false;
+
+    auto claimed = m_flightRecorder->tryClaim(size, size);
+    while (claimed.length() == 0)
+    {
+        // Evict the oldest record.
+        m_flightRecorder->consume(m_flightRecorder->wait());
+        m_numRetainedDiscarded.store(
+                m_numRetainedDiscarded.load(memory_order_relaxed) + 1,
+                memory_order_relaxed);
+        claimed = m_flightRecorder->tryClaim(size, size);
+    }
+
+    auto outStream = claimed.stream(*m_flightRecorder);
+    auto inStream = block.stream(buffer);
+    SplitStringView view;
+    inStream.readString(view, block.length());
+    outStream.writeString(view.begin1, view.length1);
+    outStream.writeString(view.begin2, view.length2);
+    m_flightRecorder->publish(claimed);
+    return true;
+}
+
+void LogCore::writeRetainedRecords()
+{
+    if (!m_flightRecorder)
+        return;
+
+    while (m_flightRecorder->occupancy())
+    {
+        auto block = m_flightRecorder->wait();
+        auto stream = block.stream(*m_flightRecorder);
+        Directive directive;
+        LogRecordData record;
+        if (   stream.read(&directive, 1)
+            && readRecordHeader(directive, stream, record))
+        {
+            record.sequence = ++m_sequence;
+            writeRecord(record, stream);
+        }
+        m_flightRecorder->consume(block);
+    }
+}
+
+void LogCore::discardFlightRecorder()
+{
+    if (!m_flightRecorder)
+        return;
+
+    uint64_t numDiscarded = 0;
+    while (m_flightRecorder->occupancy())
+    {
+        m_flightRecorder->consume(m_flightRecorder->wait());
+        ++numDiscarded;
+    }
+    m_numRetainedDiscarded.store(
+            m_numRetainedDiscarded.load(memory_order_relaxed) + numDiscarded,
+            memory_order_relaxed);
+
+    delete m_flightRecorder;
+    m_flightRecorder = nullptr;
 }
 
 void LogCore::writeToText(RingBuffer::Stream inStream)
 {
-    TextStream outStream(*m_textSink, m_scratchPad);
+    TextStream outStream(*m_textSink, m_scratchPad, &m_formatCache);
     for (;;)
     {
         SerdesBase* serdes;
         if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
-            return;
+            break;
         serdes->deserialize(inStream, outStream);
     }
+    outStream.endFields();
 }
 
 void LogCore::writeToBinary(RingBuffer::Stream inStream)
@@ -31,9 +31,14 @@
 #define LOG11_LOGCORE_HPP
 
 #include "Config.hpp"
+#include "DuplicateFilter.hpp"
+#include "FormatCache.hpp"
+#include "LogRecordData.hpp"
 #include "RingBuffer.hpp"
 #include "Serdes.hpp"
 #include "Severity.hpp"
+#include "SpillFile.hpp"
+#include "Statistics.hpp"
 #include "Synchronic.hpp"
 #include "Utility.hpp"
 
@@ -55,6 +60,7 @@ namespace log11
 {
 
 class BinarySinkBase;
+class DeferredLogScope;
 class LogBuffer;
 class Logger;
 class TextSink;
@@ -66,13 +72,41 @@ struct may_discard_t {};
 struct may_truncate_or_discard_t {};
 
 //! This tag specifies that a log entry may be discarded if the FIFO is full.
-//! The message will either be logged as a whole or discarded.
+//! The message will either be logged as a whole or discarded. The consumer
+//! reports discarded entries with a marker record in the output.
 constexpr may_discard_t may_discard = may_discard_t();
 
 //! This tag specifies that a log entry may be truncated or discarded
 //! if there is no sufficient space in the FIFO.
 constexpr may_truncate_or_discard_t may_truncate_or_discard = may_truncate_or_discard_t();
 
+//! A tag type for log entries which may block until a deadline.
+struct block_until_t
+{
+    std::chrono::steady_clock::time_point deadline;
+};
+
+//! Creates a tag which specifies that the caller may be blocked until the
+//! \p deadline if the FIFO is full. If there is still no sufficient space
+//! at the \p deadline, the log entry is discarded.
+inline
+block_until_t block_until(std::chrono::steady_clock::time_point deadline)
+{
+    return block_until_t{deadline};
+}
+
+//! Creates a tag which specifies that the caller may be blocked for the
+//! given \p timeout if the FIFO is full. If there is still no sufficient
+//! space after the \p timeout, the log entry is discarded.
+template <typename TRep, typename TPeriod>
+inline
+block_until_t block_for(const std::chrono::duration<TRep, TPeriod>& timeout)
+{
+    return block_until_t{
+        std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout)};
+}
+
 
 
 namespace log11_detail
@@ -88,6 +122,10 @@ struct Directive
         SetBothSinks,
         SetBinarySink,
         SetTextSink,
+        AddImmutableSpace,
+        SetFlightRecorder,
+        DumpFlightRecorder,
+        SetSpillFile,
     };
 
     static
@@ -113,8 +151,8 @@ struct Directive
     //! If set, this is a control instruction rather than a log entry.
     unsigned char isCommand : 1;
     unsigned char isTruncated : 1;
-    unsigned char reserved : 3;
-    unsigned char severityOrCommand : 3;
+    unsigned char reserved : 2;
+    unsigned char severityOrCommand : 4;
 };
 
 } // namespace log11_detail
@@ -127,7 +165,8 @@ public:
     {
         Block,    //!< Block caller until sufficient space is available
         Truncate, //!< Message will be truncated or even discarded
-        Discard   //!< Message is displayed fully or discarded
+        Discard,  //!< Message is displayed fully or discarded
+        BlockUntil //!< Block caller until a deadline, then discard message
     };
 
 
@@ -169,15 +208,153 @@ public:
     //! {ns} ... Nanoseconds
     //!
     //! {L} ... severity level
+    //! {Q} ... sequence number
     void setTextHeader(const char* header);
 
     //! \brief Enables the immutable string optimization.
     //!
     //! Tells the logger to optimize the strings which are located in the
-    //! memory areay <tt>[beginAddress, endAddress)</tt>.
+    //! memory areay <tt>[beginAddress, endAddress)</tt>. This replaces all
+    //! immutable memory areas, which have been set before.
     void setImmutableStringSpace(
             std::uintptr_t beginAddress, std::uintptr_t endAddress);
 
+    //! \brief Adds an immutable memory area.
+    //!
+    //! Adds the memory area <tt>[beginAddress, endAddress)</tt> to the
+    //! immutable string space. Up to
+    //! log11_detail::SerdesOptions::maxImmutableRanges disjoint areas are
+    //! supported. Further areas are ignored, i.e. their strings are copied.
+    //! \sa registerReadOnlySegments()
+    void addImmutableStringSpace(
+            std::uintptr_t beginAddress, std::uintptr_t endAddress);
+
+    //! \brief Returns the statistics.
+    //!
+    //! Returns a snapshot of the statistics of this core. The counters are
+    //! read without synchronization, so they may be slightly out of date
+    //! relative to each other.
+    LogStatistics stats() const;
+
+    //! \brief Enables periodic statistics records.
+    //!
+    //! If the \p interval is non-zero, the consumer writes a record with the
+    //! statistics to the sinks when the interval has elapsed since the last
+    //! one. The check happens whenever a record is consumed, so no
+    //! statistics are written while the core is idle. By default, the
+    //! periodic statistics are disabled.
+    void setStatisticsInterval(std::chrono::milliseconds interval);
+
+    //! \brief Configures the flight recorder.
+    //!
+    //! If \p size is non-zero, the consumer keeps the records whose severity
+    //! is below the \p level in a memory area of \p size bytes (rounded up
+    //! to a power of two) instead of writing them to the sinks. The records
+    //! are retained in their serialized form, so they are not formatted.
+    //! When the area is full, the oldest records are evicted. When a record
+    //! with a severity of at least \p triggerLevel arrives, the retained
+    //! records are written to the sinks in front of it. A \p size of zero
+    //! disables the flight recorder and discards the retained records.
+    //!
+    //! The retained records are subject to the levels of the sinks when they
+    //! are written. They get their sequence numbers when they are written,
+    //! so the records, which are never written, leave no gaps in the
+    //! sequence. These records are counted in
+    //! LogStatistics::numRetainedDiscarded. Retained records are not
+    //! suppressed as repeats.
+    void setFlightRecorder(std::size_t size, Severity level = Severity::Info,
+                           Severity triggerLevel = Severity::Error);
+
+    //! \brief Dumps the flight recorder.
+    //!
+    //! Writes the records, which have been retained by the flight recorder,
+    //! to the sinks.
+    void dumpFlightRecorder();
+
+    //! \brief Requests a dump of the flight recorder.
+    //!
+    //! Requests that the retained records are written to the sinks. Unlike
+    //! dumpFlightRecorder(), this method only sets a flag, so it may be
+    //! called from a signal handler. The dump happens when the consumer
+    //! processes the next record.
+    void triggerFlightRecorder() noexcept;
+
+    //! \brief Enables spilling to disk.
+    //!
+    //! When the occupancy of the ring buffer reaches \p threshold bytes, the
+    //! consumer moves the records to a spill file instead of writing them to
+    //! the sinks. Moving a record only copies its serialized form, so the
+    //! consumer frees the ring buffer much faster than a slow sink would.
+    //! When the occupancy has dropped below half the threshold, the spilled
+    //! records are written to the sinks. The order of the records is kept.
+    //!
+    //! The spill file is created at the given \p path. Returns \p false if
+    //! the file cannot be created. The records are stored in the format of
+    //! the BinarySink with the immutable strings copied inline, so the
+    //! file can be read with a BinaryDecoder if the process terminates
+    //! before the records have been written to the sinks. Because of this,
+    //! a spilled record reaches the sinks in its decoded form: user-defined
+    //! types are formatted like the BinaryDecoder formats them. A record,
+    //! which is too large for the spill file, is written to the sinks
+    //! directly after the spilled records.
+    bool enableSpilling(std::size_t threshold, const char* path);
+
+    //! \brief Disables spilling to disk.
+    //!
+    //! The records, which are still in the spill file, are written to the
+    //! sinks before the file is closed.
+    void disableSpilling();
+
+    //! \brief Enables or disables the overload control.
+    //!
+    //! If \p enable is set, the consumer derives the pressure on the core
+    //! from the occupancy of the ring buffer and, if \p lagLimit is
+    //! non-zero, from the lag of the consumed records relative to the
+    //! \p lagLimit. As the pressure rises, the overload level is raised
+    //! and the claim policy of records with a low severity is degraded (see
+    //! OverloadLevel). A level is entered at a pressure of 50%, 75% and 90%,
+    //! respectively, and it is left when the pressure falls 20 points below
+    //! that. When the ring buffer runs empty, the level returns to normal.
+    //! By default, the overload control is disabled.
+    void setOverloadControl(bool enable,
+                            std::chrono::milliseconds lagLimit
+                                = std::chrono::milliseconds(0));
+
+    //! \brief Returns the current overload level.
+    OverloadLevel overloadLevel() const noexcept;
+
+    //! \brief Reserves space in the ring buffer for a severity.
+    //!
+    //! Reserves \p size bytes of the ring buffer for records whose severity
+    //! is at least \p severity. Records with a lower severity cannot claim
+    //! the last \p size free bytes, so they are blocked, truncated or
+    //! discarded according to their claim policy before they fill the
+    //! ring buffer completely. The reservations of different severities
+    //! add up, e.g. after
+    //! \code
+    //! core.reserveSpace(Severity::Warn, 4096);
+    //! core.reserveSpace(Severity::Error, 1024);
+    //! \endcode
+    //! an info record must leave 5120 bytes free and a warning 1024 bytes.
+    //! A \p size of zero removes the reservation. By default, no space is
+    //! reserved.
+    void reserveSpace(Severity severity, std::size_t size);
+
+    //! \brief Enables the suppression of repeated records.
+    //!
+    //! If the \p interval is non-zero, the consumer compares every record
+    //! with the last few distinct records in their serialized form, i.e.
+    //! before it is formatted. A record with the same severity, format
+    //! string and arguments as one of them is not written but counted. The
+    //! count is reported with a record like
+    //! <tt>log11 record 42 repeated 1000 times</tt>, where 42 is the
+    //! sequence number of the written record. A count is reported when the
+    //! \p interval has elapsed since the first repeat (even if no further
+    //! records are logged), when the record is forgotten in favor of
+    //! another one, when the suppression is disabled and when the core is
+    //! destroyed. By default, repeated records are not suppressed.
+    void setDuplicateSuppression(std::chrono::milliseconds interval);
+
 private:
     enum ConsumerState
     {
@@ -192,6 +369,8 @@ private:
 
     //! A scratch pad to hold perform some string conversions.
     log11_detail::ScratchPad m_scratchPad;
+    //! A cache for parsed immutable format strings.
+    log11_detail::FormatCache m_formatCache;
 
     //! Options for serialization.
     log11_detail::SerdesOptions m_serdesOptions;
@@ -215,6 +394,73 @@ private:
     //! The state of the consumer thread.
     ConsumerState m_consumerState{Initial};
 
+    //! The producer side of the statistics.
+    log11_detail::StatisticsCounters m_statistics;
+    //! The number of consumed records.
+    std::atomic<std::uint64_t> m_numConsumed;
+    //! The lag of the last consumed record in nanoseconds.
+    std::atomic<std::int64_t> m_consumerLag;
+    //! The maximum lag of a consumed record in nanoseconds.
+    std::atomic<std::int64_t> m_maxConsumerLag;
+    //! The occupancy of the ring buffer seen by the consumer.
+    std::atomic<unsigned> m_bufferOccupancy;
+    //! The maximum occupancy of the ring buffer seen by the consumer.
+    std::atomic<unsigned> m_bufferHighWaterMark;
+    //! The interval of the statistics records in milliseconds.
+    std::atomic<std::int64_t> m_statisticsInterval;
+    //! The time of the last statistics record.
+    std::chrono::high_resolution_clock::time_point m_lastStatisticsTime;
+
+    //! The sequence number of the last consumed record.
+    std::uint64_t m_sequence;
+
+    //! The records retained by the flight recorder. Only used by the
+    //! consumer.
+    RingBuffer* m_flightRecorder;
+    //! Records below this severity are retained by the flight recorder.
+    Severity m_flightRecorderLevel;
+    //! Records with at least this severity dump the flight recorder.
+    Severity m_flightRecorderTriggerLevel;
+    //! Set when a dump of the flight recorder has been requested.
+    std::atomic<bool> m_flightRecorderTriggered;
+    //! The number of retained records, which have been discarded.
+    std::atomic<std::uint64_t> m_numRetainedDiscarded;
+
+    //! The spill file or null, if spilling is disabled. Only used by the
+    //! consumer.
+    log11_detail::SpillFile* m_spillFile;
+    //! The occupancy from which on records are spilled.
+    unsigned m_spillThreshold;
+    //! The number of records, which have been spilled.
+    std::atomic<std::uint64_t> m_numSpilled;
+    //! The number of spilled bytes, which have not been written yet.
+    std::atomic<std::uint64_t> m_spillBacklog;
+
+    //! Set if the overload control is enabled.
+    std::atomic<bool> m_overloadControlEnabled;
+    //! The consumer lag in nanoseconds, which counts as full pressure.
+    std::atomic<std::int64_t> m_overloadLagLimit;
+    //! The overload level, which is set by the consumer.
+    std::atomic<OverloadLevel> m_overloadLevel;
+    //! The number of changes of the overload level.
+    std::atomic<std::uint64_t> m_numOverloadTransitions;
+
+    //! The space in the ring buffer reserved for the records with at
+    //! least the given severity.
+    std::atomic<unsigned> m_reservedSpace[LogStatistics::numSeverities];
+
+    //! The interval of the repeat counts in milliseconds or zero, if
+    //! repeated records are not suppressed.
+    std::atomic<std::int64_t> m_duplicateInterval;
+    //! Detects repeated records. Only used by the consumer.
+    log11_detail::DuplicateFilter m_duplicateFilter;
+    //! The number of records, which have been suppressed as repeats.
+    std::atomic<std::uint64_t> m_numRepeats;
+
+    //! A small ring buffer for the records, which the consumer creates
+    //! itself.
+    RingBuffer m_syntheticFifo;
+
 
     static constexpr size_t headerSize
             = sizeof(log11_detail::Directive)
@@ -223,20 +469,120 @@ private:
 
     template <typename TArg, typename... TArgs>
     void log(ClaimPolicy policy, Severity severity,
-             TArg&& arg, TArgs&&... args);
+             TArg&& arg, TArgs&&... args)
+    {
+        log(policy, std::chrono::steady_clock::time_point::max(), severity,
+            std::forward<TArg>(arg), std::forward<TArgs>(args)...);
+    }
+
+    //! Logs a record with the given claim \p policy. The \p deadline is
+    //! only used by the BlockUntil policy.
+    template <typename TArg, typename... TArgs>
+    void log(ClaimPolicy policy,
+             std::chrono::steady_clock::time_point deadline,
+             Severity severity, TArg&& arg, TArgs&&... args);
 
     static
     void writeRecordHeader(RingBuffer::Stream& stream,
                            log11_detail::Directive directive);
 
-    RingBuffer::Block claim(ClaimPolicy policy, std::size_t argumentSize);
+    //! Writes the header of a record, which has been created at the
+    //! given \p time.
+    static
+    void writeRecordHeader(
+            RingBuffer::Stream& stream, log11_detail::Directive directive,
+            std::chrono::high_resolution_clock::time_point time);
+
+    RingBuffer::Block claim(ClaimPolicy policy, Severity severity,
+                            std::size_t argumentSize,
+                            std::chrono::steady_clock::time_point deadline
+                                = std::chrono::steady_clock::time_point::max());
+
+    //! Claims \p size elements for a batch of records, whose highest
+    //! severity is \p severity. Unlike claim(), the batch is never
+    //! truncated and the records are not counted.
+    RingBuffer::Block claimBatch(ClaimPolicy policy, Severity severity,
+                                 std::size_t size);
+
+    //! Waits until a cross-thread change of the serdes options is done.
+    //! Returns \p false if a record with the claim \p policy and
+    //! \p deadline has to be dropped instead.
+    bool awaitCrossThreadChange(
+            ClaimPolicy policy,
+            std::chrono::steady_clock::time_point deadline) const;
+
+    //! Returns the space in the ring buffer, which a record with the
+    //! \p severity must leave free.
+    unsigned headroom(Severity severity) const noexcept;
+
+    //! Degrades the claim \p policy and the \p headroom of a record with
+    //! the \p severity according to the overload \p level.
+    void degradePolicy(OverloadLevel level, ClaimPolicy& policy,
+                       Severity severity, unsigned& headroom) const noexcept;
+
+    //! Updates the overload level from the \p occupancy of the ring buffer
+    //! and the \p lag of the current record in nanoseconds.
+    void updateOverloadLevel(unsigned occupancy, std::int64_t lag) noexcept;
 
     void consumeFifoEntries();
 
+    //! Processes the \p record, whose data is in the \p block of the
+    //! \p buffer. The \p stream points to the arguments of the record.
+    void processRecord(LogRecordData& record,
+                       RingBuffer& buffer, RingBuffer::Block block,
+                       RingBuffer::Stream& stream);
+
+    //! Reads the next record from the spill file and processes it.
+    void replaySpilledRecord();
+
+    //! Processes all records in the spill file.
+    void replaySpillFile();
+
+    //! Reads the header of a record from the \p stream.
+    static
+    bool readRecordHeader(log11_detail::Directive directive,
+                          RingBuffer::Stream& stream, LogRecordData& record);
+
+    //! Writes the \p record, whose arguments are in the \p stream, to
+    //! the sinks.
+    void writeRecord(const LogRecordData& record, RingBuffer::Stream& stream);
+
+    //! Writes a record, which is created by the consumer, to the sinks.
+    //! Must only be called from the consumer thread.
+    template <typename TArg>
+    void writeSyntheticRecord(Severity severity, TArg&& arg);
+
+    void writeStatisticsRecord();
+
+    //! Writes a marker record for the records, which have been dropped
+    //! since the last marker.
+    void writeDropMarker();
+
+    //! Writes the repeat counts of the runs, whose first repeat has
+    //! happened at or before \p dueTime.
+    void writeRepeatMarkers(std::chrono::high_resolution_clock::time_point dueTime);
+
+    //! Writes the repeat count of the \p run.
+    void writeRepeatMarker(const log11_detail::DuplicateFilter::Run& run);
+
+    //! Copies the record in the \p block of the \p buffer to the flight
+    //! recorder. Returns \p false if the record is too large.
+    bool retainRecord(RingBuffer& buffer, RingBuffer::Block block);
+
+    //! Writes the records retained by the flight recorder to the sinks.
+    void writeRetainedRecords();
+
+    //! Discards the flight recorder and counts the records, which it still
+    //! retains.
+    void discardFlightRecorder();
+
     void writeToText(RingBuffer::Stream inStream);
     void writeToBinary(RingBuffer::Stream inStream);
 
 
+    friend
+    class DeferredLogScope;
+
     friend
     class LogBuffer;
 
@@ -245,47 +591,116 @@ private:
 };
 
 template <typename TArg, typename... TArgs>
-void LogCore::log(ClaimPolicy policy, Severity severity,
-                  TArg&& arg, TArgs&&... args)
+void LogCore::log(ClaimPolicy policy,
+                  std::chrono::steady_clock::time_point deadline,
+                  Severity severity, TArg&& arg, TArgs&&... args)
 {
     using namespace std;
     using namespace log11_detail;
 
     // We cannot rely on the serdes options if a change is going on.
-    if (m_crossThreadChangeOngoing)
+    if (m_crossThreadChangeOngoing && !awaitCrossThreadChange(policy, deadline))
     {
-        if (policy != Block)
-            return;
-        m_crossThreadChangeDone.expect(m_crossThreadChangeOngoing, false);
+        m_statistics.countDropped(severity);
+        return;
     }
 
     size_t argumentSize = SerdesVisitor::requiredSize(m_serdesOptions, arg, args...);
     auto totalSize = argumentSize + headerSize;
 
+    // Degrade the low severities under overload. Only the claim is
+    // degraded. A caller, which may block, still publishes blockingly.
+    unsigned reserved = headroom(severity);
+    ClaimPolicy claimPolicy = policy;
+    auto overload = m_overloadLevel.load(memory_order_relaxed);
+    if (overload != OverloadLevel::Normal && severity < Severity::Warn)
+        degradePolicy(overload, claimPolicy, severity, reserved);
+
     RingBuffer::Block claimed;
-    switch (policy)
+    chrono::nanoseconds waitTime;
+    switch (claimPolicy)
     {
-    case Block:    claimed = m_messageFifo.claim(totalSize); break;
-    case Truncate: claimed = m_messageFifo.tryClaim(headerSize, totalSize); break;
-    case Discard:  claimed = m_messageFifo.tryClaim(totalSize, totalSize); break;
+    case Block:
+        claimed = m_messageFifo.claim(totalSize, &waitTime, reserved);
+        if (waitTime.count())
+            m_statistics.countBlocked(waitTime);
+        break;
+    case Truncate:
+        claimed = m_messageFifo.tryClaim(headerSize, totalSize, reserved);
+        break;
+    case Discard:
+        claimed = m_messageFifo.tryClaim(totalSize, totalSize, reserved);
+        break;
+    case BlockUntil:
+        claimed = m_messageFifo.claimUntil(totalSize, deadline,
+                                           &waitTime, reserved);
+        if (waitTime.count())
+            m_statistics.countBlocked(waitTime);
+        break;
     }
     if (claimed.length() == 0)
+    {
+        m_statistics.countDropped(severity);
         return;
+    }
+
+    bool isTruncated = claimed.length() < totalSize;
+    m_statistics.countRecord(severity, claimed.length(), isTruncated);
 
     auto stream = claimed.stream(m_messageFifo);
     // Write the header.
-    writeRecordHeader(
-                stream,
-                Directive::entry(severity, claimed.length() < totalSize));
+    writeRecordHeader(stream, Directive::entry(severity, isTruncated));
     // Serialize all the arguments.
     SerdesVisitor::serialize(m_serdesOptions, stream, arg, args...);
 
-    if (policy == Block)
+    // A policy which may block can also wait for the preceding producers.
+    if (policy == Block || policy == BlockUntil)
         m_messageFifo.publish(claimed);
     else
         m_messageFifo.tryPublish(claimed);
 }
 
+inline
+unsigned LogCore::headroom(Severity severity) const noexcept
+{
+    unsigned reserved = 0;
+    for (auto idx = static_cast<unsigned>(severity) + 1;
+         idx < LogStatistics::numSeverities; ++idx)
+        reserved += m_reservedSpace[idx].load(std::memory_order_relaxed);
+    return reserved;
+}
+
+template <typename TArg>
+void LogCore::writeSyntheticRecord(Severity severity, TArg&& arg)
+{
+    using namespace log11_detail;
+
+    size_t argumentSize = SerdesVisitor::requiredSize(m_serdesOptions, arg);
+    auto totalSize = argumentSize + headerSize;
+
+    // The consumer is the only user of the synthetic FIFO, which is empty
+    // at this point.
+    auto claimed = m_syntheticFifo.tryClaim(headerSize, totalSize);
+    if (claimed.length() == 0)
+        return;
+    auto outStream = claimed.stream(m_syntheticFifo);
+    writeRecordHeader(outStream,
+                      Directive::entry(severity, claimed.length() < totalSize));
+    SerdesVisitor::serialize(m_serdesOptions, outStream, arg);
+    m_syntheticFifo.publish(claimed);
+
+    auto block = m_syntheticFifo.wait();
+    auto inStream = block.stream(m_syntheticFifo);
+    Directive directive;
+    LogRecordData record;
+    if (   inStream.read(&directive, 1)
+        && readRecordHeader(directive, inStream, record))
+    {
+        writeRecord(record, inStream);
+    }
+    m_syntheticFifo.consume(block);
+}
+
 } // namespace log11
 
 #endif // LOG11_LOGCORE_HPP
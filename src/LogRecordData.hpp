@@ -33,6 +33,7 @@
 #include "Severity.hpp"
 
 #include <chrono>
+#include <cstdint>
 
 
 namespace log11
@@ -43,6 +44,11 @@ struct LogRecordData
     std::chrono::high_resolution_clock::time_point time;
     Severity severity;
     bool isTruncated;
+    //! The sequence number of the record. The records are numbered from 1
+    //! in the order in which they have been enqueued. A dropped record
+    //! leaves a gap. Records created by the log core itself have no number
+    //! and use 0.
+    std::uint64_t sequence = 0;
 };
 
 } // namespace log11
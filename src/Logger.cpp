@@ -78,4 +78,9 @@ LogBuffer Logger::logBuffer(Severity severity, std::size_t size)
     return LogBuffer(m_core, LogCore::ClaimPolicy::Block, severity, size);
 }
 
+DeferredLogScope Logger::deferredScope(std::size_t size)
+{
+    return DeferredLogScope(m_core, size);
+}
+
 } // namespace log11
@@ -31,8 +31,10 @@
 #define LOG11_LOGGER_HPP
 
 #include "Config.hpp"
+#include "DeferredLogScope.hpp"
 #include "LogBuffer.hpp"
 #include "LogCore.hpp"
+#include "RateLimit.hpp"
 #include "Severity.hpp"
 #include "TypeTraits.hpp"
 #include "Utility.hpp"
@@ -123,6 +125,14 @@ public:
 
     LogBuffer logBuffer(Severity severity, std::size_t size);
 
+    //! \brief Creates a deferred scope.
+    //!
+    //! Creates a scope with an arena of \p size bytes, whose records are
+    //! only logged if the scope fails. The records of the scope are not
+    //! subject to the level of this logger.
+    //! \sa DeferredLogScope
+    DeferredLogScope deferredScope(std::size_t size);
+
 
 
     //! If the level of this logger is lower or equal to the \p severity of
@@ -161,6 +171,63 @@ public:
         }
     }
 
+    //! If the level of this logger is lower or equal to the \p severity of
+    //! the message, a new log entry is created by interpolating the
+    //! \p message with the given \p args.
+    //! If there is not sufficient space in the FIFO, which connects the logger
+    //! front-ends to the sinks, the caller is blocked until the deadline of
+    //! the tag \p until. If there is still not sufficient space by then, the
+    //! message is discarded. A discarded message does not leave a gap in
+    //! the FIFO.
+    //! \code
+    //! logger.log(block_for(std::chrono::microseconds(50)),
+    //!            Severity::Info, "value: {}", value);
+    //! \endcode
+    template <typename... TArgs>
+    void log(block_until_t until, Severity severity, const char* message,
+             TArgs&&... args)
+    {
+        if (canLog(severity))
+        {
+            m_core->log(LogCore::ClaimPolicy::BlockUntil, until.deadline,
+                        severity,
+                        log11_detail::makeFormatTuple(
+                            message, log11_detail::decayArgument(args)...));
+        }
+    }
+
+    //! If the level of this logger is lower or equal to the \p severity of
+    //! the message and the call site \p filter (a RateLimit or a Sampler)
+    //! lets the message pass, a new log entry is created by interpolating
+    //! the \p message with the given \p args. The filter is evaluated before
+    //! the arguments are serialized. If messages have been suppressed by the
+    //! filter, their number is attached as the field \c suppressed.
+    //! The caller is blocked until there is sufficient space in the FIFO,
+    //! which connects the logger front-ends to the sinks.
+    template <typename TFilter, typename... TArgs>
+    auto log(TFilter& filter, Severity severity, const char* message,
+             TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        std::uint32_t suppressed;
+        if (!canLog(severity) || !filter.tryAcquire(suppressed))
+            return;
+
+        if (suppressed == 0)
+        {
+            m_core->log(LogCore::ClaimPolicy::Block, severity,
+                        log11_detail::makeFormatTuple(
+                            message, log11_detail::decayArgument(args)...));
+        }
+        else
+        {
+            m_core->log(LogCore::ClaimPolicy::Block, severity,
+                        log11_detail::makeFormatTuple(
+                            message, log11_detail::decayArgument(args)...,
+                            kv("suppressed", suppressed)));
+        }
+    }
+
     // //! Creates a log stream with the given \p severity. The resulting object
     // //! can be used to create a log entry using C++ stream notation as in
     // //! \code
@@ -209,6 +276,33 @@ public:
                   message, std::forward<TArgs>(args)...);
     }
 
+    //! \brief A convenience function for trace log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(until, Severity::Trace, message, args...);
+    //! \endcode
+    template <typename... TArgs>
+    void trace(block_until_t until, const char* message, TArgs&&... args)
+    {
+        this->log(until, Severity::Trace,
+                  message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for trace log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(filter, Severity::Trace, message, args...);
+    //! \endcode
+    template <typename TFilter, typename... TArgs>
+    auto trace(TFilter& filter, const char* message, TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        this->log(filter, Severity::Trace,
+                  message, std::forward<TArgs>(args)...);
+    }
+
     // //! \brief A convenience function for trace streams.
     // //!
     // //! Creates a trace stream equivalent to
@@ -260,6 +354,33 @@ public:
                   message, std::forward<TArgs>(args)...);
     }
 
+    //! \brief A convenience function for debug log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(until, Severity::Debug, message, args...);
+    //! \endcode
+    template <typename... TArgs>
+    void debug(block_until_t until, const char* message, TArgs&&... args)
+    {
+        this->log(until, Severity::Debug,
+                  message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for debug log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(filter, Severity::Debug, message, args...);
+    //! \endcode
+    template <typename TFilter, typename... TArgs>
+    auto debug(TFilter& filter, const char* message, TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        this->log(filter, Severity::Debug,
+                  message, std::forward<TArgs>(args)...);
+    }
+
     // //! \brief A convenience function for debug streams.
     // //!
     // //! Creates a debug stream equivalent to
@@ -311,6 +432,33 @@ public:
                   message, std::forward<TArgs>(args)...);
     }
 
+    //! \brief A convenience function for info log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(until, Severity::Info, message, args...);
+    //! \endcode
+    template <typename... TArgs>
+    void info(block_until_t until, const char* message, TArgs&&... args)
+    {
+        this->log(until, Severity::Info,
+                  message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for info log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(filter, Severity::Info, message, args...);
+    //! \endcode
+    template <typename TFilter, typename... TArgs>
+    auto info(TFilter& filter, const char* message, TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        this->log(filter, Severity::Info,
+                  message, std::forward<TArgs>(args)...);
+    }
+
     // //! \brief A convenience function for info streams.
     // //!
     // //! Creates an info stream equivalent to
@@ -362,6 +510,33 @@ public:
                   message, std::forward<TArgs>(args)...);
     }
 
+    //! \brief A convenience function for warn log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(until, Severity::Warn, message, args...);
+    //! \endcode
+    template <typename... TArgs>
+    void warn(block_until_t until, const char* message, TArgs&&... args)
+    {
+        this->log(until, Severity::Warn,
+                  message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for warn log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(filter, Severity::Warn, message, args...);
+    //! \endcode
+    template <typename TFilter, typename... TArgs>
+    auto warn(TFilter& filter, const char* message, TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        this->log(filter, Severity::Warn,
+                  message, std::forward<TArgs>(args)...);
+    }
+
     // //! \brief A convenience function for warning streams.
     // //!
     // //! Creates a warning stream equivalent to
@@ -413,6 +588,33 @@ public:
                   message, std::forward<TArgs>(args)...);
     }
 
+    //! \brief A convenience function for error log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(until, Severity::Error, message, args...);
+    //! \endcode
+    template <typename... TArgs>
+    void error(block_until_t until, const char* message, TArgs&&... args)
+    {
+        this->log(until, Severity::Error,
+                  message, std::forward<TArgs>(args)...);
+    }
+
+    //! \brief A convenience function for error log entries.
+    //!
+    //! This function is equivalent to calling
+    //! \code
+    //! log(filter, Severity::Error, message, args...);
+    //! \endcode
+    template <typename TFilter, typename... TArgs>
+    auto error(TFilter& filter, const char* message, TArgs&&... args)
+        -> std::enable_if_t<log11_detail::IsCallSiteFilter<TFilter>::value>
+    {
+        this->log(filter, Severity::Error,
+                  message, std::forward<TArgs>(args)...);
+    }
+
     // //! \brief A convenience function for error streams.
     // //!
     // //! Creates an error stream equivalent to
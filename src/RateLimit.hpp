@@ -0,0 +1,191 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_RATELIMIT_HPP
+#define LOG11_RATELIMIT_HPP
+
+#include "Config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace log11
+{
+
+// ----=====================================================================----
+//     RateLimit
+// ----=====================================================================----
+
+//! \brief A rate limit for a call site.
+//!
+//! A RateLimit lets at most \p count records pass per \p period. Bursts of
+//! up to \p burst records are admitted as long as the average rate is kept.
+//! The limit is meant to be a static object at the call site, which is
+//! passed to the logger together with the message:
+//! \code
+//! static RateLimit limit(10, std::chrono::seconds(1));
+//! log.warn(limit, "Packet {} dropped", id);
+//! \endcode
+//! The limit is evaluated before the arguments are serialized, so a
+//! suppressed record costs a clock read and an atomic update. The number of
+//! suppressed records is attached to the next record, which passes the
+//! limit, as the field \c suppressed.
+//!
+//! The limit implements the generic cell rate algorithm, which behaves like
+//! a token bucket whose state is a single time stamp.
+class RateLimit
+{
+public:
+    //! Creates a rate limit of \p count records per \p period with bursts of
+    //! up to \p burst records.
+    explicit
+    RateLimit(unsigned count,
+              std::chrono::nanoseconds period = std::chrono::seconds(1),
+              unsigned burst = 1) noexcept
+        : m_emissionInterval(period.count() / (count ? count : 1)),
+          m_burstTolerance(m_emissionInterval * (burst ? burst : 1)),
+          m_arrivalTime(0),
+          m_numSuppressed(0)
+    {
+    }
+
+    RateLimit(const RateLimit&) = delete;
+    RateLimit& operator=(const RateLimit&) = delete;
+
+    //! Returns \p true if a record may pass the limit. In this case,
+    //! \p suppressed is set to the number of records, which have been
+    //! suppressed since the last record passed.
+    bool tryAcquire(std::uint32_t& suppressed) noexcept
+    {
+        using namespace std::chrono;
+
+        std::int64_t now = duration_cast<nanoseconds>(
+                               steady_clock::now().time_since_epoch()).count();
+        auto arrivalTime = m_arrivalTime.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto next = (arrivalTime > now ? arrivalTime : now)
+                        + m_emissionInterval;
+            if (next - now > m_burstTolerance)
+            {
+                m_numSuppressed.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (m_arrivalTime.compare_exchange_weak(
+                    arrivalTime, next, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        suppressed = m_numSuppressed.load(std::memory_order_relaxed)
+                     ? m_numSuppressed.exchange(0, std::memory_order_relaxed)
+                     : 0;
+        return true;
+    }
+
+private:
+    //! The time between two records at the average rate in nanoseconds.
+    std::int64_t m_emissionInterval;
+    //! How far the arrival time may run ahead of the clock.
+    std::int64_t m_burstTolerance;
+    //! The theoretical arrival time of the next record.
+    std::atomic<std::int64_t> m_arrivalTime;
+    //! The number of records suppressed since the last one passed.
+    std::atomic<std::uint32_t> m_numSuppressed;
+};
+
+// ----=====================================================================----
+//     Sampler
+// ----=====================================================================----
+
+//! \brief A sampler for a call site.
+//!
+//! A Sampler deterministically lets one out of \p n records pass, namely
+//! the first, the (n+1)-th and so on. Like a RateLimit, it is meant to be
+//! a static object at the call site:
+//! \code
+//! static Sampler sampler(100);
+//! log.debug(sampler, "Iteration {}: {}", i, value);
+//! \endcode
+//! A suppressed record costs a single atomic increment. The number of
+//! suppressed records is attached to the next record, which passes, as the
+//! field \c suppressed.
+class Sampler
+{
+public:
+    //! Creates a sampler, which lets one out of \p n records pass.
+    explicit
+    Sampler(unsigned n) noexcept
+        : m_n(n ? n : 1),
+          m_counter(0)
+    {
+    }
+
+    Sampler(const Sampler&) = delete;
+    Sampler& operator=(const Sampler&) = delete;
+
+    //! Returns \p true if a record may pass the sampler. In this case,
+    //! \p suppressed is set to the number of records, which have been
+    //! suppressed since the last record passed.
+    bool tryAcquire(std::uint32_t& suppressed) noexcept
+    {
+        auto count = m_counter.fetch_add(1, std::memory_order_relaxed);
+        if (count % m_n)
+            return false;
+        suppressed = count ? m_n - 1 : 0;
+        return true;
+    }
+
+private:
+    //! One out of this many records passes.
+    std::uint32_t m_n;
+    //! The number of records seen by the sampler.
+    std::atomic<std::uint32_t> m_counter;
+};
+
+namespace log11_detail
+{
+
+//! Evaluates to \p true if \p T is a filter for a call site.
+template <typename T>
+struct IsCallSiteFilter
+        : std::integral_constant<bool, std::is_same<T, RateLimit>::value
+                                       || std::is_same<T, Sampler>::value>
+{
+};
+
+} // namespace log11_detail
+
+} // namespace log11
+
+#endif // LOG11_RATELIMIT_HPP
@@ -192,22 +192,40 @@ RingBuffer::~RingBuffer()
         ::operator delete(m_data);
 }
 
-auto RingBuffer::claim(unsigned numElements) -> Block
+auto RingBuffer::claim(unsigned numElements,
+                       std::chrono::nanoseconds* waitTime,
+                       unsigned reserved) -> Block
 {
+    if (reserved)
+    {
+        return claimUntil(numElements, std::chrono::steady_clock::time_point::max(),
+                          waitTime, reserved);
+    }
+
     numElements = (numElements + 3) & ~1;
     if (numElements > m_size)
         numElements = m_size;
+    if (numElements > Block::max_length)
+        numElements = Block::max_length;
 
     // Claim a sequence of elements.
     unsigned claimEnd = m_claimed += numElements;
     // Wait until the claimed elements are free (the consumer has made enough
     // progress).
     unsigned consumerThreshold = claimEnd - m_size;
+    if (waitTime)
+        *waitTime = std::chrono::nanoseconds(0);
     if (int(m_consumed - consumerThreshold) < 0)
     {
+        auto waitBegin = std::chrono::steady_clock::now();
         m_consumerProgress.expect(
                     m_consumed,
                     [&] { return int(m_consumed - consumerThreshold) >= 0; });
+        if (waitTime)
+        {
+            *waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - waitBegin);
+        }
     }
 
     unsigned claimBegin = claimEnd - numElements;
@@ -215,21 +233,94 @@ auto RingBuffer::claim(unsigned numElements) -> Block
     return Block(claimBegin, numElements);
 }
 
-auto RingBuffer::tryClaim(unsigned minNumElements, unsigned maxNumElements) -> Block
+auto RingBuffer::claimUntil(unsigned numElements,
+                            std::chrono::steady_clock::time_point deadline,
+                            std::chrono::nanoseconds* waitTime,
+                            unsigned reserved) -> Block
+{
+    numElements = (numElements + 3) & ~1;
+    if (numElements > m_size)
+        numElements = m_size;
+    if (numElements > Block::max_length)
+        numElements = Block::max_length;
+    if (reserved > m_size - numElements)
+        reserved = m_size - numElements;
+
+    if (waitTime)
+        *waitTime = std::chrono::nanoseconds(0);
+
+    // Unlike claim(), the elements are only claimed when they are free (and
+    // the reserved elements remain free). A claim which times out would
+    // otherwise leave a hole, which is never published.
+    auto hasSpace = [&] (unsigned claimBegin) {
+        return int(m_consumed - (claimBegin - m_size))
+               >= int(numElements + reserved);
+    };
+
+    unsigned claimBegin = m_claimed;
+    std::chrono::steady_clock::time_point waitBegin;
+    bool hasWaited = false;
+    bool timedOut = false;
+    for (;;)
+    {
+        if (hasSpace(claimBegin))
+        {
+            if (m_claimed.compare_exchange_weak(claimBegin,
+                                                claimBegin + numElements))
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (timedOut)
+            break;
+        if (!hasWaited)
+        {
+            waitBegin = std::chrono::steady_clock::now();
+            hasWaited = true;
+        }
+        auto pred = [&] { claimBegin = m_claimed; return hasSpace(claimBegin); };
+        if (deadline == std::chrono::steady_clock::time_point::max())
+            m_consumerProgress.expect(m_consumed, pred);
+        else if (!m_consumerProgress.expect_until(m_consumed, pred, deadline))
+            timedOut = true;
+    }
+
+    if (hasWaited && waitTime)
+    {
+        *waitTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - waitBegin);
+    }
+    if (timedOut)
+        return Block(0, Block::header_size);
+
+    *reinterpret_cast<uint16_t*>(data(claimBegin)) = numElements;
+    return Block(claimBegin, numElements);
+}
+
+auto RingBuffer::tryClaim(unsigned minNumElements, unsigned maxNumElements,
+                          unsigned reserved) -> Block
 {
     minNumElements = (minNumElements + 3) & ~1;
     if (minNumElements > m_size)
         minNumElements = m_size;
+    if (minNumElements > Block::max_length)
+        minNumElements = Block::max_length;
     maxNumElements = (maxNumElements + 3) & ~1;
     if (maxNumElements > m_size)
         maxNumElements = m_size;
+    if (maxNumElements > Block::max_length)
+        maxNumElements = Block::max_length;
+    if (reserved > m_size)
+        reserved = m_size;
 
     unsigned claimBegin = m_claimed;
     int free;
     do
     {
         // Determine the number of available elements.
-        free = m_consumed - (claimBegin - m_size);
+        free = m_consumed - (claimBegin - m_size) - reserved;
         if (free < int(minNumElements))
             return Block(0, Block::header_size);
         if (free >= int(maxNumElements))
@@ -304,8 +395,8 @@ void RingBuffer::tryPublish(const Block& block)
         }
     }
 
-    // All stash slots have been taken.
-    std::terminate();
+    // All stash slots have been taken, so wait for the preceding producers.
+    publish(block);
 }
 
 bool RingBuffer::applyStash() noexcept
@@ -341,6 +432,19 @@ bool RingBuffer::applyStash() noexcept
 
 
 
+auto RingBuffer::split(Block& block, unsigned numElements) noexcept -> Block
+{
+    numElements = (numElements + 3) & ~1;
+    if (numElements > block.m_length)
+        numElements = block.m_length;
+
+    Block front(block.m_begin, numElements);
+    *reinterpret_cast<uint16_t*>(data(front.m_begin)) = numElements;
+    block.m_begin += numElements;
+    block.m_length -= numElements;
+    return front;
+}
+
 auto RingBuffer::wait() noexcept -> Block
 {
     while (m_stashCount != 0 && applyStash())
@@ -359,11 +463,42 @@ auto RingBuffer::wait() noexcept -> Block
                  *reinterpret_cast<uint16_t*>(data(consumeBegin)));
 }
 
+bool RingBuffer::waitUntil(std::chrono::steady_clock::time_point deadline,
+                           Block& block) noexcept
+{
+    while (m_stashCount != 0 && applyStash())
+    {
+    }
+
+    if (int(m_published - m_consumed) <= 0)
+    {
+        // Wait until the producers have made progress or the deadline has
+        // passed.
+        if (!m_producerProgress.expect_until(
+                 m_published,
+                 [&] { return int(m_published - m_consumed) > 0; },
+                 deadline))
+        {
+            return false;
+        }
+    }
+    unsigned consumeBegin = m_consumed;
+    block = Block(consumeBegin,
+                  *reinterpret_cast<uint16_t*>(data(consumeBegin)));
+    return true;
+}
+
 void RingBuffer::consume(Block block) noexcept
 {
     m_consumerProgress.notify(m_consumed, m_consumed + block.m_length);
 }
 
+auto RingBuffer::next(const Block& block) noexcept -> Block
+{
+    unsigned begin = block.m_begin + block.m_length;
+    return Block(begin, *reinterpret_cast<uint16_t*>(data(begin)));
+}
+
 
 
 void* RingBuffer::data(unsigned index) noexcept
@@ -425,3 +560,15 @@ unsigned RingBuffer::size() const noexcept
 {
     return m_size;
 }
+
+unsigned RingBuffer::maxClaimSize() const noexcept
+{
+    return m_size < Block::max_length ? m_size : Block::max_length;
+}
+
+unsigned RingBuffer::occupancy() const noexcept
+{
+    // Waiting producers may have claimed more than the size.
+    unsigned claimed = m_claimed - m_consumed;
+    return claimed < m_size ? claimed : m_size;
+}
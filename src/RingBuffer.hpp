@@ -34,6 +34,7 @@
 #include "Utility.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <utility>
 
@@ -58,6 +59,11 @@ public:
             return m_begin;
         }
 
+        unsigned length() const noexcept
+        {
+            return m_length;
+        }
+
         byte peek() noexcept;
 
         bool read(void* dest, unsigned size) noexcept;
@@ -107,6 +113,9 @@ public:
     class Block
     {
         static constexpr unsigned header_size = 2;
+        //! The maximum length of a block, which is limited by the 16-bit
+        //! length in the header.
+        static constexpr unsigned max_length = 0xFFFE;
 
     public:
         Block();
@@ -124,6 +133,14 @@ public:
             return m_length - header_size;
         }
 
+        //! Returns the number of elements, which the block occupies in the
+        //! ring buffer including its header.
+        constexpr
+        unsigned size() const noexcept
+        {
+            return m_length;
+        }
+
         Stream stream(RingBuffer& buffer) noexcept;
 
     private:
@@ -151,13 +168,29 @@ public:
     // Producer interface
 
     //! Claims \p numElements elements from the ring buffer. The caller is
-    //! blocked until the elements are free.
-    Block claim(unsigned numElements);
+    //! blocked until the elements are free. If \p waitTime is not null, it
+    //! is set to the time the caller had to wait. If \p reserved is
+    //! non-zero, the caller is blocked until \p reserved elements remain
+    //! free in addition to the claimed ones.
+    Block claim(unsigned numElements,
+                std::chrono::nanoseconds* waitTime = nullptr,
+                unsigned reserved = 0);
+
+    //! Claims \p numElements elements from the ring buffer like claim() but
+    //! blocks the caller at most until the \p deadline. If the elements
+    //! are not free by then, nothing is claimed and an empty block is
+    //! returned.
+    Block claimUntil(unsigned numElements,
+                     std::chrono::steady_clock::time_point deadline,
+                     std::chrono::nanoseconds* waitTime = nullptr,
+                     unsigned reserved = 0);
 
     //! Tries to claim between \p minNumElements and \p maxNumElements (both
     //! sides inclusive) elements from the buffer. If less than
     //! \p minNumElements elements are available, an empty block is returned.
-    Block tryClaim(unsigned minNumElements, unsigned maxNumElements);
+    //! The last \p reserved free elements are not available to the caller.
+    Block tryClaim(unsigned minNumElements, unsigned maxNumElements,
+                   unsigned reserved = 0);
 
     //! Publishes the \p block of elements. The block must have
     //! been claimed before publishing. The caller will be blocked until
@@ -165,18 +198,35 @@ public:
     void publish(const Block& block);
 
     //! Tries to publish a \p block of elements. If blocks are published
-    //! out of order, they will be stashed.
+    //! out of order, they will be stashed. If the stash is full, the caller
+    //! is blocked like in publish().
     void tryPublish(const Block& block);
 
+    //! Splits a block of \p numElements elements off the front of the
+    //! claimed \p block, which is shrunk accordingly. The consumer sees the
+    //! split blocks one after the other but they are published together
+    //! with the block as it has been claimed. The elements are rounded like
+    //! in claim().
+    Block split(Block& block, unsigned numElements) noexcept;
+
     // Consumer interface
 
     //! Waits until there is a range available for consumption.
     //! Returns the range of elements which can be consumed.
     Block wait() noexcept;
 
+    //! Waits like wait() but at most until the \p deadline. If a range is
+    //! available, it is stored in \p block and \p true is returned.
+    bool waitUntil(std::chrono::steady_clock::time_point deadline,
+                   Block& block) noexcept;
+
     //! Consumes the \p block of elements.
     void consume(Block block) noexcept;
 
+    //! Returns the block, which follows the \p block, without consuming
+    //! anything. The following block must have been published.
+    Block next(const Block& block) noexcept;
+
     // Data access
 
     //! Returns a pointer to the \p index-th element.
@@ -190,6 +240,14 @@ public:
 
     unsigned size() const noexcept;
 
+    //! Returns the maximum number of elements, which can be claimed at
+    //! once.
+    unsigned maxClaimSize() const noexcept;
+
+    //! Returns the number of elements, which have been claimed but not
+    //! consumed yet.
+    unsigned occupancy() const noexcept;
+
 private:
     //! The ring buffer's data.
     void* m_data;
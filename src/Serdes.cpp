@@ -44,9 +44,76 @@ namespace log11_detail
 
 bool SerdesOptions::isImmutable(const char* str) const noexcept
 {
-    return str == nullptr
-           || (uintptr_t(str) < immutableStringEnd
-               && uintptr_t(str) >= immutableStringBegin);
+    if (str == nullptr)
+        return true;
+
+    // Most strings are rejected by the bounding box already. A single range
+    // coincides with the bounding box.
+    auto address = uintptr_t(str);
+    if (address >= immutableStringEnd || address < immutableStringBegin)
+        return false;
+    if (numImmutableRanges <= 1)
+        return true;
+
+    for (unsigned idx = 0; idx < numImmutableRanges; ++idx)
+    {
+        if (address < immutableRanges[idx].begin)
+            return false;
+        if (address < immutableRanges[idx].end)
+            return true;
+    }
+    return false;
+}
+
+void SerdesOptions::setImmutableRange(uintptr_t begin, uintptr_t end) noexcept
+{
+    numImmutableRanges = 0;
+    immutableStringBegin = 0;
+    immutableStringEnd = 0;
+    addImmutableRange(begin, end);
+}
+
+bool SerdesOptions::addImmutableRange(uintptr_t begin, uintptr_t end) noexcept
+{
+    if (begin >= end)
+        return true;
+
+    // Merge all ranges which overlap or touch the new range.
+    unsigned idx = 0;
+    while (idx < numImmutableRanges && immutableRanges[idx].end < begin)
+        ++idx;
+    unsigned last = idx;
+    while (last < numImmutableRanges && immutableRanges[last].begin <= end)
+    {
+        if (immutableRanges[last].begin < begin)
+            begin = immutableRanges[last].begin;
+        if (immutableRanges[last].end > end)
+            end = immutableRanges[last].end;
+        ++last;
+    }
+
+    if (last == idx)
+    {
+        // Nothing to merge, so the new range has to be inserted at idx.
+        if (numImmutableRanges == maxImmutableRanges)
+            return false;
+        for (unsigned pos = numImmutableRanges; pos > idx; --pos)
+            immutableRanges[pos] = immutableRanges[pos - 1];
+        ++numImmutableRanges;
+    }
+    else
+    {
+        // The ranges [idx, last) are replaced by the merged one.
+        unsigned removed = last - idx - 1;
+        for (unsigned pos = idx + 1; pos + removed < numImmutableRanges; ++pos)
+            immutableRanges[pos] = immutableRanges[pos + removed];
+        numImmutableRanges -= removed;
+    }
+    immutableRanges[idx] = Range{begin, end};
+
+    immutableStringBegin = immutableRanges[0].begin;
+    immutableStringEnd = immutableRanges[numImmutableRanges - 1].end;
+    return true;
 }
 
 // ----=====================================================================----
@@ -81,12 +148,24 @@ bool FormatTupleSerdes::deserialize(
     if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
         return false;
 
-    SplitStringView str{nullptr, 0, nullptr, 0};
-    if (!static_cast<CharStarSerdes*>(serdes)->deserializeString(inStream, str))
-        return false;
-
-    outStream.m_sink->beginFormatTuple();
-    outStream << str;
+    // An immutable format string is passed on as such, so that the sink
+    // can put it into its string dictionary.
+    if (serdes == ImmutableCharStarSerdes::instance())
+    {
+        Immutable<const char*> str;
+        if (!inStream.read(&str, sizeof(Immutable<const char*>)))
+            return false;
+        outStream.m_sink->beginFormatTuple();
+        outStream << str;
+    }
+    else
+    {
+        SplitStringView str{nullptr, 0, nullptr, 0};
+        if (!static_cast<CharStarSerdes*>(serdes)->deserializeString(inStream, str))
+            return false;
+        outStream.m_sink->beginFormatTuple();
+        outStream << str;
+    }
     for (;;)
     {
         if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
@@ -112,6 +191,19 @@ bool FormatTupleSerdes::deserialize(
     if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
         return false;
 
+    // Immutable format strings are looked up in the format cache.
+    if (serdes == ImmutableCharStarSerdes::instance())
+    {
+        Immutable<const char*> str;
+        if (!inStream.read(&str, sizeof(Immutable<const char*>)))
+            return false;
+
+        outStream.doFormat(str,
+                           log11_detail::ArgumentForwarder<RingBuffer::Stream>(
+                               outStream, inStream));
+        return true;
+    }
+
     SplitStringView str{nullptr, 0, nullptr, 0};
     if (!static_cast<CharStarSerdes*>(serdes)->deserializeString(inStream, str))
         return false;
@@ -122,6 +214,49 @@ bool FormatTupleSerdes::deserialize(
     return true;
 }
 
+// ----=====================================================================----
+//     KeyValueSerdes
+// ----=====================================================================----
+
+KeyValueSerdes* KeyValueSerdes::instance()
+{
+    static KeyValueSerdes serdes;
+    return &serdes;
+}
+
+bool KeyValueSerdes::deserialize(
+        RingBuffer::Stream& inStream, BinaryStream& outStream) const noexcept
+{
+    const char* key;
+    if (!inStream.read(&key, sizeof(const char*)))
+        return false;
+
+    SerdesBase* serdes;
+    if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
+        return false;
+
+    outStream.m_sink->beginField();
+    outStream << key;
+    return serdes->deserialize(inStream, outStream);
+}
+
+bool KeyValueSerdes::deserialize(
+        RingBuffer::Stream& inStream, TextStream& outStream) const noexcept
+{
+    const char* key;
+    if (!inStream.read(&key, sizeof(const char*)))
+        return false;
+
+    SerdesBase* serdes;
+    if (!inStream.read(&serdes, sizeof(void*)) || !serdes)
+        return false;
+
+    outStream.beginField(key);
+    bool result = serdes->deserialize(inStream, outStream);
+    outStream.endField();
+    return result;
+}
+
 // ----=====================================================================----
 //     CharStarSerdes
 // ----=====================================================================----
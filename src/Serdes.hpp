@@ -49,10 +49,32 @@ namespace log11_detail
 
 struct SerdesOptions
 {
+    //! The maximum number of immutable string ranges.
+    static constexpr unsigned maxImmutableRanges = 8;
+
+    struct Range
+    {
+        std::uintptr_t begin;
+        std::uintptr_t end;
+    };
+
     bool isImmutable(const char* str) const noexcept;
 
+    //! Replaces all immutable ranges by <tt>[begin, end)</tt>.
+    void setImmutableRange(std::uintptr_t begin, std::uintptr_t end) noexcept;
+
+    //! Adds the immutable range <tt>[begin, end)</tt>. Overlapping and
+    //! adjacent ranges are merged. Returns false if there is no room for
+    //! another range.
+    bool addImmutableRange(std::uintptr_t begin, std::uintptr_t end) noexcept;
+
+    //! The bounding box of all immutable ranges.
     std::uintptr_t immutableStringBegin{0};
     std::uintptr_t immutableStringEnd{0};
+
+    //! The immutable ranges sorted by their begin address.
+    Range immutableRanges[maxImmutableRanges];
+    unsigned numImmutableRanges{0};
 };
 
 class SerdesBase
@@ -230,6 +252,120 @@ public:
     bool deserializeString(RingBuffer::Stream& inStream, SplitStringView& str) const noexcept override;
 };
 
+// Serializer for a string reference. The string is stored in the same way
+// as a mutable C-string, so it is deserialized by the MutableCharStarSerdes.
+class StringRefSerdes
+{
+public:
+    static
+    std::size_t requiredSize(const SerdesOptions&, const StringRef& str) noexcept
+    {
+        return sizeof(void*) + sizeof(std::uint16_t) + clippedSize(str);
+    }
+
+    static
+    bool serialize(const SerdesOptions&, RingBuffer::Stream& stream,
+                   const StringRef& str) noexcept
+    {
+        SerdesBase* serdes = MutableCharStarSerdes::instance();
+        std::uint16_t length = clippedSize(str);
+        return stream.write(&serdes, sizeof(void*))
+                && stream.write(&length, sizeof(std::uint16_t))
+                && stream.writeString(str.data, length);
+    }
+
+private:
+    static
+    std::uint16_t clippedSize(const StringRef& str) noexcept
+    {
+        return str.size < UINT16_MAX ? str.size : UINT16_MAX;
+    }
+};
+
+// Serializer for an array of arithmetic values. The elements are copied
+// into the ring buffer with a single write.
+template <typename T>
+class ArraySerdes : public SerdesBase
+{
+public:
+    static
+    ArraySerdes* instance()
+    {
+        static ArraySerdes serdes;
+        return &serdes;
+    }
+
+    static
+    std::size_t requiredSize(const SerdesOptions&,
+                             const ArrayRef<T>& array) noexcept
+    {
+        return sizeof(void*) + sizeof(std::uint16_t)
+               + clippedSize(array) * sizeof(T);
+    }
+
+    static
+    bool serialize(const SerdesOptions&, RingBuffer::Stream& stream,
+                   const ArrayRef<T>& array) noexcept
+    {
+        SerdesBase* serdes = instance();
+        std::uint16_t size = clippedSize(array);
+        return stream.write(&serdes, sizeof(void*))
+               && stream.write(&size, sizeof(std::uint16_t))
+               && stream.write(array.data, size * sizeof(T));
+    }
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     BinaryStream& outStream) const noexcept override
+    {
+        std::uint16_t size;
+        if (!inStream.read(&size, sizeof(std::uint16_t)))
+            return false;
+
+        SplitStringView data{nullptr, 0, nullptr, 0};
+        if (inStream.readString(data, size * sizeof(T)) != size * sizeof(T))
+            return false;
+
+        outStream.m_sink->writeArray(arrayElementType<T>(), size, data);
+        return true;
+    }
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     TextStream& outStream) const noexcept override
+    {
+        std::uint16_t size;
+        if (!inStream.read(&size, sizeof(std::uint16_t)))
+            return false;
+
+        // The format applies to every element.
+        auto format = outStream.m_format;
+        outStream.m_sink->writeChar('[');
+        for (unsigned idx = 0; idx < size; ++idx)
+        {
+            T value;
+            if (!inStream.read(&value, sizeof(T)))
+                return false;
+            if (idx)
+                outStream.m_sink->writeString(", ", 2);
+            outStream.m_format = format;
+            outStream << value;
+        }
+        outStream.m_sink->writeChar(']');
+        outStream.reset();
+        return true;
+    }
+
+private:
+    // The elements must fit into the 16-bit length of a format tuple.
+    static
+    std::uint16_t clippedSize(const ArrayRef<T>& array) noexcept
+    {
+        return array.size < UINT16_MAX / sizeof(T)
+               ? array.size : UINT16_MAX / sizeof(T);
+    }
+};
+
 // Serializer for a format tuple, i.e. (const char* format, args...).
 class FormatTupleSerdes : public SerdesBase
 {
@@ -299,6 +435,43 @@ public:
                      TextStream& outStream) const noexcept override;
 };
 
+// Serializer for a structured field, i.e. (const char* key, value).
+class KeyValueSerdes : public SerdesBase
+{
+public:
+    static
+    KeyValueSerdes* instance();
+
+    template <typename T>
+    static
+    std::size_t requiredSize(const SerdesOptions& opt,
+                             const KeyValue<T>& field) noexcept
+    {
+        return sizeof(void*)
+               + sizeof(const char*)
+               + SerdesVisitor::requiredSize(opt, field.value);
+    }
+
+    template <typename T>
+    static
+    bool serialize(const SerdesOptions& opt, RingBuffer::Stream& stream,
+                   const KeyValue<T>& field) noexcept
+    {
+        SerdesBase* serdes = instance();
+        return stream.write(&serdes, sizeof(void*))
+               && stream.write(&field.key, sizeof(const char*))
+               && SerdesVisitor::serialize(opt, stream, field.value);
+    }
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     BinaryStream& outStream) const noexcept override;
+
+    virtual
+    bool deserialize(RingBuffer::Stream& inStream,
+                     TextStream& outStream) const noexcept override;
+};
+
 // ----=====================================================================----
 //     SerdesSelector
 // ----=====================================================================----
@@ -332,12 +505,30 @@ struct SerdesSelector<T*> : public PointerSerdesSelector<std::remove_cv_t<T>>
 {
 };
 
+template <>
+struct SerdesSelector<StringRef>
+{
+    using type = StringRefSerdes;
+};
+
+template <typename T>
+struct SerdesSelector<ArrayRef<T>>
+{
+    using type = ArraySerdes<T>;
+};
+
 template <typename... T>
 struct SerdesSelector<FormatTuple<T...>>
 {
     using type = FormatTupleSerdes;
 };
 
+template <typename T>
+struct SerdesSelector<KeyValue<T>>
+{
+    using type = KeyValueSerdes;
+};
+
 template <typename T>
 using serdes_t = typename SerdesSelector<std::decay_t<T>>::type;
 
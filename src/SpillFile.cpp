@@ -0,0 +1,195 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "SpillFile.hpp"
+#include "BinaryStream.hpp"
+#include "Serdes.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+namespace
+{
+
+//! The maximum size of a record in the replay buffer. It is limited by the
+//! 16-bit length of a block in the ring buffer.
+constexpr unsigned maxRecordSize = 0xFFFF;
+
+//! The maximum size of a record in the file. It leaves room for the header
+//! of the record in the replay buffer.
+constexpr unsigned maxSpilledRecordSize = maxRecordSize - 64;
+
+} // anonymous namespace
+
+// ----=====================================================================----
+//     SpillFile
+// ----=====================================================================----
+
+SpillFile::SpillFile(FILE* file, const char* path)
+    : m_file(file),
+      m_path(path),
+      m_readOffset(0),
+      m_writeOffset(0),
+      m_position(0),
+      m_isWriting(false),
+      m_record(maxRecordSize),
+      m_transferBuffer(new char[maxRecordSize]),
+      m_replayFifo(maxRecordSize + 1)
+{
+    setEnabled(true);
+    setLevel(Severity::Trace);
+    setBlockSize(0);
+}
+
+SpillFile::~SpillFile()
+{
+    delete[] m_transferBuffer;
+    if (m_file)
+        fclose(m_file);
+}
+
+bool SpillFile::append(const LogRecordData& record, RingBuffer::Stream stream,
+                       SerdesOptions& options)
+{
+    if (!m_file)
+        return false;
+
+    m_record.clear();
+    beginLogEntry(record);
+    BinaryStream outStream(*this, options);
+    for (;;)
+    {
+        SerdesBase* serdes;
+        if (!stream.read(&serdes, sizeof(void*)) || !serdes)
+            break;
+        serdes->deserialize(stream, outStream);
+    }
+    endLogEntry(record);
+
+    if (m_record.size() > maxSpilledRecordSize || !seek(m_writeOffset, true))
+        return false;
+    // The record is flushed, so it is not lost if the process crashes.
+    if (   fwrite(m_record.data(), 1, m_record.size(), m_file) != m_record.size()
+        || fflush(m_file) != 0)
+    {
+        // Forget the partial record.
+        clearerr(m_file);
+        m_position = -1;
+        return false;
+    }
+
+    m_writeOffset += m_record.size();
+    m_position = m_writeOffset;
+    return true;
+}
+
+uint64_t SpillFile::pendingSize() const noexcept
+{
+    return m_writeOffset - m_readOffset;
+}
+
+bool SpillFile::readNext(DecodedRecord& record) noexcept
+{
+    if (!hasPending())
+        return false;
+
+    // A record is never larger than the transfer buffer, so the next
+    // record is complete.
+    size_t size = pendingSize() < maxRecordSize ? pendingSize()
+                                                : maxRecordSize;
+    if (   !seek(m_readOffset, false)
+        || fread(m_transferBuffer, 1, size, m_file) != size)
+    {
+        // The rest of the file cannot be read, so it is given up.
+        clearerr(m_file);
+        clear();
+        return false;
+    }
+    m_position = m_readOffset + size;
+
+    m_decoder.setData(m_transferBuffer, size);
+    if (m_decoder.next(record) != BinaryDecoder::Status::Ok)
+    {
+        clear();
+        return false;
+    }
+    m_readOffset += m_decoder.position();
+
+    // Start over when all records have been read.
+    if (m_readOffset == m_writeOffset)
+        clear();
+    return true;
+}
+
+void SpillFile::writeByte(byte data)
+{
+    m_record.push(static_cast<char>(data));
+}
+
+void SpillFile::writeBytes(const byte* data, unsigned size)
+{
+    m_record.push(reinterpret_cast<const char*>(data), size);
+}
+
+void SpillFile::write(Immutable<const char*> str,
+                      uintptr_t /*immutableStringSpaceBegin*/)
+{
+    size_t length = str.get() ? strlen(str.get()) : 0;
+    BinarySink::write(SplitStringView{str.get(), length, nullptr, 0});
+}
+
+bool SpillFile::seek(long offset, bool write) noexcept
+{
+    // Reading and writing must be separated by a seek.
+    if (m_position == offset && m_isWriting == write)
+        return true;
+    if (fseek(m_file, offset, SEEK_SET) != 0)
+        return false;
+    m_position = offset;
+    m_isWriting = write;
+    return true;
+}
+
+void SpillFile::clear() noexcept
+{
+    m_readOffset = m_writeOffset = 0;
+    m_position = 0;
+    m_isWriting = false;
+    m_file = freopen(m_path.c_str(), "w+b", m_file);
+}
+
+} // namespace log11_detail
+} // namespace log11
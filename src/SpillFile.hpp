@@ -0,0 +1,149 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_SPILLFILE_HPP
+#define LOG11_SPILLFILE_HPP
+
+#include "BinaryDecoder.hpp"
+#include "BinarySink.hpp"
+#include "RingBuffer.hpp"
+#include "Utility.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+
+namespace log11
+{
+namespace log11_detail
+{
+
+//! \brief An overflow file for log records.
+//!
+//! The spill file takes records from a ring buffer and appends them to a
+//! file in the format of the BinarySink. Immutable strings are copied
+//! into the records instead of being referenced by a string dictionary
+//! and there are no block headers. So every record is self-contained and
+//! the file can be read with a BinaryDecoder, even after the process,
+//! which has written it, has terminated.
+//!
+//! The records are read back in the same order. When all records have been
+//! read, the file is truncated, so it only grows as long as records are
+//! pending.
+class SpillFile : public BinarySink
+{
+public:
+    //! Creates a spill file, which takes ownership of the \p file. The
+    //! file has been opened from the given \p path.
+    SpillFile(std::FILE* file, const char* path);
+
+    //! Closes the file.
+    virtual
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    //! Appends the \p record, whose arguments are read from the \p stream,
+    //! to the file. The serializers use the given \p options. Returns
+    //! \p false if the record could not be written. This is the case if
+    //! the encoded record is larger than a block of the replay buffer.
+    bool append(const LogRecordData& record, RingBuffer::Stream stream,
+                SerdesOptions& options);
+
+    //! Returns \p true if there are records, which have not been read back.
+    bool hasPending() const noexcept
+    {
+        return m_readOffset != m_writeOffset;
+    }
+
+    //! Returns the number of bytes, which have not been read back.
+    std::uint64_t pendingSize() const noexcept;
+
+    //! Reads the next record back. The encoded arguments of the \p record
+    //! stay valid until the next record is read. Returns \p false if there
+    //! is no record or it could not be read.
+    bool readNext(DecodedRecord& record) noexcept;
+
+    //! Returns the buffer, in which the replayed records are assembled.
+    RingBuffer& buffer() noexcept
+    {
+        return m_replayFifo;
+    }
+
+    virtual
+    void writeByte(byte data) override;
+
+    virtual
+    void writeBytes(const byte* data, unsigned size) override;
+
+protected:
+    using BinarySink::write;
+
+    //! Writes the immutable string \p str like a mutable string.
+    virtual
+    void write(Immutable<const char*> str,
+               std::uintptr_t immutableStringSpaceBegin) override;
+
+private:
+    //! The file.
+    std::FILE* m_file;
+    //! The path of the file.
+    std::string m_path;
+    //! The offset of the next record to read.
+    long m_readOffset;
+    //! The offset past the last record.
+    long m_writeOffset;
+    //! The current position of the file or -1 if it is unknown.
+    long m_position;
+    //! Set if the last access has been a write.
+    bool m_isWriting;
+    //! The record, which is being encoded.
+    ScratchPad m_record;
+    //! Takes the records while they are decoded.
+    char* m_transferBuffer;
+    //! Decodes the records in the transfer buffer.
+    BinaryDecoder m_decoder;
+    //! The buffer, in which the replayed records are assembled.
+    RingBuffer m_replayFifo;
+
+
+    //! Moves the file to the \p offset for writing if \p write is set and
+    //! for reading otherwise.
+    bool seek(long offset, bool write) noexcept;
+
+    //! Forgets all records and truncates the file.
+    void clear() noexcept;
+};
+
+} // namespace log11_detail
+} // namespace log11
+
+#endif // LOG11_SPILLFILE_HPP
@@ -0,0 +1,195 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#include "Statistics.hpp"
+
+#include <new>
+
+using namespace std;
+
+
+namespace log11
+{
+
+// ----=====================================================================----
+//     LogStatistics
+// ----=====================================================================----
+
+constexpr unsigned LogStatistics::numSeverities;
+
+uint64_t LogStatistics::totalDropped() const noexcept
+{
+    uint64_t sum = 0;
+    for (auto count : numDropped)
+        sum += count;
+    return sum;
+}
+
+uint64_t LogStatistics::totalTruncated() const noexcept
+{
+    uint64_t sum = 0;
+    for (auto count : numTruncated)
+        sum += count;
+    return sum;
+}
+
+namespace log11_detail
+{
+
+// ----=====================================================================----
+//     DropReport
+// ----=====================================================================----
+
+uint64_t DropReport::total() const noexcept
+{
+    uint64_t sum = 0;
+    for (auto count : numDropped)
+        sum += count;
+    return sum;
+}
+
+// ----=====================================================================----
+//     StatisticsCounters
+// ----=====================================================================----
+
+constexpr unsigned StatisticsCounters::numShards;
+constexpr unsigned StatisticsCounters::cacheLineSize;
+
+StatisticsCounters::StatisticsCounters() noexcept
+    : m_shards(*reinterpret_cast<Shard(*)[numShards]>(
+                   (reinterpret_cast<uintptr_t>(m_shardStorage) + cacheLineSize - 1)
+                   & ~uintptr_t(cacheLineSize - 1)))
+{
+    for (auto& shard : m_shards)
+    {
+        new (&shard) Shard;
+        shard.numRecords = 0;
+        shard.numBytes = 0;
+        for (auto& count : shard.numDropped)
+            count = 0;
+        for (auto& count : shard.numTruncated)
+            count = 0;
+        shard.numBlockedClaims = 0;
+        shard.blockedTime = 0;
+        shard.maxBlockedTime = 0;
+    }
+    m_hasNewDrops = false;
+    m_firstDropTime = 0;
+    m_lastDropTime = 0;
+    for (auto& count : m_reportedDrops)
+        count = 0;
+}
+
+void StatisticsCounters::countBlocked(chrono::nanoseconds time) noexcept
+{
+    auto& shard = m_shards[shardIndex()];
+    uint64_t nanoseconds = time.count();
+    shard.numBlockedClaims.fetch_add(1, memory_order_relaxed);
+    shard.blockedTime.fetch_add(nanoseconds, memory_order_relaxed);
+    uint64_t maximum = shard.maxBlockedTime.load(memory_order_relaxed);
+    while (nanoseconds > maximum
+           && !shard.maxBlockedTime.compare_exchange_weak(
+                  maximum, nanoseconds, memory_order_relaxed))
+    {
+    }
+}
+
+void StatisticsCounters::addTo(LogStatistics& statistics) const noexcept
+{
+    for (const auto& shard : m_shards)
+    {
+        statistics.numRecords += shard.numRecords.load(memory_order_relaxed);
+        statistics.numBytes += shard.numBytes.load(memory_order_relaxed);
+        for (unsigned idx = 0; idx < LogStatistics::numSeverities; ++idx)
+        {
+            statistics.numDropped[idx]
+                    += shard.numDropped[idx].load(memory_order_relaxed);
+            statistics.numTruncated[idx]
+                    += shard.numTruncated[idx].load(memory_order_relaxed);
+        }
+        statistics.numBlockedClaims
+                += shard.numBlockedClaims.load(memory_order_relaxed);
+        statistics.blockedTime += chrono::nanoseconds(
+                shard.blockedTime.load(memory_order_relaxed));
+        auto maximum = chrono::nanoseconds(
+                shard.maxBlockedTime.load(memory_order_relaxed));
+        if (maximum > statistics.maxBlockedTime)
+            statistics.maxBlockedTime = maximum;
+    }
+}
+
+bool StatisticsCounters::takeDropReport(DropReport& report) noexcept
+{
+    using namespace std::chrono;
+
+    if (!m_hasNewDrops.exchange(false, memory_order_acquire))
+        return false;
+
+    auto firstTime = m_firstDropTime.exchange(0, memory_order_relaxed);
+    auto lastTime = m_lastDropTime.load(memory_order_relaxed);
+    // A drop, which races with the previous report, may have been counted
+    // in it already but leaves its time behind.
+    if (firstTime == 0 || firstTime > lastTime)
+        firstTime = lastTime;
+    report.firstTime = high_resolution_clock::time_point(
+                           high_resolution_clock::duration(firstTime));
+    report.lastTime = high_resolution_clock::time_point(
+                          high_resolution_clock::duration(lastTime));
+
+    for (unsigned idx = 0; idx < LogStatistics::numSeverities; ++idx)
+    {
+        uint64_t dropped = 0;
+        for (const auto& shard : m_shards)
+            dropped += shard.numDropped[idx].load(memory_order_relaxed);
+        report.numDropped[idx] = dropped - m_reportedDrops[idx];
+        m_reportedDrops[idx] = dropped;
+    }
+    return report.total() != 0;
+}
+
+void StatisticsCounters::noteDrop() noexcept
+{
+    auto now = chrono::high_resolution_clock::now().time_since_epoch().count();
+    chrono::high_resolution_clock::rep expected = 0;
+    m_firstDropTime.compare_exchange_strong(expected, now,
+                                            memory_order_relaxed);
+    m_lastDropTime.store(now, memory_order_relaxed);
+    // Publish the counter, which has been incremented before.
+    m_hasNewDrops.store(true, memory_order_release);
+}
+
+unsigned StatisticsCounters::nextShardIndex() noexcept
+{
+    static atomic<unsigned> counter{0};
+    return counter.fetch_add(1, memory_order_relaxed) % numShards;
+}
+
+} // namespace log11_detail
+
+} // namespace log11
@@ -0,0 +1,266 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef LOG11_STATISTICS_HPP
+#define LOG11_STATISTICS_HPP
+
+#include "Severity.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace log11
+{
+
+//! \brief The overload level of a log core.
+//!
+//! The overload control of a log core raises the level as the pressure on
+//! the ring buffer rises. The higher the level, the more records of low
+//! severity are degraded in order to keep the producers running. Warnings
+//! and errors are never degraded.
+enum class OverloadLevel : std::uint8_t
+{
+    //! The records are logged as requested.
+    Normal,
+    //! Trace and debug records are discarded if the ring buffer is full
+    //! rather than blocking the caller.
+    Elevated,
+    //! Additionally, info records are truncated or discarded rather than
+    //! blocking the caller.
+    High,
+    //! Records below warnings are only logged if they leave a quarter of
+    //! the ring buffer free for warnings and errors.
+    Critical
+};
+
+//! \brief A snapshot of the statistics of a log core.
+//!
+//! The producer side counts the records which have been enqueued, dropped
+//! or truncated and the time spent waiting for space in the ring buffer.
+//! The consumer side tracks the occupancy of the ring buffer and the lag
+//! between the creation and the consumption of a record.
+struct LogStatistics
+{
+    //! The number of severities.
+    static constexpr unsigned numSeverities = 5;
+
+    //! The number of records which have been enqueued.
+    std::uint64_t numRecords = 0;
+    //! The number of bytes which have been enqueued.
+    std::uint64_t numBytes = 0;
+    //! The number of dropped records per severity.
+    std::uint64_t numDropped[numSeverities] = {};
+    //! The number of truncated records per severity.
+    std::uint64_t numTruncated[numSeverities] = {};
+
+    //! The number of claims which had to wait for free space.
+    std::uint64_t numBlockedClaims = 0;
+    //! The total time producers have waited for free space.
+    std::chrono::nanoseconds blockedTime{0};
+    //! The longest time a producer has waited for free space.
+    std::chrono::nanoseconds maxBlockedTime{0};
+
+    //! The number of records which have been consumed.
+    std::uint64_t numConsumed = 0;
+    //! The lag of the most recently consumed record.
+    std::chrono::nanoseconds consumerLag{0};
+    //! The maximum lag of a consumed record.
+    std::chrono::nanoseconds maxConsumerLag{0};
+
+    //! The size of the ring buffer in bytes.
+    std::size_t bufferSize = 0;
+    //! The number of bytes in the ring buffer when the consumer last
+    //! looked at it.
+    std::size_t bufferOccupancy = 0;
+    //! The maximum number of bytes the consumer has seen in the ring buffer.
+    std::size_t bufferHighWaterMark = 0;
+
+    //! The number of records which have been moved to the spill file.
+    std::uint64_t numSpilled = 0;
+    //! The number of bytes in the spill file, which have not been written
+    //! to the sinks yet.
+    std::uint64_t spillBacklog = 0;
+
+    //! The number of records which have been suppressed as repeats.
+    std::uint64_t numRepeats = 0;
+
+    //! The number of records which the flight recorder has retained and
+    //! discarded without writing them.
+    std::uint64_t numRetainedDiscarded = 0;
+
+    //! The current overload level.
+    OverloadLevel overloadLevel = OverloadLevel::Normal;
+    //! The number of changes of the overload level.
+    std::uint64_t numOverloadTransitions = 0;
+
+    //! Returns the number of dropped records of all severities.
+    std::uint64_t totalDropped() const noexcept;
+
+    //! Returns the number of truncated records of all severities.
+    std::uint64_t totalTruncated() const noexcept;
+};
+
+namespace log11_detail
+{
+
+//! \brief The records which have been dropped since the last report.
+struct DropReport
+{
+    //! The number of dropped records per severity.
+    std::uint64_t numDropped[LogStatistics::numSeverities] = {};
+    //! The time of the first drop.
+    std::chrono::high_resolution_clock::time_point firstTime;
+    //! The time of the last drop.
+    std::chrono::high_resolution_clock::time_point lastTime;
+
+    //! Returns the number of dropped records of all severities.
+    std::uint64_t total() const noexcept;
+};
+
+//! \brief Counters for the producer side of the statistics.
+//!
+//! The counters are split into shards. Every thread updates the shard,
+//! which has been assigned to it on its first use. This avoids contention
+//! between the producers in the common case.
+class StatisticsCounters
+{
+public:
+    StatisticsCounters() noexcept;
+
+    StatisticsCounters(const StatisticsCounters&) = delete;
+    StatisticsCounters& operator=(const StatisticsCounters&) = delete;
+
+    //! Counts a record of \p size bytes.
+    void countRecord(Severity severity, std::size_t size,
+                     bool isTruncated) noexcept
+    {
+        auto& shard = m_shards[shardIndex()];
+        shard.numRecords.fetch_add(1, std::memory_order_relaxed);
+        shard.numBytes.fetch_add(size, std::memory_order_relaxed);
+        if (isTruncated)
+        {
+            shard.numTruncated[static_cast<unsigned>(severity)].fetch_add(
+                        1, std::memory_order_relaxed);
+        }
+    }
+
+    //! Counts \p count dropped records.
+    void countDropped(Severity severity, std::uint64_t count = 1) noexcept
+    {
+        m_shards[shardIndex()].numDropped[static_cast<unsigned>(severity)]
+                .fetch_add(count, std::memory_order_relaxed);
+        noteDrop();
+    }
+
+    //! Counts a claim, which had to wait for the given \p time.
+    void countBlocked(std::chrono::nanoseconds time) noexcept;
+
+    //! Adds the counters to the \p statistics.
+    void addTo(LogStatistics& statistics) const noexcept;
+
+    //! Returns \p true if records have been dropped since the last report.
+    bool hasNewDrops() const noexcept
+    {
+        return m_hasNewDrops.load(std::memory_order_relaxed);
+    }
+
+    //! Returns the time of the first drop since the last report.
+    std::chrono::high_resolution_clock::time_point firstDropTime() const noexcept
+    {
+        using namespace std::chrono;
+        return high_resolution_clock::time_point(high_resolution_clock::duration(
+                    m_firstDropTime.load(std::memory_order_relaxed)));
+    }
+
+    //! Fills the \p report with the records, which have been dropped since
+    //! the last report. Returns \p false if there are none. Must only be
+    //! called from the consumer thread.
+    bool takeDropReport(DropReport& report) noexcept;
+
+private:
+    static constexpr unsigned numShards = 16;
+    static constexpr unsigned cacheLineSize = 64;
+
+    //! Every shard starts on a cache line of its own and is padded to two
+    //! cache lines, so that the shards of different threads do not share a
+    //! cache line. The alignment is not left to alignas() because the
+    //! operator new of C++14 ignores it for a LogCore on the heap.
+    struct Shard
+    {
+        std::atomic<std::uint64_t> numRecords;
+        std::atomic<std::uint64_t> numBytes;
+        std::atomic<std::uint64_t> numDropped[LogStatistics::numSeverities];
+        std::atomic<std::uint64_t> numTruncated[LogStatistics::numSeverities];
+        std::atomic<std::uint64_t> numBlockedClaims;
+        std::atomic<std::uint64_t> blockedTime;
+        std::atomic<std::uint64_t> maxBlockedTime;
+        char padding[128 - (5 + 2 * LogStatistics::numSeverities)
+                           * sizeof(std::uint64_t)];
+    };
+
+    static_assert(sizeof(Shard) == 2 * cacheLineSize,
+                  "A shard must fill two cache lines.");
+
+    //! The storage of the shards with room for aligning them.
+    char m_shardStorage[numShards * sizeof(Shard) + cacheLineSize - 1];
+    //! The shards, which start at the first cache line in the storage.
+    Shard (&m_shards)[numShards];
+
+    //! Set by a producer when it drops a record.
+    std::atomic<bool> m_hasNewDrops;
+    //! The time of the first and the last drop since the last report.
+    std::atomic<std::chrono::high_resolution_clock::rep> m_firstDropTime;
+    std::atomic<std::chrono::high_resolution_clock::rep> m_lastDropTime;
+    //! The number of dropped records, which have already been reported.
+    std::uint64_t m_reportedDrops[LogStatistics::numSeverities];
+
+    //! Records the time of a drop and flags it for the consumer.
+    void noteDrop() noexcept;
+
+
+    //! Returns the index of the calling thread's shard.
+    static
+    unsigned shardIndex() noexcept
+    {
+        static thread_local unsigned index = nextShardIndex();
+        return index;
+    }
+
+    static
+    unsigned nextShardIndex() noexcept;
+};
+
+} // namespace log11_detail
+
+} // namespace log11
+
+#endif // LOG11_STATISTICS_HPP
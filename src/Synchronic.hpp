@@ -36,13 +36,40 @@
 #if defined(LOG11_USE_WEOS)
 
 #include <weos/synchronic.hpp>
+#include <weos/thread.hpp>
+
+#include <chrono>
 
 namespace log11
 {
 namespace log11_detail
 {
 
-using weos::synchronic;
+//! Extends the WEOS synchronic by a wait with a deadline.
+template <typename T>
+class synchronic : public weos::synchronic<T>
+{
+public:
+    using atomic_type = typename weos::synchronic<T>::atomic_type;
+
+    synchronic() = default;
+
+    //! Waits until the predicate \p pred is satisfied or the \p deadline
+    //! has passed. Returns the value of the predicate. The WEOS synchronic
+    //! has no timed wait, so the predicate is polled once per millisecond.
+    template <typename F, typename TClock, typename TDuration>
+    bool expect_until(const atomic_type& /*object*/, F&& pred,
+                      const std::chrono::time_point<TClock, TDuration>& deadline) const
+    {
+        while (!pred())
+        {
+            if (TClock::now() >= deadline)
+                return pred();
+            weos::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
 
 } // namespace log11_detail
 } // namespace log11
@@ -50,6 +77,7 @@ using weos::synchronic;
 #else
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
@@ -100,6 +128,14 @@ public:
         m_cv.wait(lock, std::forward<F>(pred));
     }
 
+    template <typename F, typename TClock, typename TDuration>
+    bool expect_until(const atomic_type& /*object*/, F&& pred,
+                      const std::chrono::time_point<TClock, TDuration>& deadline) const
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return m_cv.wait_until(lock, deadline, std::forward<F>(pred));
+    }
+
 private:
     mutable std::mutex m_mutex;
     mutable std::condition_variable m_cv;
@@ -28,6 +28,7 @@
 *******************************************************************************/
 
 #include "TextSink.hpp"
+#include "CharacterScan.hpp"
 
 using namespace log11;
 
@@ -38,7 +39,63 @@ void TextSink::writeString(const char* text, std::size_t size)
         writeChar(*text++);
 }
 
+void TextSink::setFieldStyle(FieldStyle style) noexcept
+{
+    m_fieldStyle = style;
+}
+
+auto TextSink::fieldStyle() const noexcept -> FieldStyle
+{
+    return m_fieldStyle;
+}
+
 void TextSink::writeHeader(const char* header, std::size_t size)
 {
     writeString(header, size);
 }
+
+void TextSink::beginField(const char* key, std::size_t size, unsigned index)
+{
+    if (fieldStyle() == FieldStyle::Json)
+    {
+        if (index == 0)
+            writeString(" {\"", 3);
+        else
+            writeString(",\"", 2);
+        writeEscaped(key, size);
+        writeString("\":", 2);
+    }
+    else
+    {
+        writeChar(' ');
+        writeString(key, size);
+        writeChar('=');
+    }
+}
+
+void TextSink::endField()
+{
+}
+
+void TextSink::endFields(unsigned count)
+{
+    if (count && fieldStyle() == FieldStyle::Json)
+        writeChar('}');
+}
+
+void TextSink::writeEscaped(const char* text, std::size_t size)
+{
+    const char* end = text + size;
+    for (;;)
+    {
+        const char* special = log11_detail::findJsonSpecialCharacter(text, end);
+        if (special != text)
+            writeString(text, special - text);
+        if (special == end)
+            break;
+
+        char escaped[6];
+        writeString(escaped, log11_detail::escapeJsonCharacter(*special, escaped));
+        text = special + 1;
+    }
+}
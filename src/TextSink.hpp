@@ -34,6 +34,7 @@
 #include "Severity.hpp"
 #include "SinkBase.hpp"
 
+#include <atomic>
 #include <cstddef>
 
 
@@ -47,6 +48,22 @@ namespace log11
 class TextSink : public SinkBase
 {
 public:
+    //! The style in which structured fields are rendered.
+    enum class FieldStyle : unsigned char
+    {
+        Logfmt, //!< Fields are appended as <tt>key=value</tt>.
+        Json    //!< Fields are appended as <tt>{"key":value}</tt>.
+    };
+
+    //! \brief Sets the style of structured fields.
+    //!
+    //! Sets the style in which fields created with kv() are rendered to
+    //! \p style. By default, fields are rendered in the logfmt style.
+    void setFieldStyle(FieldStyle style) noexcept;
+
+    //! \brief Returns the style of structured fields.
+    FieldStyle fieldStyle() const noexcept;
+
     //! Outputs the single character \p ch.
     virtual
     void writeChar(char ch) = 0;
@@ -65,6 +82,42 @@ public:
     //! implementation calls writeString().
     virtual
     void writeHeader(const char* header, std::size_t size);
+
+    //! \brief Starts a structured field.
+    //!
+    //! Writes the \p key of a structured field, which is a string of length
+    //! \p size. The \p index is the zero-based position of the field within
+    //! the current record. The value of the field is output afterwards.
+    //! The default implementation renders the key according to the
+    //! fieldStyle().
+    virtual
+    void beginField(const char* key, std::size_t size, unsigned index);
+
+    //! \brief Finishes a structured field.
+    //!
+    //! This function is called after the value of a field has been written.
+    //! The default implementation does nothing.
+    virtual
+    void endField();
+
+    //! \brief Finishes the structured fields of a record.
+    //!
+    //! This function is called after the last argument of a record has
+    //! been written. The \p count is the number of fields in the record
+    //! and may be zero. The default implementation closes the JSON object
+    //! if the record contained fields.
+    virtual
+    void endFields(unsigned count);
+
+    //! \brief Outputs an escaped string.
+    //!
+    //! Outputs the string \p text of length \p size as the contents of a
+    //! JSON string, i.e. quotes, backslashes and control characters are
+    //! escaped. The surrounding quotes are not written.
+    void writeEscaped(const char* text, std::size_t size);
+
+private:
+    std::atomic<FieldStyle> m_fieldStyle{FieldStyle::Logfmt};
 };
 
 } // namespace log11
@@ -28,9 +28,12 @@
 *******************************************************************************/
 
 #include "TextStream.hpp"
+#include "FloatFormatting.hpp"
+#include "FormatCache.hpp"
 #include "Serdes.hpp"
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -90,6 +93,14 @@ void ArgumentForwarder<RingBuffer::Stream>::printRest()
     log11_detail::SerdesBase* serdes;
     while (m_inStream.read(&serdes, sizeof(void*)) && serdes)
     {
+        // Structured fields are not enclosed in angle brackets.
+        if (serdes == KeyValueSerdes::instance())
+        {
+            if (!serdes->deserialize(m_inStream, m_outStream))
+                break;
+            continue;
+        }
+
         m_outStream << ' ' << '<';
         bool result = serdes->deserialize(m_inStream, m_outStream);
         m_outStream << '>';
@@ -100,6 +111,118 @@ void ArgumentForwarder<RingBuffer::Stream>::printRest()
 
 } // namespace log11_detail
 
+namespace
+{
+
+// ----=====================================================================----
+//     Integer conversion
+// ----=====================================================================----
+
+using max_int_type = unsigned long long;
+
+//! The decimal representation of the numbers 0 to 99.
+const char decimalDigitPairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+//! Returns the number of bits needed to represent the \p value. Zero
+//! needs one bit.
+inline
+int bitLength(max_int_type value) noexcept
+{
+#if defined(__GNUC__)
+    return 64 - __builtin_clzll(value | 1);
+#else
+    int length = 1;
+    for (int shift = 32; shift > 0; shift /= 2)
+    {
+        if (value >> shift)
+        {
+            value >>= shift;
+            length += shift;
+        }
+    }
+    return length;
+#endif
+}
+
+//! Returns the number of digits of the \p value in base \p TBase.
+template <unsigned char TBase>
+int countDigits(max_int_type value) noexcept
+{
+    static_assert(TBase == 2 || TBase == 8 || TBase == 16, "Invalid base");
+    const int bitsPerDigit = TBase == 2 ? 1 : (TBase == 8 ? 3 : 4);
+    return (bitLength(value) + bitsPerDigit - 1) / bitsPerDigit;
+}
+
+template <>
+int countDigits<10>(max_int_type value) noexcept
+{
+    static const max_int_type powersOfTen[] = {
+        0,
+        10ull,
+        100ull,
+        1000ull,
+        10000ull,
+        100000ull,
+        1000000ull,
+        10000000ull,
+        100000000ull,
+        1000000000ull,
+        10000000000ull,
+        100000000000ull,
+        1000000000000ull,
+        10000000000000ull,
+        100000000000000ull,
+        1000000000000000ull,
+        10000000000000000ull,
+        100000000000000000ull,
+        1000000000000000000ull,
+        10000000000000000000ull
+    };
+
+    // 1233 / 4096 approximates log10(2). The guess is either correct or
+    // one too small.
+    int guess = (bitLength(value) * 1233) >> 12;
+    return guess + 1 - (value < powersOfTen[guess]);
+}
+
+//! Writes the last \p numDigits digits of the \p value in base \p TBase
+//! to the buffer starting at \p begin.
+template <unsigned char TBase>
+void formatDigits(max_int_type value, char* begin, int numDigits,
+                  bool upperCase) noexcept
+{
+    static_assert(TBase == 2 || TBase == 8 || TBase == 16, "Invalid base");
+    const int bitsPerDigit = TBase == 2 ? 1 : (TBase == 8 ? 3 : 4);
+    const char* digits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    for (char* iter = begin + numDigits; iter != begin; value >>= bitsPerDigit)
+        *--iter = digits[value & (TBase - 1)];
+}
+
+template <>
+void formatDigits<10>(max_int_type value, char* begin, int numDigits,
+                      bool /*upperCase*/) noexcept
+{
+    char* iter = begin + numDigits;
+    while (iter - begin >= 2)
+    {
+        const char* pair = decimalDigitPairs + 2 * (value % 100);
+        value /= 100;
+        iter -= 2;
+        iter[0] = pair[0];
+        iter[1] = pair[1];
+    }
+    if (iter != begin)
+        *--iter = char('0' + value);
+}
+
+} // anonymous namespace
+
 // ----=====================================================================----
 //     TextStream::Format
 // ----=====================================================================----
@@ -197,12 +320,51 @@ const char* TextStream::Format::parse(const char* str)
 //     TextStream
 // ----=====================================================================----
 
-TextStream::TextStream(TextSink& sink, log11_detail::ScratchPad& scratchPad)
+TextStream::TextStream(TextSink& sink, log11_detail::ScratchPad& scratchPad,
+                       log11_detail::FormatCache* formatCache)
     : m_sink(&sink),
-      m_scratchPad(scratchPad)
+      m_scratchPad(scratchPad),
+      m_formatCache(formatCache),
+      m_numFields(0),
+      m_inField(false)
 {
 }
 
+void TextStream::doFormat(
+        Immutable<const char*> str,
+        log11_detail::ArgumentForwarder<RingBuffer::Stream>&& args)
+{
+    const char* fmt = str.get();
+    const log11_detail::FormatCache::Entry* cached
+            = m_formatCache ? m_formatCache->lookup(fmt) : nullptr;
+    if (!cached)
+    {
+        doFormat(SplitStringView{fmt, strlen(fmt), nullptr, 0},
+                 std::move(args));
+        return;
+    }
+
+    // An argument can be a format tuple itself, whose lookup might evict
+    // the cached entry. So we work on a copy.
+    log11_detail::FormatCache::Entry entry;
+    memcpy(&entry, cached,
+                offsetof(log11_detail::FormatCache::Entry, fields)
+                + cached->numFields * sizeof(log11_detail::FormatCache::Field));
+
+    for (unsigned idx = 0; idx < entry.numFields; ++idx)
+    {
+        const auto& field = entry.fields[idx];
+        if (field.literalLength)
+            m_sink->writeString(fmt + field.literalOffset, field.literalLength);
+        m_format = field.format;
+        args.printNext();
+    }
+    if (entry.tailLength)
+        m_sink->writeString(fmt + entry.tailOffset, entry.tailLength);
+
+    args.printRest();
+}
+
 // -----------------------------------------------------------------------------
 //     Bool & char printing
 // -----------------------------------------------------------------------------
@@ -228,6 +390,13 @@ void TextStream::write(char ch)
     if (m_format.align == Format::AutoAlign)
         m_format.align = Format::Left;
 
+    if (m_inField)
+    {
+        printFieldString(SplitStringView{&ch, 1, nullptr, 0});
+        reset();
+        return;
+    }
+
     int padding = m_format.minWidth - 1;
     padding = printPrePaddingAndSign(padding, false, Format::NoType);
     m_sink->writeChar(ch);
@@ -345,12 +514,22 @@ void TextStream::write(const void* value)
     if (m_format.align == Format::AutoAlign)
         m_format.align = Format::Right;
     int padding = m_format.minWidth - 2 - 2 * sizeof(void*);
+    bool quoted = m_inField
+                  && m_sink->fieldStyle() == TextSink::FieldStyle::Json;
+    if (quoted)
+        m_sink->writeChar('"');
     padding = printPrePaddingAndSign(padding, false, Format::NoType);
 
-    m_sink->writeString("0x", 2);
-    printIntegerDigits<16>(uintptr_t(value), uintptr_t(1) << (sizeof(void*) * 8 - 4));
+    char buffer[2 + 2 * sizeof(void*)];
+    buffer[0] = '0';
+    buffer[1] = 'x';
+    formatDigits<16>(uintptr_t(value), buffer + 2, 2 * sizeof(void*),
+                     m_format.upperCase);
+    m_sink->writeString(buffer, sizeof(buffer));
 
     printPostPadding(padding);
+    if (quoted)
+        m_sink->writeChar('"');
     reset();
 }
 
@@ -362,7 +541,10 @@ void TextStream::write(const char* str)
 {
     // TODO: padding
 
-    m_sink->writeString(str, std::strlen(str));
+    if (m_inField)
+        printFieldString(SplitStringView{str, std::strlen(str), nullptr, 0});
+    else
+        m_sink->writeString(str, std::strlen(str));
     reset();
 }
 
@@ -375,51 +557,50 @@ void TextStream::write(const SplitStringView& str)
 {
     // TODO: padding
 
-    if (str.length1)
-        m_sink->writeString(str.begin1, str.length1);
-    if (str.length2)
-        m_sink->writeString(str.begin2, str.length2);
+    if (m_inField)
+    {
+        printFieldString(str);
+    }
+    else
+    {
+        if (str.length1)
+            m_sink->writeString(str.begin1, str.length1);
+        if (str.length2)
+            m_sink->writeString(str.begin2, str.length2);
+    }
     reset();
 }
 
-// ----=====================================================================----
-//     Private methods
-// ----=====================================================================----
+// -----------------------------------------------------------------------------
+//     Structured fields
+// -----------------------------------------------------------------------------
 
-void TextStream::reset()
+void TextStream::beginField(const char* key)
 {
-    m_format = Format();
+    m_sink->beginField(key, std::strlen(key), m_numFields);
+    ++m_numFields;
+    m_inField = true;
 }
 
-template <unsigned char TBase>
-int TextStream::countDigits(max_int_type value, max_int_type& divisor)
+void TextStream::endField()
 {
-    divisor = 1;
-    int digits = 1;
-    while (value >= TBase)
-    {
-        value /= TBase;
-        divisor *= TBase;
-        ++digits;
-    }
-    return digits;
+    m_inField = false;
+    m_sink->endField();
 }
 
-template <unsigned char TBase>
-void TextStream::printIntegerDigits(max_int_type value, max_int_type divisor)
+void TextStream::endFields()
 {
-    while (divisor)
-    {
-        unsigned char digit = value / divisor;
-        if (TBase <= 10)
-            m_sink->writeChar('0' + digit);
-        else
-            m_sink->writeChar(digit < 10 ? '0' + digit
-                                       : (m_format.upperCase ? 'A'- 10 + digit
-                                                             : 'a'- 10 + digit));
-        value -= digit * divisor;
-        divisor /= TBase;
-    }
+    m_sink->endFields(m_numFields);
+    m_numFields = 0;
+}
+
+// ----=====================================================================----
+//     Private methods
+// ----=====================================================================----
+
+void TextStream::reset()
+{
+    m_format = Format();
 }
 
 void TextStream::printInteger(max_int_type value, bool isNegative)
@@ -429,230 +610,355 @@ void TextStream::printInteger(max_int_type value, bool isNegative)
     if (m_format.type == Format::NoType)
         m_format.type = Format::Decimal;
 
-    int padding = m_format.minWidth;
-    max_int_type divisor;
+    // The buffer has room for a sign, a base prefix and 64 binary digits.
+    char buffer[3 + 64];
+    char* digits = buffer + 3;
+    int numDigits;
     switch (m_format.type)
     {
-    case Format::Binary:  padding -= countDigits< 2>(value, divisor); break;
+    case Format::Binary:
+        numDigits = countDigits<2>(value);
+        formatDigits<2>(value, digits, numDigits, false);
+        break;
     default:
-    case Format::Decimal: padding -= countDigits<10>(value, divisor); break;
-    case Format::Octal:   padding -= countDigits< 8>(value, divisor); break;
-    case Format::Hex:     padding -= countDigits<16>(value, divisor); break;
+    case Format::Decimal:
+        numDigits = countDigits<10>(value);
+        formatDigits<10>(value, digits, numDigits, false);
+        break;
+    case Format::Octal:
+        numDigits = countDigits<8>(value);
+        formatDigits<8>(value, digits, numDigits, false);
+        break;
+    case Format::Hex:
+        numDigits = countDigits<16>(value);
+        formatDigits<16>(value, digits, numDigits, m_format.upperCase);
+        break;
     }
 
-    padding = printPrePaddingAndSign(
-                  padding,
-                  isNegative,
-                  m_format.alternateForm ? m_format.type : Format::NoType);
-
-    switch (m_format.type)
+    Format::Type prefix = m_format.alternateForm ? m_format.type
+                                                 : Format::NoType;
+    if (m_format.minWidth <= numDigits)
     {
-    case Format::Binary:  printIntegerDigits< 2>(value, divisor); break;
-    default:
-    case Format::Decimal: printIntegerDigits<10>(value, divisor); break;
-    case Format::Octal:   printIntegerDigits< 8>(value, divisor); break;
-    case Format::Hex:     printIntegerDigits<16>(value, divisor); break;
+        // No padding is needed. Output everything with a single call.
+        char* begin = prependSignAndPrefix(digits, isNegative, prefix);
+        m_sink->writeString(begin, digits + numDigits - begin);
+        return;
     }
 
+    int padding = printPrePaddingAndSign(m_format.minWidth - numDigits,
+                                         isNegative, prefix);
+    m_sink->writeString(digits, numDigits);
     printPostPadding(padding);
 }
 
-void TextStream::printFloat(double value)
+template <typename T>
+void TextStream::printFloat(T value)
 {
     if (m_format.align == Format::AutoAlign)
         m_format.align = Format::Right;
-    if (m_format.precision < 0)
-        m_format.precision = 6;
-    if (m_format.type == Format::NoType)
-        m_format.type = Format::GeneralFloat;
 
     bool isNegative = signbit(value);
     if (isNegative)
         value = -value;
 
-    bool removeTrailingZeros = m_format.type == Format::GeneralFloat && !m_format.alternateForm;
-    int exponent = 0;
-
     // Handle special values.
     int klass = fpclassify(value);
     if (klass == FP_NAN || klass == FP_INFINITE)
     {
+        // JSON cannot represent these values, so a field becomes null.
+        if (m_inField && m_sink->fieldStyle() == TextSink::FieldStyle::Json)
+        {
+            m_sink->writeString("null", 4);
+            return;
+        }
+
         int padding = m_format.minWidth - 3;
         padding = printPrePaddingAndSign(
                     padding,
                     klass == FP_INFINITE && isNegative, Format::NoType);
-        switch (klass)
-        {
-        case FP_NAN:      m_sink->writeString("nan", 3); break;
-        case FP_INFINITE: m_sink->writeString("inf", 3); break;
-        }
+        if (klass == FP_NAN)
+            m_sink->writeString(m_format.upperCase ? "NAN" : "nan", 3);
+        else
+            m_sink->writeString(m_format.upperCase ? "INF" : "inf", 3);
         printPostPadding(padding);
         return;
     }
-    else if (klass == FP_ZERO)
+
+    // Convert the value to decimal digits such that
+    // value = 0.DIGITS * 10^decimalPoint. Zero has no digits.
+    char digits[log11_detail::maxDecimalDigits<T>()];
+    int numDigits = 0;
+    int decimalPoint = 1;
+    bool isZero = klass == FP_ZERO;
+
+    if (m_format.type == Format::NoType && m_format.precision < 0)
     {
-        // Zeros are handled just like numbers in the interval [0, 10).
-        if (m_format.type == Format::GeneralFloat)
+        // Without a type and a precision, the shortest representation is
+        // printed, which reads back as the same value.
+        if (!isZero)
+            numDigits = log11_detail::shortestDigits(value, digits, decimalPoint);
+        int exponent = decimalPoint - 1;
+        if (exponent < -4 || exponent >= 16)
+        {
+            m_format.type = Format::Exponent;
+            m_format.precision = numDigits > 1 ? numDigits - 1 : 0;
+        }
+        else
         {
             m_format.type = Format::FixedPoint;
-            if (m_format.precision)
-                m_format.precision -= 1;
+            m_format.precision = numDigits > decimalPoint
+                                 ? numDigits - decimalPoint : 0;
         }
     }
     else
     {
+        if (m_format.precision < 0)
+            m_format.precision = 6;
+        if (m_format.type == Format::NoType)
+            m_format.type = Format::GeneralFloat;
+
         if (m_format.type == Format::GeneralFloat)
         {
             if (m_format.precision == 0)
                 m_format.precision = 1;
+            if (!isZero)
+                numDigits = log11_detail::precisionDigits(
+                                value, m_format.precision, digits, decimalPoint);
 
-            exponent = floor(log10(value));
-            double temp = value * pow(double(10), -exponent);
-            temp += 5 * pow(double(10), -double(m_format.precision));
-            if (temp >= double(10))
-            {
-                temp /= double(10);
-                ++exponent;
-            }
-
-            if (exponent >= -4 && exponent < m_format.precision - 1)
+            int exponent = decimalPoint - 1;
+            if (exponent >= -4 && exponent < m_format.precision)
             {
                 m_format.type = Format::FixedPoint;
-                m_format.precision = m_format.precision - exponent - 1;
-                value += 5 * pow(double(10), -double(m_format.precision + 1));
+                m_format.precision = m_format.precision - 1 - exponent;
             }
             else
             {
                 m_format.type = Format::Exponent;
                 m_format.precision -= 1;
-                value = temp;
-            }
-        }
-        else
-        {
-            if (m_format.type == Format::Exponent)
-            {
-                // Scale the value such that 1 <= value < 10.
-                exponent = floor(log10(value));
-                value *= pow(double(10), -exponent);
             }
 
-            value += 5 * pow(double(10), -double(m_format.precision + 1));
-            if (m_format.type == Format::Exponent && value >= double(10))
+            if (!m_format.alternateForm)
             {
-                value /= double(10);
-                ++exponent;
+                // Remove the trailing zeros.
+                while (numDigits && digits[numDigits - 1] == '0')
+                    --numDigits;
+                int significant = m_format.type == Format::Exponent
+                                  ? numDigits - 1 : numDigits - decimalPoint;
+                if (m_format.precision > significant)
+                    m_format.precision = significant > 0 ? significant : 0;
             }
         }
-    }
-
-    max_int_type integer, fraction;
-    unsigned fractionDivisor;
-    {
-        double intf;
-        double fracf = modf(value, &intf);
-        double scale = pow(double(10), double(m_format.precision));
-        fracf *= scale;
-        integer = intf;
-        fraction = fracf;
-        fractionDivisor = unsigned(scale) / 10;
-    }
-    if (removeTrailingZeros)
-        while (m_format.precision && fraction % 10 == 0)
+        else if (m_format.type == Format::Exponent)
+        {
+            if (!isZero)
+                numDigits = log11_detail::precisionDigits(
+                                value, m_format.precision + 1,
+                                digits, decimalPoint);
+        }
+        else if (!isZero)
         {
-            fraction /= 10;
-            fractionDivisor /= 10;
-            --m_format.precision;
+            m_format.type = Format::FixedPoint;
+            numDigits = log11_detail::fixedDigits(
+                            value, m_format.precision, digits, decimalPoint);
+            if (numDigits == 0)
+                decimalPoint = 1;
         }
+    }
 
-    max_int_type divisor = 1;
-    int integerDigits = m_format.type == Format::Exponent
-                        ? 1
-                        : countDigits<10>(integer, divisor);
-    int padding = m_format.minWidth - (integerDigits + m_format.precision);
+    int exponent = numDigits ? decimalPoint - 1 : 0;
+    int exponentDigits = 0;
+    int padding = m_format.minWidth - m_format.precision;
     if (m_format.precision || m_format.alternateForm)
         padding -= 1; // '.'
     if (m_format.type == Format::Exponent)
-        padding -= 4; // 'e+xx'
+    {
+        exponentDigits = exponent >= 1000 || exponent <= -1000
+                         ? 4 : (exponent >= 100 || exponent <= -100 ? 3 : 2);
+        padding -= 1 + 2 + exponentDigits; // 'd' and 'e+'
+    }
+    else
+    {
+        padding -= decimalPoint > 0 ? decimalPoint : 1;
+    }
 
     padding = printPrePaddingAndSign(padding, isNegative, Format::NoType);
-    printIntegerDigits<10>(integer, divisor);
 
-    if (m_format.precision)
-    {
-        m_sink->writeChar('.');
-        printIntegerDigits<10>(fraction, fractionDivisor ? fractionDivisor : 1);
-    }
-    else if (m_format.alternateForm)
-        m_sink->writeChar('.');
+    // Prints 'count' digits starting at the index 'first'. Non-existing
+    // digits are printed as zeros.
+    auto printDigits = [&](int first, int count) {
+        if (first < 0)
+        {
+            int zeros = count < -first ? count : -first;
+            printZeros(zeros);
+            first += zeros;
+            count -= zeros;
+        }
+        if (count > 0 && first < numDigits)
+        {
+            int available = numDigits - first;
+            int length = count < available ? count : available;
+            m_sink->writeString(digits + first, length);
+            count -= length;
+        }
+        printZeros(count);
+    };
 
     if (m_format.type == Format::Exponent)
     {
-         m_sink->writeChar(m_format.upperCase ? 'E' : 'e');
-         if (exponent >= 0)
-         {
-             m_sink->writeChar('+');
-         }
-         else
-         {
-             m_sink->writeChar('-');
-             exponent = -exponent;
-         }
-         printIntegerDigits<10>(exponent, 10);
+        printDigits(0, 1);
+        if (m_format.precision || m_format.alternateForm)
+            m_sink->writeChar('.');
+        printDigits(1, m_format.precision);
+
+        char buffer[6];
+        buffer[0] = m_format.upperCase ? 'E' : 'e';
+        buffer[1] = exponent >= 0 ? '+' : '-';
+        if (exponent < 0)
+            exponent = -exponent;
+        for (int idx = exponentDigits; idx > 0; --idx)
+        {
+            buffer[1 + idx] = char('0' + exponent % 10);
+            exponent /= 10;
+        }
+        m_sink->writeString(buffer, 2 + exponentDigits);
+    }
+    else
+    {
+        if (decimalPoint > 0)
+            printDigits(0, decimalPoint);
+        else
+            m_sink->writeChar('0');
+        if (m_format.precision || m_format.alternateForm)
+            m_sink->writeChar('.');
+        printDigits(decimalPoint, m_format.precision);
     }
 
     printPostPadding(padding);
 }
 
+void TextStream::printZeros(int count)
+{
+    static const char zeros[] = "0000000000000000";
+    while (count > 0)
+    {
+        int length = count < 16 ? count : 16;
+        m_sink->writeString(zeros, length);
+        count -= length;
+    }
+}
+
 int TextStream::printPrePaddingAndSign(
         int padding, bool isNegative, Format::Type prefix)
 {
-    if (isNegative || m_format.sign != Format::OnlyNegative)
-        --padding;
-    if (prefix != Format::NoType)
-        padding -= 2;
+    char signAndPrefix[3];
+    char* end = signAndPrefix + sizeof(signAndPrefix);
+    char* begin = prependSignAndPrefix(end, isNegative, prefix);
+    padding -= end - begin;
 
     if (m_format.align == Format::Right)
     {
-        while (padding-- > 0)
-            m_sink->writeChar(m_format.fill);
+        printFill(padding);
+        padding = 0;
     }
     else if (m_format.align == Format::Centered)
     {
-        for (int count = 0; count < (padding + 1) / 2; ++count)
-            m_sink->writeChar(m_format.fill);
+        printFill((padding + 1) / 2);
         padding /= 2;
     }
 
-    if (isNegative)
-        m_sink->writeChar('-');
-    else if (m_format.sign == Format::SpaceForPositive)
-        m_sink->writeChar(' ');
-    else if (m_format.sign == Format::Always)
-        m_sink->writeChar('+');
+    if (begin != end)
+        m_sink->writeString(begin, end - begin);
+
+    if (m_format.align == Format::AlignAfterSign)
+    {
+        printFill(padding);
+        padding = 0;
+    }
 
+    return padding;
+}
+
+char* TextStream::prependSignAndPrefix(
+        char* begin, bool isNegative, Format::Type prefix) const noexcept
+{
     switch (prefix)
     {
     default:
     case Format::NoType:  break;
-    case Format::Binary:  m_sink->writeString("0b", 2); break;
-    case Format::Decimal: m_sink->writeString("0d", 2); break;
-    case Format::Octal:   m_sink->writeString("0o", 2); break;
-    case Format::Hex:     m_sink->writeString("0x", 2); break;
+    case Format::Binary:  *--begin = 'b'; *--begin = '0'; break;
+    case Format::Decimal: *--begin = 'd'; *--begin = '0'; break;
+    case Format::Octal:   *--begin = 'o'; *--begin = '0'; break;
+    case Format::Hex:     *--begin = 'x'; *--begin = '0'; break;
     }
 
-    if (m_format.align == Format::AlignAfterSign)
-        while (padding-- > 0)
-            m_sink->writeChar(m_format.fill);
+    if (isNegative)
+        *--begin = '-';
+    else if (m_format.sign == Format::SpaceForPositive)
+        *--begin = ' ';
+    else if (m_format.sign == Format::Always)
+        *--begin = '+';
 
-    return padding;
+    return begin;
 }
 
 void TextStream::printPostPadding(int padding)
 {
     if (m_format.align == Format::Left || m_format.align == Format::Centered)
-        while (padding-- > 0)
-            m_sink->writeChar(m_format.fill);
+        printFill(padding);
+}
+
+void TextStream::printFill(int count)
+{
+    if (count == 1)
+    {
+        m_sink->writeChar(m_format.fill);
+        return;
+    }
+
+    char buffer[16];
+    std::memset(buffer, m_format.fill, sizeof(buffer));
+    while (count > 0)
+    {
+        int length = count < 16 ? count : 16;
+        m_sink->writeString(buffer, length);
+        count -= length;
+    }
+}
+
+void TextStream::printFieldString(const SplitStringView& str)
+{
+    // JSON strings are always quoted. In the logfmt style, quotes are only
+    // needed if the value is empty or contains special characters.
+    bool quoted = m_sink->fieldStyle() == TextSink::FieldStyle::Json
+                  || str.length1 + str.length2 == 0;
+    auto needsQuotes = [] (const char* iter, std::size_t length) {
+        for (const char* end = iter + length; iter != end; ++iter)
+        {
+            unsigned char ch = *iter;
+            if (ch <= ' ' || ch == '"' || ch == '=' || ch == '\\')
+                return true;
+        }
+        return false;
+    };
+    if (!quoted)
+        quoted = needsQuotes(str.begin1, str.length1)
+                 || needsQuotes(str.begin2, str.length2);
+
+    if (!quoted)
+    {
+        if (str.length1)
+            m_sink->writeString(str.begin1, str.length1);
+        if (str.length2)
+            m_sink->writeString(str.begin2, str.length2);
+        return;
+    }
+
+    m_sink->writeChar('"');
+    if (str.length1)
+        m_sink->writeEscaped(str.begin1, str.length1);
+    if (str.length2)
+        m_sink->writeEscaped(str.begin2, str.length2);
+    m_sink->writeChar('"');
 }
 
 } // namespace log11
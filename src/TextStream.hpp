@@ -30,6 +30,7 @@
 #ifndef LOG11_TEXTSTREAM_HPP
 #define LOG11_TEXTSTREAM_HPP
 
+#include "CharacterScan.hpp"
 #include "Config.hpp"
 #include "RingBuffer.hpp"
 #include "TextSink.hpp"
@@ -56,6 +57,12 @@ struct TypeTraits;
 namespace log11_detail
 {
 
+class DecoderPrinter;
+class FormatCache;
+
+template <typename T>
+class ArraySerdes;
+
 template <typename T>
 class Serdes;
 
@@ -242,8 +249,12 @@ private:
 class TextStream
 {
 public:
+    //! Creates a text stream, which writes to the \p sink. If a
+    //! \p formatCache is given, it is used to speed up the formatting of
+    //! immutable format strings.
     explicit
-    TextStream(TextSink& sink, log11_detail::ScratchPad& scratchPad);
+    TextStream(TextSink& sink, log11_detail::ScratchPad& scratchPad,
+               log11_detail::FormatCache* formatCache = nullptr);
 
     TextStream(const TextStream&) = delete;
     TextStream& operator=(const TextStream&) = delete;
@@ -294,10 +305,35 @@ public:
     void write(T&& value);
 
 
+    //! \brief Starts a structured field.
+    //!
+    //! Starts a field with the given \p key. The next value which is
+    //! written to this stream becomes the value of the field. A field has
+    //! to be finished with endField().
+    void beginField(const char* key);
+
+    //! \brief Finishes a structured field.
+    void endField();
+
+    //! \brief Finishes all structured fields.
+    //!
+    //! Finishes all structured fields, which have been written to this
+    //! stream.
+    void endFields();
+
+
     template <typename... TArgs>
     void doFormat(SplitStringView str,
                   log11_detail::ArgumentForwarder<TArgs...>&& args);
 
+    //! \brief Formats an immutable format string.
+    //!
+    //! Formats the immutable format string \p str with the arguments from
+    //! the ring buffer. The parsed format string is taken from the format
+    //! cache, if possible.
+    void doFormat(Immutable<const char*> str,
+                  log11_detail::ArgumentForwarder<RingBuffer::Stream>&& args);
+
 private:
     using max_int_type = unsigned long long;
 
@@ -364,29 +400,44 @@ private:
 
     TextSink* m_sink;
     log11_detail::ScratchPad& m_scratchPad;
+    //! The cache for parsed format strings (may be null).
+    log11_detail::FormatCache* m_formatCache;
 
     Format m_format;
 
+    //! The number of structured fields, which have been written.
+    unsigned m_numFields;
+    //! Set while the value of a structured field is written.
+    bool m_inField;
 
 
-    template <unsigned char TBase>
-    int countDigits(max_int_type value, max_int_type& divisor);
-
-    template <unsigned char TBase>
-    void printIntegerDigits(max_int_type value, max_int_type divisor);
 
     void printInteger(max_int_type value, bool isNegative);
-    void printFloat(double value);
+
+    template <typename T>
+    void printFloat(T value);
+
+    void printZeros(int count);
 
     int printPrePaddingAndSign(int padding, bool isNegative, Format::Type prefix);
+    char* prependSignAndPrefix(char* begin, bool isNegative,
+                               Format::Type prefix) const noexcept;
     void printPostPadding(int padding);
+    void printFill(int count);
+
+    void printFieldString(const SplitStringView& str);
 
     void reset();
 
 
 
+    friend class log11_detail::DecoderPrinter;
+    friend class log11_detail::FormatCache;
     friend class log11_detail::TextForwarderSink;
 
+    template <typename T>
+    friend class log11_detail::ArraySerdes;
+
     template <typename T>
     friend class log11_detail::Serdes;
 };
@@ -421,49 +472,42 @@ void TextStream::doFormat(SplitStringView str,
     using namespace std;
 
     const char* iter = str.begin1;
-    const char* marker = str.begin1;
     const char* end = str.begin1 + str.length1;
-    for (;; ++iter)
+    for (;;)
     {
-        // Loop to the start of the format specifier (or the end of the string).
-        if (iter == end)
+        // Output the literal text up to the start of the next format
+        // specifier (or the end of the string).
+        const char* brace = log11_detail::findCharacter(iter, end, '{');
+        if (brace != iter)
+            m_sink->writeString(iter, brace - iter);
+        if (brace == end)
         {
-            if (iter != marker)
-                m_sink->writeString(marker, iter - marker);
-            marker = iter = str.begin2;
+            if (str.length2 == 0)
+                break;
+            iter = str.begin2;
             end = str.begin2 + str.length2;
             str.length2 = 0;
-            if (iter == end)
-                break;
-        }
-        if (*iter != '{')
             continue;
+        }
 
-        if (iter != marker)
-            m_sink->writeString(marker, iter - marker);
-
+        // Collect the format specifier, which can be split into two parts.
         m_scratchPad.clear();
-        // Loop to the end of the format specifier (or the end of the string).
-        marker = iter + 1;
-        while (*iter != '}')
+        iter = brace + 1;
+        brace = log11_detail::findCharacter(iter, end, '}');
+        if (brace == end)
         {
-            ++iter;
-            if (iter == end)
-            {
-                if (iter != marker)
-                    m_scratchPad.push(marker, iter - marker);
-                marker = iter = str.begin2;
-                end = str.begin2 + str.length2;
-                str.length2 = 0;
-                if (iter == end)
-                    break;
-            }
+            if (str.length2 == 0)
+                break;
+            m_scratchPad.push(iter, brace - iter);
+            iter = str.begin2;
+            end = str.begin2 + str.length2;
+            str.length2 = 0;
+            brace = log11_detail::findCharacter(iter, end, '}');
+            if (brace == end)
+                break;
         }
-        if (iter == end)
-            break;
-
-        if (iter != marker)
-            m_scratchPad.push(marker, iter - marker);
+        if (brace != iter)
+            m_scratchPad.push(iter, brace - iter);
 
         if (m_scratchPad.size())
         {
@@ -473,10 +517,8 @@ void TextStream::doFormat(SplitStringView str,
 
         args.printNext();
 
-        marker = iter + 1;
+        iter = brace + 1;
     }
-    if (iter != marker)
-        m_sink->writeString(marker, iter - marker);
 
     args.printRest();
 }
@@ -79,7 +79,7 @@ void ScratchPad::clear() noexcept
 void ScratchPad::push(char ch)
 {
     if (m_size == m_capacity)
-        resize((m_size + 7) & ~7);
+        resize(2 * m_capacity + 8);
     m_data[m_size] = ch;
     ++m_size;
 }
@@ -88,7 +88,7 @@ void ScratchPad::push(const char* data, unsigned size)
 {
     unsigned newSize = m_size + size;
     if (newSize > m_capacity)
-        resize((newSize + 7) & ~7);
+        resize(newSize > 2 * m_capacity ? (newSize + 7) & ~7 : 2 * m_capacity);
     memcpy(m_data + m_size, data, size);
     m_size = newSize;
 }
@@ -146,6 +146,28 @@ struct SeverityGenerator : public RecordHeaderGenerator
     }
 };
 
+struct SequenceGenerator : public RecordHeaderGenerator
+{
+    explicit
+    SequenceGenerator()
+    {
+    }
+
+    virtual
+    void append(LogRecordData& record, log11_detail::ScratchPad& pad) override
+    {
+        char buffer[20];
+        char* iter = buffer + sizeof(buffer);
+        auto value = record.sequence;
+        do
+        {
+            *--iter = char('0' + value % 10);
+            value /= 10;
+        } while (value);
+        pad.push(iter, unsigned(buffer + sizeof(buffer) - iter));
+    }
+};
+
 struct TimeGenerator : public RecordHeaderGenerator
 {
     enum Flags : unsigned char
@@ -277,6 +299,7 @@ enum class Tag
     Microseconds,
     Nanoseconds,
     Level,
+    Sequence,
     None,
 };
 
@@ -296,6 +319,7 @@ Tag toTag(const char* begin, std::size_t length) noexcept
         case 'M': return Tag::Minutes;
         case 'S': return Tag::Seconds;
         case 'L': return Tag::Level;
+        case 'Q': return Tag::Sequence;
         default: return Tag::None;
         }
     }
@@ -427,6 +451,10 @@ RecordHeaderGenerator* RecordHeaderGenerator::parse(const char* str)
             append(new SeverityGenerator());
             break;
 
+        case Tag::Sequence:
+            append(new SequenceGenerator());
+            break;
+
         default:
         case Tag::None:
             append(new LiteralGenerator("<?>", 3));
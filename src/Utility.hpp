@@ -33,11 +33,25 @@
 #include "Config.hpp"
 #include "TypeTraits.hpp"
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <string>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#if __cplusplus > 201703L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define LOG11_HAVE_SPAN
+#endif
+#endif
 
 #ifdef LOG11_USE_WEOS
 #include <weos/utility.hpp>
@@ -98,6 +112,60 @@ struct SplitStringView
     std::size_t length2;
 };
 
+// ----=====================================================================----
+//     StringRef & ArrayRef
+// ----=====================================================================----
+
+//! A reference to a string, which need not be null-terminated. Strings like
+//! <tt>std::string</tt> are passed to the logger as a StringRef.
+struct StringRef
+{
+    const char* data;
+    std::size_t size;
+};
+
+//! A reference to a contiguous array of arithmetic values. Containers like
+//! <tt>std::vector</tt> and <tt>std::array</tt> are passed to the logger as
+//! an ArrayRef.
+template <typename T>
+struct ArrayRef
+{
+    const T* data;
+    std::size_t size;
+};
+
+//! The type of the elements in an array.
+enum class ArrayElementType : std::uint8_t
+{
+    Int8,
+    UInt8,
+    Int16,
+    UInt16,
+    Int32,
+    UInt32,
+    Int64,
+    UInt64,
+    Float,
+    Double,
+    LongDouble
+};
+
+// ----=====================================================================----
+//     KeyValue
+// ----=====================================================================----
+
+//! \brief A structured field.
+//!
+//! A KeyValue attaches a \p key to a \p value. The key must be a string with
+//! static storage duration (usually a string literal) because only the pointer
+//! is passed to the sinks. Use kv() to create a KeyValue.
+template <typename T>
+struct KeyValue
+{
+    const char* key;
+    T value;
+};
+
 namespace log11_detail
 {
 
@@ -304,13 +372,92 @@ struct AtomicDecayer<std::atomic<T>>
 };
 
 
+//! Strings are passed by reference. Their characters are copied into the
+//! ring buffer.
+template <typename T>
+struct IsString : public std::false_type {};
+
+template <typename TTraits, typename TAllocator>
+struct IsString<std::basic_string<char, TTraits, TAllocator>>
+        : public std::true_type {};
+
+#if __cplusplus >= 201703L
+template <typename TTraits>
+struct IsString<std::basic_string_view<char, TTraits>>
+        : public std::true_type {};
+#endif
+
+struct StringDecayer
+{
+    template <typename T>
+    static
+    StringRef decay(const T& x) noexcept
+    {
+        return StringRef{x.data(), x.size()};
+    }
+};
+
+//! Contiguous arrays of arithmetic values are passed by reference. Their
+//! elements are copied into the ring buffer en bloc.
+template <typename T>
+struct IsArrayElement : public std::integral_constant<
+                            bool,
+                            std::is_arithmetic<T>::value
+                            && !std::is_same<T, bool>::value>
+{
+};
+
+template <typename T>
+struct IsArray : public std::false_type {};
+
+template <typename T, typename TAllocator>
+struct IsArray<std::vector<T, TAllocator>> : public IsArrayElement<T> {};
+
+template <typename T, std::size_t N>
+struct IsArray<std::array<T, N>> : public IsArrayElement<T> {};
+
+#ifdef LOG11_HAVE_SPAN
+template <typename T, std::size_t N>
+struct IsArray<std::span<T, N>> : public IsArrayElement<std::remove_cv_t<T>> {};
+#endif
+
+struct ArrayDecayer
+{
+    template <typename T>
+    static
+    auto decay(const T& x) noexcept
+        -> ArrayRef<std::remove_cv_t<std::remove_reference_t<decltype(*x.data())>>>
+    {
+        return {x.data(), x.size()};
+    }
+};
+
+
 template <typename T>
 using Decayer_t = typename std::conditional_t<
         std::is_enum<T>::value && (TreatAsInteger<T>::value || std::is_convertible<T, int>::value),
         EnumDecayer<T>,
         std::conditional_t<IsAtomic<T>::value,
                            AtomicDecayer<T>,
-                           Decayer<T>>>;
+        std::conditional_t<IsString<T>::value,
+                           StringDecayer,
+        std::conditional_t<IsArray<T>::value,
+                           ArrayDecayer,
+                           Decayer<T>>>>>;
+
+//! Maps the type \p T to the type of an array element.
+template <typename T>
+constexpr
+ArrayElementType arrayElementType() noexcept
+{
+    static_assert(IsArrayElement<T>::value, "Invalid array element type");
+    return std::is_same<T, long double>::value ? ArrayElementType::LongDouble
+         : std::is_same<T, double>::value ? ArrayElementType::Double
+         : std::is_same<T, float>::value ? ArrayElementType::Float
+         : static_cast<ArrayElementType>(
+               2 * (sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : sizeof(T) == 4 ? 2 : 3)
+               + (std::is_signed<T>::value ? 0 : 1));
+}
 
 template <typename T>
 auto decayArgument(T&& x) -> decltype(Decayer_t<std::decay_t<T>>::decay(std::forward<T>(x)))
@@ -318,7 +465,52 @@ auto decayArgument(T&& x) -> decltype(Decayer_t<std::decay_t<T>>::decay(std::for
     return Decayer_t<std::decay_t<T>>::decay(std::forward<T>(x));
 }
 
+// ----=====================================================================----
+//     Little-endian encoding
+// ----=====================================================================----
+
+//! Stores the integer \p value in little-endian byte order.
+template <typename T>
+void storeLittleEndian(T value, std::uint8_t* buffer) noexcept
+{
+    for (std::size_t idx = 0; idx < sizeof(T); ++idx)
+    {
+        buffer[idx] = std::uint8_t(value);
+        value = T(value >> 8);
+    }
+}
+
+//! Loads an integer in little-endian byte order.
+template <typename T>
+T loadLittleEndian(const std::uint8_t* buffer) noexcept
+{
+    T value = 0;
+    for (std::size_t idx = sizeof(T); idx > 0; --idx)
+        value = T((value << 8) | buffer[idx - 1]);
+    return value;
+}
+
 } // namespace log11_detail
+
+// ----=====================================================================----
+//     kv()
+// ----=====================================================================----
+
+//! \brief Creates a structured field.
+//!
+//! Creates a field with the given \p key and \p value, which can be passed
+//! to the logger like any other argument:
+//! \code
+//! log.info("Request done", kv("user", id), kv("lat_us", t));
+//! \endcode
+//! The \p key must have static storage duration.
+template <typename T>
+auto kv(const char* key, T&& value)
+    -> KeyValue<std::decay_t<decltype(log11_detail::decayArgument(std::forward<T>(value)))>>
+{
+    return {key, log11_detail::decayArgument(std::forward<T>(value))};
+}
+
 } // namespace log11
 
 #endif // LOG11_UTILITY_HPP
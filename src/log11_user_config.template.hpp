@@ -33,6 +33,15 @@
 // If this macro is set, the library uses WEOS rather than the STL.
 // #define LOG11_USE_WEOS
 
+// If this macro is set, the library does not use SIMD instructions even if
+// the compiler targets a CPU which supports them.
+// #define LOG11_DISABLE_SIMD
+
+// The number of immutable format strings whose parsed form is cached by the
+// consumer thread. Every entry needs about 150 bytes. A value of 0 disables
+// the cache. The default is 64.
+// #define LOG11_FORMAT_CACHE_SIZE   64
+
 // ----=====================================================================----
 //     Private section.
 //     Do not modify the code below.
@@ -0,0 +1,847 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+// log11bench - Measures the performance of the logging pipeline.
+//
+// Usage: log11bench [-s <suite>,...] [-n <messages>] [-t <threads>,...]
+//                   [-f csv|json]
+//
+// The suites are
+//   latency     per-call latency of a single producer
+//   threads     throughput versus the number of producer threads
+//   policy      the claim policies Block, Truncate, Discard and BlockUntil
+//               (blocking for at most 50us)
+//   ring        the size of the ring buffer
+//   args        mixes of arguments (integers, floats, literals, strings);
+//               literals are passed as pointers because the read-only
+//               segments of the program are registered with the core
+//   e2e         the latency from enqueuing a record to the sink with a null
+//               sink, a memory sink and a text sink
+//   reserve     the latency of error() calls under a flood of info records
+//               into a slow sink, without and with space reserved for
+//               warnings and errors (see LogCore::reserveSpace())
+//   float       formatting floats in a text sink (shortest, fixed-point and
+//               exponent notation); the consumer's cost is in total_seconds
+// By default, all suites are run. Every producer thread logs <messages>
+// records (default: 100000). The thread counts of the 'threads' suite
+// default to 1, 2, 4, ..., 64.
+//
+// The results are written to the standard output as CSV (default) or JSON
+// with one row per case. The latencies are given in nanoseconds and
+// include the overhead of reading the clock. They are recorded in a
+// log-linear histogram with a relative precision of about 3%. The error
+// latencies are only measured in the 'reserve' suite.
+//
+// Build: g++ -std=c++14 -O2 -Isrc src/*.cpp tools/log11bench.cpp -lpthread
+
+#include "BinarySink.hpp"
+#include "ImageSegments.hpp"
+#include "Logger.hpp"
+#include "TextSink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace log11;
+
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// ----=====================================================================----
+//     LatencyHistogram
+// ----=====================================================================----
+
+//! A log-linear histogram in the style of HdrHistogram. Values below 64
+//! are counted exactly. Above, every power of two is split into 32
+//! buckets.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram()
+        : m_counts(numBuckets, 0),
+          m_total(0),
+          m_max(0)
+    {
+    }
+
+    void record(std::uint64_t value)
+    {
+        ++m_counts[indexOf(value)];
+        ++m_total;
+        if (value > m_max)
+            m_max = value;
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        for (unsigned idx = 0; idx < numBuckets; ++idx)
+            m_counts[idx] += other.m_counts[idx];
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    std::uint64_t count() const
+    {
+        return m_total;
+    }
+
+    std::uint64_t max() const
+    {
+        return m_max;
+    }
+
+    //! Returns the value at the given \p percentile (0 to 100). The value
+    //! is the upper bound of the bucket.
+    std::uint64_t percentile(double percentile) const
+    {
+        if (m_total == 0)
+            return 0;
+        auto rank = std::uint64_t(percentile / 100.0 * m_total + 0.5);
+        if (rank == 0)
+            rank = 1;
+        std::uint64_t sum = 0;
+        for (unsigned idx = 0; idx < numBuckets; ++idx)
+        {
+            sum += m_counts[idx];
+            if (sum >= rank)
+                return std::min(valueOf(idx), m_max);
+        }
+        return m_max;
+    }
+
+private:
+    static constexpr unsigned subBits = 5;
+    static constexpr unsigned linearLimit = 2u << subBits;
+    static constexpr unsigned numBuckets
+            = linearLimit + (64 - subBits - 1) * (1u << subBits);
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total;
+    std::uint64_t m_max;
+
+    static unsigned indexOf(std::uint64_t value)
+    {
+        if (value < linearLimit)
+            return unsigned(value);
+        unsigned exponent = 63 - __builtin_clzll(value);
+        unsigned mantissa = unsigned(value >> (exponent - subBits))
+                            & ((1u << subBits) - 1);
+        return linearLimit + (exponent - subBits - 1) * (1u << subBits)
+               + mantissa;
+    }
+
+    static std::uint64_t valueOf(unsigned index)
+    {
+        if (index < linearLimit)
+            return index;
+        unsigned exponent = (index - linearLimit) / (1u << subBits)
+                            + subBits + 1;
+        std::uint64_t mantissa = (index - linearLimit) % (1u << subBits);
+        unsigned shift = exponent - subBits;
+        return (((1u << subBits) + mantissa) << shift)
+               + ((std::uint64_t(1) << shift) - 1);
+    }
+};
+
+// ----=====================================================================----
+//     Sinks
+// ----=====================================================================----
+
+//! A binary sink, which discards the output.
+class NullSink : public BinarySink
+{
+public:
+    NullSink()
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    virtual
+    void writeByte(byte) override
+    {
+    }
+
+    virtual
+    void writeBytes(const byte*, unsigned) override
+    {
+    }
+
+    virtual
+    void beginLogEntry(const LogRecordData& data) override
+    {
+        BinarySink::beginLogEntry(data);
+        ++numRecords;
+        if (latencies)
+        {
+            auto now = std::chrono::high_resolution_clock::now();
+            latencies->record(std::chrono::duration_cast<
+                              std::chrono::nanoseconds>(now - data.time).count());
+        }
+    }
+
+    //! The number of records, which have reached the sink.
+    std::uint64_t numRecords = 0;
+    //! If set, the enqueue-to-sink latencies are recorded.
+    LatencyHistogram* latencies = nullptr;
+};
+
+//! A binary sink, which writes the output to a memory area. The area is
+//! overwritten when it is full.
+class MemorySink : public NullSink
+{
+public:
+    MemorySink()
+        : m_buffer(16 * 1024 * 1024),
+          m_size(0)
+    {
+    }
+
+    virtual
+    void writeByte(byte data) override
+    {
+        if (m_size == m_buffer.size())
+            m_size = 0;
+        m_buffer[m_size++] = data;
+    }
+
+    virtual
+    void writeBytes(const byte* data, unsigned size) override
+    {
+        if (size > m_buffer.size() - m_size)
+            m_size = 0;
+        std::memcpy(m_buffer.data() + m_size, data, size);
+        m_size += size;
+    }
+
+private:
+    std::vector<byte> m_buffer;
+    std::size_t m_size;
+};
+
+//! A binary sink, which discards the output and needs a fixed time for
+//! every record.
+class SlowSink : public NullSink
+{
+public:
+    virtual
+    void beginLogEntry(const LogRecordData& data) override
+    {
+        NullSink::beginLogEntry(data);
+        auto end = std::chrono::steady_clock::now() + delay;
+        while (std::chrono::steady_clock::now() < end)
+        {
+        }
+    }
+
+    //! The time which is spent on every record.
+    std::chrono::nanoseconds delay{1000};
+};
+
+//! A text sink, which formats the records and discards the text.
+class NullTextSink : public TextSink
+{
+public:
+    NullTextSink()
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    virtual
+    void writeChar(char) override
+    {
+    }
+
+    virtual
+    void writeString(const char*, std::size_t) override
+    {
+    }
+
+    virtual
+    void beginLogEntry(const LogRecordData& data) override
+    {
+        TextSink::beginLogEntry(data);
+        ++numRecords;
+        if (latencies)
+        {
+            auto now = std::chrono::high_resolution_clock::now();
+            latencies->record(std::chrono::duration_cast<
+                              std::chrono::nanoseconds>(now - data.time).count());
+        }
+    }
+
+    std::uint64_t numRecords = 0;
+    LatencyHistogram* latencies = nullptr;
+};
+
+// ----=====================================================================----
+//     Benchmark cases
+// ----=====================================================================----
+
+enum class ArgumentMix
+{
+    Ints,
+    Floats,
+    Literals,
+    Strings,
+    Mixed,
+    // The following mixes are not part of Mixed.
+    ShortestFloats,
+    FixedFloats,
+    ExponentFloats
+};
+
+const char* toString(ArgumentMix mix)
+{
+    switch (mix)
+    {
+    case ArgumentMix::Ints:     return "ints";
+    case ArgumentMix::Floats:   return "floats";
+    case ArgumentMix::Literals: return "literals";
+    case ArgumentMix::Strings:  return "strings";
+    case ArgumentMix::Mixed:    return "mixed";
+    case ArgumentMix::ShortestFloats: return "shortest_floats";
+    case ArgumentMix::FixedFloats:    return "fixed_floats";
+    case ArgumentMix::ExponentFloats: return "exponent_floats";
+    }
+    return "";
+}
+
+const char* toString(LogCore::ClaimPolicy policy)
+{
+    switch (policy)
+    {
+    case LogCore::Block:    return "block";
+    case LogCore::Truncate: return "truncate";
+    case LogCore::Discard:  return "discard";
+    case LogCore::BlockUntil: return "block_for";
+    }
+    return "";
+}
+
+enum class SinkKind
+{
+    Null,
+    Memory,
+    Text,
+    Slow
+};
+
+const char* toString(SinkKind sink)
+{
+    switch (sink)
+    {
+    case SinkKind::Null:   return "null";
+    case SinkKind::Memory: return "memory";
+    case SinkKind::Text:   return "text";
+    case SinkKind::Slow:   return "slow";
+    }
+    return "";
+}
+
+struct Case
+{
+    const char* suite;
+    unsigned numThreads = 1;
+    LogCore::ClaimPolicy policy = LogCore::Block;
+    std::size_t ringSize = 64 * 1024;
+    ArgumentMix arguments = ArgumentMix::Ints;
+    SinkKind sink = SinkKind::Null;
+    std::uint64_t numMessages = 100000;
+    //! The space which is reserved for warnings and errors.
+    std::size_t reserved = 0;
+    //! If set, an additional thread logs errors while the producers are
+    //! running.
+    bool errorProbe = false;
+};
+
+struct Result
+{
+    Case config;
+    //! The time until all producers have finished.
+    double producerSeconds;
+    //! The time until all records have been consumed.
+    double totalSeconds;
+    //! The number of records which have reached the sink.
+    std::uint64_t numDelivered;
+    //! The per-call latencies of the producers.
+    LatencyHistogram producerLatency;
+    //! The latencies from enqueuing to the sink.
+    LatencyHistogram sinkLatency;
+    //! The latencies of the error() calls of the probe thread.
+    LatencyHistogram errorLatency;
+};
+
+template <typename... TArgs>
+void logWithPolicy(Logger& logger, LogCore::ClaimPolicy policy,
+                   const char* message, TArgs&&... args)
+{
+    switch (policy)
+    {
+    case LogCore::Block:
+        logger.log(Severity::Info, message, std::forward<TArgs>(args)...);
+        break;
+    case LogCore::Truncate:
+        logger.log(may_truncate_or_discard, Severity::Info, message,
+                   std::forward<TArgs>(args)...);
+        break;
+    case LogCore::Discard:
+        logger.log(may_discard, Severity::Info, message,
+                   std::forward<TArgs>(args)...);
+        break;
+    case LogCore::BlockUntil:
+        logger.log(block_for(std::chrono::microseconds(50)), Severity::Info,
+                   message, std::forward<TArgs>(args)...);
+        break;
+    }
+}
+
+void logOne(Logger& logger, const Case& config, std::uint64_t idx,
+            const std::string& text)
+{
+    auto mix = config.arguments;
+    if (mix == ArgumentMix::Mixed)
+        mix = static_cast<ArgumentMix>(idx % 4);
+
+    switch (mix)
+    {
+    case ArgumentMix::Ints:
+        logWithPolicy(logger, config.policy, "ints {} {} {}",
+                      int(idx), idx * 3, -int(idx));
+        break;
+    case ArgumentMix::Floats:
+        logWithPolicy(logger, config.policy, "floats {} {}",
+                      idx * 0.25, float(idx) * 1.5f);
+        break;
+    case ArgumentMix::Literals:
+        logWithPolicy(logger, config.policy, "literals {} {}",
+                      "first literal", "second literal");
+        break;
+    case ArgumentMix::Strings:
+        logWithPolicy(logger, config.policy, "strings {}", text);
+        break;
+    case ArgumentMix::Mixed:
+        break;
+    // Values with many significant digits, which are costly to format.
+    case ArgumentMix::ShortestFloats:
+        logWithPolicy(logger, config.policy, "shortest {} {}",
+                      1.0 / (idx + 3), float(idx) / 7.0f);
+        break;
+    case ArgumentMix::FixedFloats:
+        logWithPolicy(logger, config.policy, "fixed {:.3f} {:.12f}",
+                      1.0 / (idx + 3), idx / 7.0);
+        break;
+    case ArgumentMix::ExponentFloats:
+        logWithPolicy(logger, config.policy, "exponent {:.6e} {:.16e}",
+                      1.0 / (idx + 3), idx / 7.0);
+        break;
+    }
+}
+
+Result run(const Case& config)
+{
+    Result result;
+    result.config = config;
+
+    NullSink nullSink;
+    MemorySink memorySink;
+    NullTextSink textSink;
+    SlowSink slowSink;
+    nullSink.latencies = &result.sinkLatency;
+    memorySink.latencies = &result.sinkLatency;
+    textSink.latencies = &result.sinkLatency;
+    slowSink.latencies = &result.sinkLatency;
+
+    std::vector<LatencyHistogram> histograms(config.numThreads);
+    std::atomic<unsigned> numReady{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> producersFinished{false};
+    Clock::time_point start, producersDone;
+
+    {
+        LogCore core(config.ringSize);
+        switch (config.sink)
+        {
+        case SinkKind::Null:   core.setSink(&nullSink); break;
+        case SinkKind::Memory: core.setSink(&memorySink); break;
+        case SinkKind::Text:   core.setSink(&textSink); break;
+        case SinkKind::Slow:   core.setSink(&slowSink); break;
+        }
+        if (config.reserved)
+            core.reserveSpace(Severity::Warn, config.reserved);
+        // String literals are only passed as pointers if they are located in
+        // the immutable string space.
+        if (registerReadOnlySegments(core) == 0
+            && config.arguments == ArgumentMix::Literals)
+        {
+            std::fprintf(stderr, "log11bench: No read-only segments found. "
+                                 "The literals are copied.\n");
+        }
+        Logger logger(&core);
+
+        auto produce = [&](unsigned threadIdx) {
+            std::string text = "a mutable string of thread "
+                               + std::to_string(threadIdx);
+            auto& histogram = histograms[threadIdx];
+            ++numReady;
+            while (!go)
+            {
+            }
+            for (std::uint64_t idx = 0; idx < config.numMessages; ++idx)
+            {
+                auto before = Clock::now();
+                logOne(logger, config, idx, text);
+                auto after = Clock::now();
+                histogram.record(std::chrono::duration_cast<
+                                 std::chrono::nanoseconds>(after - before).count());
+            }
+        };
+
+        auto probe = [&] {
+            ++numReady;
+            while (!go)
+            {
+            }
+            for (int idx = 0; !producersFinished; ++idx)
+            {
+                auto before = Clock::now();
+                logger.error("probe {}", idx);
+                auto after = Clock::now();
+                result.errorLatency.record(std::chrono::duration_cast<
+                                           std::chrono::nanoseconds>(after - before).count());
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned idx = 0; idx < config.numThreads; ++idx)
+            threads.emplace_back(produce, idx);
+        std::thread probeThread;
+        if (config.errorProbe)
+            probeThread = std::thread(probe);
+        unsigned numThreads = config.numThreads + (config.errorProbe ? 1 : 0);
+        while (numReady != numThreads)
+            std::this_thread::yield();
+
+        start = Clock::now();
+        go = true;
+        for (auto& thread : threads)
+            thread.join();
+        producersDone = Clock::now();
+        producersFinished = true;
+        if (probeThread.joinable())
+            probeThread.join();
+
+        // Destroying the core drains the ring buffer.
+    }
+    auto consumerDone = Clock::now();
+
+    for (const auto& histogram : histograms)
+        result.producerLatency.merge(histogram);
+    result.producerSeconds
+            = std::chrono::duration<double>(producersDone - start).count();
+    result.totalSeconds
+            = std::chrono::duration<double>(consumerDone - start).count();
+    result.numDelivered = nullSink.numRecords + memorySink.numRecords
+                          + textSink.numRecords + slowSink.numRecords;
+    return result;
+}
+
+// ----=====================================================================----
+//     Output
+// ----=====================================================================----
+
+enum class OutputFormat
+{
+    Csv,
+    Json
+};
+
+void printResult(const Result& result, OutputFormat format, bool isFirst)
+{
+    const auto& config = result.config;
+    auto numMessages = config.numMessages * config.numThreads;
+    double throughput = result.producerSeconds > 0
+                        ? numMessages / result.producerSeconds : 0;
+
+    if (format == OutputFormat::Csv)
+    {
+        if (isFirst)
+        {
+            std::printf("suite,threads,policy,ring_size,arguments,sink,"
+                        "messages,delivered,producer_seconds,total_seconds,"
+                        "messages_per_second,p50_ns,p99_ns,p999_ns,max_ns,"
+                        "sink_p50_ns,sink_p99_ns,sink_p999_ns,sink_max_ns,"
+                        "reserved,errors,error_p99_ns,error_max_ns\n");
+        }
+        std::printf("%s,%u,%s,%zu,%s,%s,%llu,%llu,%.6f,%.6f,%.0f,"
+                    "%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,"
+                    "%zu,%llu,%llu,%llu\n",
+                    config.suite, config.numThreads, toString(config.policy),
+                    config.ringSize, toString(config.arguments),
+                    toString(config.sink),
+                    (unsigned long long)numMessages,
+                    (unsigned long long)result.numDelivered,
+                    result.producerSeconds, result.totalSeconds, throughput,
+                    (unsigned long long)result.producerLatency.percentile(50),
+                    (unsigned long long)result.producerLatency.percentile(99),
+                    (unsigned long long)result.producerLatency.percentile(99.9),
+                    (unsigned long long)result.producerLatency.max(),
+                    (unsigned long long)result.sinkLatency.percentile(50),
+                    (unsigned long long)result.sinkLatency.percentile(99),
+                    (unsigned long long)result.sinkLatency.percentile(99.9),
+                    (unsigned long long)result.sinkLatency.max(),
+                    config.reserved,
+                    (unsigned long long)result.errorLatency.count(),
+                    (unsigned long long)result.errorLatency.percentile(99),
+                    (unsigned long long)result.errorLatency.max());
+    }
+    else
+    {
+        std::printf("%s\n  {\"suite\": \"%s\", \"threads\": %u, "
+                    "\"policy\": \"%s\", \"ring_size\": %zu, "
+                    "\"arguments\": \"%s\", \"sink\": \"%s\", "
+                    "\"messages\": %llu, \"delivered\": %llu, "
+                    "\"producer_seconds\": %.6f, \"total_seconds\": %.6f, "
+                    "\"messages_per_second\": %.0f, "
+                    "\"producer_latency_ns\": {\"p50\": %llu, \"p99\": %llu, "
+                    "\"p999\": %llu, \"max\": %llu}, "
+                    "\"sink_latency_ns\": {\"p50\": %llu, \"p99\": %llu, "
+                    "\"p999\": %llu, \"max\": %llu}, "
+                    "\"reserved\": %zu, \"errors\": %llu, "
+                    "\"error_latency_ns\": {\"p99\": %llu, \"max\": %llu}}",
+                    isFirst ? "[" : ",",
+                    config.suite, config.numThreads, toString(config.policy),
+                    config.ringSize, toString(config.arguments),
+                    toString(config.sink),
+                    (unsigned long long)numMessages,
+                    (unsigned long long)result.numDelivered,
+                    result.producerSeconds, result.totalSeconds, throughput,
+                    (unsigned long long)result.producerLatency.percentile(50),
+                    (unsigned long long)result.producerLatency.percentile(99),
+                    (unsigned long long)result.producerLatency.percentile(99.9),
+                    (unsigned long long)result.producerLatency.max(),
+                    (unsigned long long)result.sinkLatency.percentile(50),
+                    (unsigned long long)result.sinkLatency.percentile(99),
+                    (unsigned long long)result.sinkLatency.percentile(99.9),
+                    (unsigned long long)result.sinkLatency.max(),
+                    config.reserved,
+                    (unsigned long long)result.errorLatency.count(),
+                    (unsigned long long)result.errorLatency.percentile(99),
+                    (unsigned long long)result.errorLatency.max());
+    }
+    std::fflush(stdout);
+}
+
+bool contains(const std::vector<std::string>& list, const char* item)
+{
+    return list.empty()
+           || std::find(list.begin(), list.end(), item) != list.end();
+}
+
+std::vector<std::string> splitList(const char* text)
+{
+    std::vector<std::string> items;
+    std::string item;
+    for (; *text; ++text)
+    {
+        if (*text == ',')
+        {
+            items.push_back(item);
+            item.clear();
+        }
+        else
+        {
+            item.push_back(*text);
+        }
+    }
+    items.push_back(item);
+    return items;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> suites;
+    std::vector<unsigned> threadCounts = { 1, 2, 4, 8, 16, 32, 64 };
+    std::uint64_t numMessages = 100000;
+    OutputFormat format = OutputFormat::Csv;
+
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        if (std::strcmp(argv[idx], "-s") == 0 && idx + 1 < argc)
+        {
+            suites = splitList(argv[++idx]);
+        }
+        else if (std::strcmp(argv[idx], "-n") == 0 && idx + 1 < argc)
+        {
+            numMessages = std::strtoull(argv[++idx], nullptr, 10);
+        }
+        else if (std::strcmp(argv[idx], "-t") == 0 && idx + 1 < argc)
+        {
+            threadCounts.clear();
+            for (const auto& item : splitList(argv[++idx]))
+            {
+                int count = std::atoi(item.c_str());
+                if (count > 0)
+                    threadCounts.push_back(count);
+            }
+        }
+        else if (std::strcmp(argv[idx], "-f") == 0 && idx + 1 < argc)
+        {
+            ++idx;
+            format = std::strcmp(argv[idx], "json") == 0 ? OutputFormat::Json
+                                                        : OutputFormat::Csv;
+        }
+        else
+        {
+            std::fprintf(stderr,
+                         "Usage: log11bench [-s <suite>,...] [-n <messages>] "
+                         "[-t <threads>,...] [-f csv|json]\n");
+            return 2;
+        }
+    }
+
+    std::vector<Case> cases;
+    Case base;
+    base.numMessages = numMessages;
+
+    if (contains(suites, "latency"))
+    {
+        Case config = base;
+        config.suite = "latency";
+        cases.push_back(config);
+    }
+    if (contains(suites, "threads"))
+    {
+        for (auto numThreads : threadCounts)
+        {
+            Case config = base;
+            config.suite = "threads";
+            config.numThreads = numThreads;
+            cases.push_back(config);
+        }
+    }
+    if (contains(suites, "policy"))
+    {
+        for (auto policy : { LogCore::Block, LogCore::Truncate,
+                             LogCore::Discard, LogCore::BlockUntil })
+        {
+            Case config = base;
+            config.suite = "policy";
+            config.numThreads = 4;
+            config.policy = policy;
+            cases.push_back(config);
+        }
+    }
+    if (contains(suites, "ring"))
+    {
+        for (std::size_t ringSize : { 4 * 1024, 16 * 1024, 64 * 1024,
+                                      256 * 1024, 1024 * 1024 })
+        {
+            Case config = base;
+            config.suite = "ring";
+            config.ringSize = ringSize;
+            cases.push_back(config);
+        }
+    }
+    if (contains(suites, "args"))
+    {
+        for (auto mix : { ArgumentMix::Ints, ArgumentMix::Floats,
+                          ArgumentMix::Literals, ArgumentMix::Strings,
+                          ArgumentMix::Mixed })
+        {
+            Case config = base;
+            config.suite = "args";
+            config.arguments = mix;
+            cases.push_back(config);
+        }
+    }
+    if (contains(suites, "e2e"))
+    {
+        for (auto sink : { SinkKind::Null, SinkKind::Memory, SinkKind::Text })
+        {
+            Case config = base;
+            config.suite = "e2e";
+            config.arguments = ArgumentMix::Mixed;
+            config.sink = sink;
+            cases.push_back(config);
+        }
+    }
+
+    if (contains(suites, "reserve"))
+    {
+        for (std::size_t reserved : { 0, 4096 })
+        {
+            Case config = base;
+            config.suite = "reserve";
+            config.numThreads = 4;
+            config.sink = SinkKind::Slow;
+            config.reserved = reserved;
+            config.errorProbe = true;
+            cases.push_back(config);
+        }
+    }
+    if (contains(suites, "float"))
+    {
+        for (auto mix : { ArgumentMix::ShortestFloats, ArgumentMix::FixedFloats,
+                          ArgumentMix::ExponentFloats })
+        {
+            Case config = base;
+            config.suite = "float";
+            config.arguments = mix;
+            config.sink = SinkKind::Text;
+            cases.push_back(config);
+        }
+    }
+
+    bool isFirst = true;
+    for (const auto& config : cases)
+    {
+        printResult(run(config), format, isFirst);
+        isFirst = false;
+    }
+    if (format == OutputFormat::Json)
+        std::printf(isFirst ? "[]\n" : "\n]\n");
+    return 0;
+}
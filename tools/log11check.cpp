@@ -0,0 +1,1401 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+// log11check - Checks the output of the logging pipeline.
+//
+// Usage: log11check [<check>...]
+//
+// The checks are
+//   float     the float formatting round-trips and matches printf for random
+//             values
+//   json      the JSON Lines sink produces valid JSON
+//   repeats   repeated records are collapsed into periodic counts
+// By default, all checks are run. Failed expectations are written to the
+// standard error output and the exit code is 1.
+//
+// Build: g++ -std=c++14 -O2 -Isrc src/*.cpp tools/log11check.cpp -lpthread
+
+#include "BinaryDecoder.hpp"
+#include "BinaryFileSink.hpp"
+#include "BinarySink.hpp"
+#include "BlockCodec.hpp"
+#include "BlockIndex.hpp"
+#include "FloatFormatting.hpp"
+#include "ImageSegments.hpp"
+#include "JsonLinesSink.hpp"
+#include "Logger.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using namespace log11;
+
+
+namespace
+{
+
+unsigned numFailures = 0;
+
+void expect(bool condition, const char* check, const std::string& what)
+{
+    if (!condition)
+    {
+        std::fprintf(stderr, "%s: FAILED: %s\n", check, what.c_str());
+        ++numFailures;
+    }
+}
+
+// ----=====================================================================----
+//     JSON validation
+// ----=====================================================================----
+
+//! A minimal validator for JSON texts.
+class JsonValidator
+{
+public:
+    //! Returns \p true if the \p text is a single valid JSON value.
+    static
+    bool isValid(const std::string& text)
+    {
+        JsonValidator validator(text);
+        return validator.value() && validator.skipSpace() == text.size();
+    }
+
+private:
+    const std::string& m_text;
+    std::size_t m_pos;
+
+    explicit
+    JsonValidator(const std::string& text)
+        : m_text(text),
+          m_pos(0)
+    {
+    }
+
+    std::size_t skipSpace()
+    {
+        while (m_pos < m_text.size() && std::strchr(" \t\r\n", m_text[m_pos]))
+            ++m_pos;
+        return m_pos;
+    }
+
+    bool consume(char ch)
+    {
+        if (skipSpace() < m_text.size() && m_text[m_pos] == ch)
+        {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool literal(const char* word)
+    {
+        auto length = std::strlen(word);
+        if (m_text.compare(m_pos, length, word) != 0)
+            return false;
+        m_pos += length;
+        return true;
+    }
+
+    bool string()
+    {
+        if (!consume('"'))
+            return false;
+        while (m_pos < m_text.size())
+        {
+            unsigned char ch = m_text[m_pos++];
+            if (ch == '"')
+                return true;
+            if (ch < 0x20)
+                return false;
+            if (ch == '\\')
+            {
+                if (m_pos >= m_text.size())
+                    return false;
+                ch = m_text[m_pos++];
+                if (ch == 'u')
+                {
+                    for (int idx = 0; idx < 4; ++idx, ++m_pos)
+                    {
+                        if (m_pos >= m_text.size()
+                            || !std::isxdigit((unsigned char)m_text[m_pos]))
+                        {
+                            return false;
+                        }
+                    }
+                }
+                else if (!std::strchr("\"\\/bfnrt", ch))
+                {
+                    return false;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool number()
+    {
+        auto begin = m_pos;
+        if (m_pos < m_text.size() && m_text[m_pos] == '-')
+            ++m_pos;
+        auto digits = [&] {
+            auto first = m_pos;
+            while (m_pos < m_text.size() && std::isdigit((unsigned char)m_text[m_pos]))
+                ++m_pos;
+            return m_pos != first;
+        };
+        if (!digits())
+            return false;
+        if (m_pos < m_text.size() && m_text[m_pos] == '.')
+        {
+            ++m_pos;
+            if (!digits())
+                return false;
+        }
+        if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E'))
+        {
+            ++m_pos;
+            if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-'))
+                ++m_pos;
+            if (!digits())
+                return false;
+        }
+        return m_pos != begin;
+    }
+
+    bool value()
+    {
+        if (skipSpace() >= m_text.size())
+            return false;
+        switch (m_text[m_pos])
+        {
+        case '{':
+            ++m_pos;
+            if (consume('}'))
+                return true;
+            do
+            {
+                if (!string() || !consume(':') || !value())
+                    return false;
+            } while (consume(','));
+            return consume('}');
+        case '[':
+            ++m_pos;
+            if (consume(']'))
+                return true;
+            do
+            {
+                if (!value())
+                    return false;
+            } while (consume(','));
+            return consume(']');
+        case '"':
+            return string();
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+            return number();
+        }
+    }
+};
+
+// ----=====================================================================----
+//     Sinks
+// ----=====================================================================----
+
+//! A JSON Lines sink, which collects the lines.
+class CollectingJsonSink : public JsonLinesSink
+{
+public:
+    CollectingJsonSink()
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    virtual
+    void writeLine(const char* line, std::size_t size) override
+    {
+        // Strip the newline.
+        lines.emplace_back(line, size ? size - 1 : 0);
+        ++numLines;
+    }
+
+    //! The lines. Must not be accessed while the core is running.
+    std::vector<std::string> lines;
+    //! The number of lines, which can be read while the core is running.
+    std::atomic<unsigned> numLines{0};
+};
+
+//! A binary sink, which collects its output in memory.
+class MemoryBinarySink : public BinarySink
+{
+public:
+    MemoryBinarySink()
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    virtual
+    void writeByte(byte data) override
+    {
+        bytes.push_back(data);
+    }
+
+    //! The output. Must not be accessed while the core is running.
+    std::vector<unsigned char> bytes;
+};
+
+//! Decodes the binary \p data and formats the records into \p sink.
+//! Returns \p true if all records have been decoded.
+bool decodeAll(const std::vector<unsigned char>& data, TextSink& sink)
+{
+    BinaryDecoder decoder;
+    decoder.setData(data.data(), data.size());
+    DecodedRecord record;
+    BinaryDecoder::Status status;
+    while ((status = decoder.next(record)) == BinaryDecoder::Status::Ok)
+        decoder.format(record, sink);
+    return status == BinaryDecoder::Status::EndOfData;
+}
+
+//! A sink, which takes the given time to write a line.
+class SlowJsonSink : public CollectingJsonSink
+{
+public:
+    explicit
+    SlowJsonSink(std::chrono::microseconds delay)
+        : m_delay(delay)
+    {
+    }
+
+    virtual
+    void writeLine(const char* line, std::size_t size) override
+    {
+        CollectingJsonSink::writeLine(line, size);
+        std::this_thread::sleep_for(m_delay);
+    }
+
+private:
+    std::chrono::microseconds m_delay;
+};
+
+bool contains(const std::string& text, const char* part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+// ----=====================================================================----
+//     Checks
+// ----=====================================================================----
+
+//! The digits of a decimal number such that
+//! number = 0.digits * 10^decimalPoint without leading and trailing zeros.
+struct Decimal
+{
+    std::string digits;
+    int decimalPoint = 0;
+
+    bool operator==(const Decimal& other) const
+    {
+        return digits == other.digits
+               && (digits.empty() || decimalPoint == other.decimalPoint);
+    }
+};
+
+//! Creates a decimal from the output of one of the log11_detail functions.
+Decimal toDecimal(const char* digits, int numDigits, int decimalPoint)
+{
+    Decimal result;
+    result.digits.assign(digits, numDigits);
+    result.decimalPoint = decimalPoint;
+    while (!result.digits.empty() && result.digits.back() == '0')
+        result.digits.pop_back();
+    return result;
+}
+
+//! Parses a decimal from the output of printf() in the '%f' or '%e' style.
+Decimal parseDecimal(const char* text)
+{
+    Decimal result;
+    int numIntegerDigits = -1;
+    for (; *text && *text != 'e'; ++text)
+    {
+        if (*text == '.')
+            numIntegerDigits = int(result.digits.size());
+        else
+            result.digits.push_back(*text);
+    }
+    if (numIntegerDigits < 0)
+        numIntegerDigits = int(result.digits.size());
+    result.decimalPoint = numIntegerDigits + (*text ? std::atoi(text + 1) : 0);
+
+    std::size_t numLeadingZeros = 0;
+    while (   numLeadingZeros < result.digits.size()
+           && result.digits[numLeadingZeros] == '0')
+    {
+        ++numLeadingZeros;
+    }
+    result.digits.erase(0, numLeadingZeros);
+    result.decimalPoint -= int(numLeadingZeros);
+    while (!result.digits.empty() && result.digits.back() == '0')
+        result.digits.pop_back();
+    return result;
+}
+
+std::string toString(const Decimal& decimal)
+{
+    return "0." + decimal.digits + "e" + std::to_string(decimal.decimalPoint);
+}
+
+//! Returns a random, positive and finite value of type \p T, whose bit
+//! pattern is uniformly distributed.
+template <typename T, typename TBits>
+T randomValue(std::mt19937_64& generator)
+{
+    for (;;)
+    {
+        TBits bits = TBits(generator());
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        value = std::fabs(value);
+        if (std::isfinite(value) && value != 0)
+            return value;
+    }
+}
+
+template <typename T>
+bool readsBackAs(const char* text, T value);
+
+template <>
+bool readsBackAs<float>(const char* text, float value)
+{
+    return std::strtof(text, nullptr) == value;
+}
+
+template <>
+bool readsBackAs<double>(const char* text, double value)
+{
+    return std::strtod(text, nullptr) == value;
+}
+
+template <typename T, typename TBits>
+void checkShortest(std::mt19937_64& generator, unsigned numValues)
+{
+    const char* check = "float";
+    char digits[log11_detail::maxDecimalDigits<T>()];
+    char text[64];
+
+    for (unsigned count = 0; count < numValues; ++count)
+    {
+        T value = randomValue<T, TBits>(generator);
+        int decimalPoint;
+        int numDigits = log11_detail::shortestDigits(value, digits, decimalPoint);
+
+        // The digits have to read back as the same value.
+        std::snprintf(text, sizeof(text), "0.%.*se%d",
+                      numDigits, digits, decimalPoint);
+        if (!readsBackAs(text, value))
+        {
+            std::snprintf(text + std::strlen(text), 24, " != %.9g", double(value));
+            expect(false, check, std::string("shortest round trip: ") + text);
+            continue;
+        }
+
+        // One digit less, correctly rounded, must not read back.
+        if (numDigits > 1)
+        {
+            std::snprintf(text, sizeof(text), "%.*e", numDigits - 2, double(value));
+            expect(!readsBackAs(text, value), check,
+                   std::string("not the shortest: ") + text);
+        }
+    }
+}
+
+void checkPrecision(std::mt19937_64& generator, unsigned numValues)
+{
+    const char* check = "float";
+    char digits[log11_detail::maxDecimalDigits<double>()];
+    char text[64];
+    std::uniform_int_distribution<int> precisionDistribution(1, 40);
+
+    for (unsigned count = 0; count < numValues; ++count)
+    {
+        double value = randomValue<double, std::uint64_t>(generator);
+        int precision = precisionDistribution(generator);
+        int decimalPoint;
+        int numDigits = log11_detail::precisionDigits(value, precision,
+                                                      digits, decimalPoint);
+        std::snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+        auto expected = parseDecimal(text);
+        auto actual = toDecimal(digits, numDigits, decimalPoint);
+        expect(actual == expected, check,
+               "precision " + std::to_string(precision) + ": " + text
+               + " != " + toString(actual));
+    }
+}
+
+void checkFixed(std::mt19937_64& generator, unsigned numValues)
+{
+    const char* check = "float";
+    char digits[log11_detail::maxDecimalDigits<double>()];
+    char text[512];
+    std::uniform_int_distribution<int> fractionDistribution(0, 30);
+    std::uniform_real_distribution<double> exponentDistribution(-35, 35);
+
+    for (unsigned count = 0; count < numValues; ++count)
+    {
+        // Keep the values in a range where fixed-point output is used.
+        double value = std::pow(10.0, exponentDistribution(generator));
+        int numFractionalDigits = fractionDistribution(generator);
+        int decimalPoint;
+        int numDigits = log11_detail::fixedDigits(value, numFractionalDigits,
+                                                  digits, decimalPoint);
+        std::snprintf(text, sizeof(text), "%.*f", numFractionalDigits, value);
+        auto expected = parseDecimal(text);
+        auto actual = toDecimal(digits, numDigits, decimalPoint);
+        expect(actual == expected, check,
+               "fixed " + std::to_string(numFractionalDigits) + ": " + text
+               + " != " + toString(actual));
+    }
+}
+
+void checkFloat()
+{
+    std::mt19937_64 generator(0x1011);
+    checkShortest<double, std::uint64_t>(generator, 200000);
+    checkShortest<float, std::uint32_t>(generator, 200000);
+    checkPrecision(generator, 100000);
+    checkFixed(generator, 100000);
+}
+
+void checkJson()
+{
+    const char* check = "json";
+
+    CollectingJsonSink sink;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        Logger logger(&core);
+        logger.setLevel(Severity::Trace);
+
+        logger.info("after field", kv("a", 1), 5);
+        logger.info("non-finite", kv("nan", std::nan("")),
+                    kv("inf", -HUGE_VAL), kv("finite", 1.5));
+        logger.info("escaped {}", "quote \" backslash \\ tab \t",
+                    kv("s", "x\"y\n"));
+        logger.info("non-finite {} {}", std::nan(""), HUGE_VAL);
+
+        // Destroying the core drains the ring buffer.
+    }
+
+    expect(sink.lines.size() == 4, check, "number of lines");
+    for (const auto& line : sink.lines)
+        expect(JsonValidator::isValid(line), check, "invalid JSON: " + line);
+    if (sink.lines.size() != 4)
+        return;
+
+    expect(contains(sink.lines[0], "\"message\":\"after field <5>\""),
+           check, "argument after a field: " + sink.lines[0]);
+    expect(contains(sink.lines[0], "\"a\":1}"),
+           check, "field before an argument: " + sink.lines[0]);
+    expect(contains(sink.lines[1], "\"nan\":null,\"inf\":null,\"finite\":1.5}"),
+           check, "non-finite fields: " + sink.lines[1]);
+    expect(contains(sink.lines[2], "\"s\":\"x\\\"y\\n\""),
+           check, "escaped field: " + sink.lines[2]);
+    expect(contains(sink.lines[3], "\"message\":\"non-finite nan inf\""),
+           check, "non-finite arguments: " + sink.lines[3]);
+    expect(!contains(sink.lines[0], "\"seq\""),
+           check, "sequence number by default: " + sink.lines[0]);
+
+    CollectingJsonSink sequenceSink;
+    sequenceSink.setSequenceNumbersEnabled(true);
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sequenceSink);
+        Logger logger(&core);
+        logger.info("first");
+        logger.info("second");
+    }
+
+    expect(sequenceSink.lines.size() == 2, check, "number of lines");
+    if (sequenceSink.lines.size() != 2)
+        return;
+    expect(contains(sequenceSink.lines[0], ",\"seq\":1,"),
+           check, "sequence number: " + sequenceSink.lines[0]);
+    expect(contains(sequenceSink.lines[1], ",\"seq\":2,"),
+           check, "sequence number: " + sequenceSink.lines[1]);
+}
+
+void checkRepeats()
+{
+    const char* check = "repeats";
+    const int numRecords = 50;
+
+    CollectingJsonSink sink;
+    unsigned numLinesWhileRunning;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        core.setDuplicateSuppression(std::chrono::milliseconds(100));
+        Logger logger(&core);
+
+        // A loop, which is slower than the consumer, such that the ring
+        // buffer runs empty between the records.
+        for (int idx = 0; idx < numRecords; ++idx)
+        {
+            logger.error("same {}", 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        // The last run has to be reported without further records.
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        numLinesWhileRunning = sink.numLines;
+    }
+
+    expect(sink.numLines == numLinesWhileRunning, check,
+           "the last run has only been reported on destruction");
+    // The record itself and roughly one count per 100 ms.
+    expect(sink.lines.size() >= 2 && sink.lines.size() <= 10, check,
+           "number of lines: " + std::to_string(sink.lines.size()));
+    if (sink.lines.empty())
+        return;
+    expect(contains(sink.lines[0], "\"message\":\"same 1\""),
+           check, "first line: " + sink.lines[0]);
+
+    const char* prefix = "\"message\":\"log11 record 1 repeated ";
+    unsigned numRepeats = 0;
+    for (std::size_t idx = 1; idx < sink.lines.size(); ++idx)
+    {
+        const auto& line = sink.lines[idx];
+        auto pos = line.find(prefix);
+        unsigned count = 0;
+        if (   pos == std::string::npos
+            || std::sscanf(line.c_str() + pos + std::strlen(prefix),
+                           "%u", &count) != 1)
+        {
+            expect(false, check, "not a repeat count: " + line);
+            continue;
+        }
+        numRepeats += count;
+    }
+    expect(numRepeats == numRecords - 1, check,
+           "number of repeats: " + std::to_string(numRepeats));
+}
+
+//! A sink, which is slower than the producer. While the second line is
+//! written, it decodes the records, which are pending in the spill file.
+class SlowSpillingSink : public SlowJsonSink
+{
+public:
+    explicit
+    SlowSpillingSink(const char* path)
+        : SlowJsonSink(std::chrono::milliseconds(1)),
+          m_path(path)
+    {
+    }
+
+    virtual
+    void writeLine(const char* line, std::size_t size) override
+    {
+        if (lines.size() == 1)
+            decodeSpillFile();
+        SlowJsonSink::writeLine(line, size);
+    }
+
+    //! The records, which have been decoded from the spill file.
+    CollectingJsonSink spilledSink;
+    //! Set if the spill file has been decoded without errors.
+    bool isSpillFileValid = false;
+
+private:
+    const char* m_path;
+
+    void decodeSpillFile()
+    {
+        std::FILE* file = std::fopen(m_path, "rb");
+        if (!file)
+            return;
+        std::vector<unsigned char> data;
+        char chunk[4096];
+        std::size_t size;
+        while ((size = std::fread(chunk, 1, sizeof(chunk), file)) != 0)
+            data.insert(data.end(), chunk, chunk + size);
+        std::fclose(file);
+
+        isSpillFileValid = decodeAll(data, spilledSink);
+    }
+};
+
+void checkSpill()
+{
+    const char* check = "spill";
+    const char* path = "log11check.spill";
+    const int numRecords = 100;
+
+    SlowSpillingSink sink(path);
+    unsigned numSpilled;
+    {
+        LogCore core(16 * 1024);
+        registerReadOnlySegments(core);
+        core.setSink(&sink);
+        expect(core.enableSpilling(1024, path), check, "cannot create file");
+        Logger logger(&core);
+
+        for (int idx = 0; idx < numRecords; ++idx)
+            logger.info("record {} {}", idx, "literal", kv("k", idx));
+
+        while (sink.numLines < numRecords)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        numSpilled = core.stats().numSpilled;
+    }
+    std::remove(path);
+
+    expect(numSpilled > 0, check, "no record has been spilled");
+    expect(sink.lines.size() == numRecords, check,
+           "number of lines: " + std::to_string(sink.lines.size()));
+    for (std::size_t idx = 0; idx < sink.lines.size(); ++idx)
+    {
+        auto message = "\"message\":\"record " + std::to_string(idx)
+                       + " literal\"";
+        auto field = "\"k\":" + std::to_string(idx) + "}";
+        expect(   contains(sink.lines[idx], message.c_str())
+               && contains(sink.lines[idx], field.c_str()),
+               check, "line " + std::to_string(idx) + ": " + sink.lines[idx]);
+    }
+
+    // The spill file can be read without the process, which has written it.
+    expect(sink.isSpillFileValid, check, "the spill file cannot be decoded");
+    expect(!sink.spilledSink.lines.empty(), check, "the spill file is empty");
+    if (!sink.spilledSink.lines.empty())
+    {
+        expect(contains(sink.spilledSink.lines[0], " literal\""),
+               check, "spilled record: " + sink.spilledSink.lines[0]);
+    }
+}
+
+void checkDecoder()
+{
+    const char* check = "decoder";
+
+    // A record with nested structs, which are closed properly.
+    const int depth = 8;
+    std::vector<unsigned char> data = { 0x72, 0x00, 0x00 };
+    for (int idx = 0; idx < depth; ++idx)
+        data.insert(data.end(), { 0x60, 0x01 });
+    data.push_back(0x01);
+    data.insert(data.end(), depth + 1, 0xFF);
+
+    BinaryDecoder decoder;
+    decoder.setData(data.data(), data.size());
+    DecodedRecord record;
+    expect(decoder.next(record) == BinaryDecoder::Status::Ok,
+           check, "nested structs");
+    CollectingJsonSink sink;
+    decoder.format(record, sink);
+    expect(sink.lines.size() == 1, check, "nested structs are not formatted");
+    expect(decoder.next(record) == BinaryDecoder::Status::EndOfData,
+           check, "end of nested structs");
+
+    // A corrupt record, which nests far too deep. The decoder must reject
+    // it instead of overflowing the stack.
+    data.assign({ 0x72, 0x00, 0x00 });
+    for (int idx = 0; idx < 2000000; ++idx)
+        data.insert(data.end(), { 0x60, 0x01 });
+    decoder.setData(data.data(), data.size());
+    expect(decoder.next(record) == BinaryDecoder::Status::Malformed,
+           check, "deep nesting is not rejected");
+}
+
+void checkReserve()
+{
+    const char* check = "reserve";
+    const int numErrors = 20;
+    // Without the reservation, an error waits for the slow sink to free
+    // space, which takes several milliseconds.
+    const auto maxLatency = std::chrono::milliseconds(2);
+
+    SlowJsonSink sink(std::chrono::microseconds(200));
+    std::chrono::steady_clock::duration worstLatency{};
+    LogStatistics stats;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        core.reserveSpace(Severity::Error, 4096);
+        Logger logger(&core);
+        logger.setLevel(Severity::Trace);
+
+        // Debug records fill the ring buffer up to the reservation and
+        // block there.
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> flooders;
+        for (int idx = 0; idx < 2; ++idx)
+        {
+            flooders.emplace_back([&] {
+                while (!stop)
+                    logger.debug("flood {}", 1);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        for (int idx = 0; idx < numErrors; ++idx)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            logger.error("error {}", idx);
+            auto latency = std::chrono::steady_clock::now() - begin;
+            if (latency > worstLatency)
+                worstLatency = latency;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        stop = true;
+        for (auto& flooder : flooders)
+            flooder.join();
+        stats = core.stats();
+    }
+
+    auto worstMicroseconds = std::chrono::duration_cast<
+            std::chrono::microseconds>(worstLatency).count();
+    expect(worstLatency <= maxLatency, check,
+           "error latency: " + std::to_string(worstMicroseconds) + " us");
+    expect(stats.numDropped[static_cast<unsigned>(Severity::Error)] == 0,
+           check, "errors have been dropped");
+
+    int numErrorLines = 0;
+    for (const auto& line : sink.lines)
+        numErrorLines += contains(line, "\"message\":\"error ");
+    expect(numErrorLines == numErrors, check,
+           "number of errors: " + std::to_string(numErrorLines));
+}
+
+void checkDictionary()
+{
+    const char* check = "dictionary";
+
+    // An immutable string, which is too long for the 16-bit length of a
+    // dictionary definition.
+    std::string text(70000, 'x');
+    MemoryBinarySink sink;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        core.setImmutableStringSpace(
+                reinterpret_cast<std::uintptr_t>(text.data()),
+                reinterpret_cast<std::uintptr_t>(text.data() + text.size() + 1));
+        Logger logger(&core);
+        logger.info("{} end", text.c_str());
+        logger.info("{} again", text.c_str());
+    }
+
+    CollectingJsonSink textSink;
+    expect(decodeAll(sink.bytes, textSink), check, "malformed output");
+    expect(textSink.lines.size() == 2, check,
+           "number of records: " + std::to_string(textSink.lines.size()));
+    if (textSink.lines.size() != 2)
+        return;
+    auto clipped = std::string(0xFFFF, 'x');
+    expect(contains(textSink.lines[0], (clipped + " end\"").c_str()),
+           check, "the definition is not clipped");
+    expect(contains(textSink.lines[1], (clipped + " again\"").c_str()),
+           check, "the reference is not resolved");
+}
+
+void checkFlightRecorder()
+{
+    const char* check = "flight";
+    const int numRetained = 100;
+
+    CollectingJsonSink sink;
+    sink.setSequenceNumbersEnabled(true);
+    LogStatistics stats;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        core.setFlightRecorder(1024, Severity::Info, Severity::Error);
+        Logger logger(&core);
+        logger.setLevel(Severity::Trace);
+
+        // The flight recorder keeps only the last few debug records.
+        for (int idx = 0; idx < numRetained; ++idx)
+            logger.debug("retained {}", idx);
+        logger.error("trigger");
+        logger.debug("never dumped");
+
+        while (core.stats().numConsumed < numRetained + 2)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = core.stats();
+    }
+
+    // The sequence numbers have no gaps, although most of the retained
+    // records have been evicted.
+    for (std::size_t idx = 0; idx < sink.lines.size(); ++idx)
+    {
+        auto seq = ",\"seq\":" + std::to_string(idx + 1) + ",";
+        expect(contains(sink.lines[idx], seq.c_str()),
+               check, "sequence number: " + sink.lines[idx]);
+    }
+    expect(sink.lines.size() > 1 && sink.lines.size() < numRetained,
+           check, "number of lines: " + std::to_string(sink.lines.size()));
+    if (sink.lines.empty())
+        return;
+    expect(contains(sink.lines.back(), "\"message\":\"trigger\""),
+           check, "last line: " + sink.lines.back());
+    expect(stats.numRetainedDiscarded == numRetained + 1 - sink.lines.size(),
+           check, "discarded records: "
+                  + std::to_string(stats.numRetainedDiscarded));
+}
+
+void checkDrops()
+{
+    const char* check = "drops";
+
+    //! Flags the drop marker while the core is running.
+    class MarkerSink : public SlowJsonSink
+    {
+    public:
+        MarkerSink()
+            : SlowJsonSink(std::chrono::microseconds(200))
+        {
+        }
+
+        virtual
+        void writeLine(const char* line, std::size_t size) override
+        {
+            if (std::strstr(line, "log11 dropped "))
+                hasMarker = true;
+            SlowJsonSink::writeLine(line, size);
+        }
+
+        std::atomic<bool> hasMarker{false};
+    };
+
+    MarkerSink sink;
+    bool isReported = false;
+    {
+        LogCore core(1024);
+        core.setSink(&sink);
+        Logger logger(&core);
+
+        // A burst, which overflows the ring buffer, followed by silence.
+        for (int idx = 0; idx < 200; ++idx)
+            logger.info(may_discard, "burst {}", idx);
+
+        auto deadline = std::chrono::steady_clock::now()
+                        + std::chrono::seconds(1);
+        while (!sink.hasMarker && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        isReported = sink.hasMarker;
+    }
+
+    expect(isReported, check, "the drops have not been reported");
+}
+
+//! Reads the whole file \p path into \p data. Returns \p false if the file
+//! cannot be opened.
+bool readFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    data.clear();
+    char chunk[4096];
+    std::size_t size;
+    while ((size = std::fread(chunk, 1, sizeof(chunk), file)) != 0)
+        data.insert(data.end(), chunk, chunk + size);
+    std::fclose(file);
+    return true;
+}
+
+//! The number of records in a test file.
+const int numFileRecords = 2000;
+
+//! Writes a test file with small blocks to \p path. The records are
+//! informational except for a few errors in the middle.
+void writeTestFile(const char* path, BlockCodec* codec)
+{
+    BinaryFileSink sink;
+    sink.setEnabled(true);
+    sink.setLevel(Severity::Trace);
+    sink.setBlockSize(1024);
+    sink.setCodec(codec);
+    if (!sink.open(path))
+        return;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        Logger logger(&core);
+        for (int idx = 0; idx < numFileRecords; ++idx)
+        {
+            if (idx >= 1000 && idx < 1005)
+                logger.error("record {}", idx);
+            else
+                logger.info("record {}", idx);
+        }
+    }
+    sink.close();
+}
+
+//! Loads the index of the file \p path into \p blocks.
+bool readIndex(const std::string& path, std::vector<BlockInfo>& blocks)
+{
+    std::vector<unsigned char> data;
+    if (   !readFile(path + ".idx", data)
+        || data.size() < sizeof(BlockIndex::magic)
+        || std::memcmp(data.data(), BlockIndex::magic,
+                       sizeof(BlockIndex::magic)) != 0)
+    {
+        return false;
+    }
+    blocks.clear();
+    for (std::size_t offset = sizeof(BlockIndex::magic);
+         offset + BlockIndex::entrySize <= data.size();
+         offset += BlockIndex::entrySize)
+    {
+        blocks.push_back(BlockIndex::decode(data.data() + offset));
+    }
+    return true;
+}
+
+//! Checks that the \p lines are the records of a test file.
+void expectTestRecords(const std::vector<std::string>& lines,
+                       const char* check, const char* what)
+{
+    expect(lines.size() == numFileRecords, check,
+           std::string(what) + ": number of records: "
+           + std::to_string(lines.size()));
+    for (std::size_t idx = 0; idx < lines.size(); ++idx)
+    {
+        auto message = "\"message\":\"record " + std::to_string(idx) + "\"";
+        if (!contains(lines[idx], message.c_str()))
+        {
+            expect(false, check, std::string(what) + ": " + lines[idx]);
+            return;
+        }
+    }
+}
+
+void checkBlocks()
+{
+    const char* check = "blocks";
+    const char* path = "log11check.bin";
+
+    writeTestFile(path, nullptr);
+    std::vector<unsigned char> data;
+    std::vector<BlockInfo> blocks;
+    bool hasData = readFile(path, data);
+    bool hasIndex = readIndex(path, blocks);
+    std::remove(path);
+    std::remove((std::string(path) + ".idx").c_str());
+    expect(hasData, check, "the file has not been written");
+    expect(hasIndex, check, "the index has not been written");
+
+    // Decode the file as a whole.
+    CollectingJsonSink wholeSink;
+    expect(decodeAll(data, wholeSink), check, "malformed file");
+    expectTestRecords(wholeSink.lines, check, "whole file");
+
+    // Decode the file in chunks, which start at the block headers found
+    // by findBlock().
+    BinaryDecoder decoder;
+    decoder.setData(data.data(), data.size());
+    std::vector<std::size_t> chunkBegins;
+    for (std::size_t offset = 0; offset < data.size(); offset += 4096)
+    {
+        offset = decoder.findBlock(offset);
+        if (offset >= data.size())
+            break;
+        chunkBegins.push_back(offset);
+    }
+    expect(chunkBegins.size() > 1, check, "no chunks");
+    CollectingJsonSink chunkSink;
+    for (std::size_t idx = 0; idx < chunkBegins.size(); ++idx)
+    {
+        auto stop = idx + 1 < chunkBegins.size() ? chunkBegins[idx + 1]
+                                                 : data.size();
+        decoder.seek(chunkBegins[idx]);
+        expect(decoder.isAtBlockHeader(), check,
+               "no block header at " + std::to_string(chunkBegins[idx]));
+        DecodedRecord record;
+        while (   decoder.position() < stop
+               && decoder.next(record) == BinaryDecoder::Status::Ok)
+        {
+            decoder.format(record, chunkSink);
+        }
+    }
+    expectTestRecords(chunkSink.lines, check, "chunks");
+
+    // The index describes consecutive blocks, which cover the file.
+    std::uint64_t expectedOffset = 0;
+    unsigned numRecords = 0;
+    for (const auto& block : blocks)
+    {
+        expect(block.offset == expectedOffset, check,
+               "index entry at " + std::to_string(block.offset));
+        decoder.seek(block.offset);
+        expect(decoder.isAtBlockHeader(), check,
+               "no block header at " + std::to_string(block.offset));
+        expectedOffset = block.offset + block.size;
+        numRecords += block.numRecords;
+    }
+    expect(expectedOffset == data.size(), check, "the index is incomplete");
+    expect(numRecords == numFileRecords, check,
+           "records in the index: " + std::to_string(numRecords));
+
+    // Only the blocks with errors are decoded for an error filter.
+    RecordFilter filter;
+    filter.severities = RecordFilter::atLeast(Severity::Error);
+    decoder.setFilter(filter);
+    unsigned numSelected = 0;
+    unsigned numErrors = 0;
+    for (const auto& block : blocks)
+    {
+        if (!filter.matches(block))
+            continue;
+        ++numSelected;
+        decoder.seek(block.offset);
+        DecodedRecord record;
+        while (   decoder.position() < block.offset + block.size
+               && decoder.next(record) == BinaryDecoder::Status::Ok)
+        {
+            ++numErrors;
+        }
+    }
+    expect(numSelected > 0 && numSelected < 3, check,
+           "blocks selected by the index: " + std::to_string(numSelected));
+    expect(numErrors == 5, check,
+           "errors in the selected blocks: " + std::to_string(numErrors));
+}
+
+void checkLz4()
+{
+    const char* check = "lz4";
+    const char* path = "log11check.lz4";
+
+    Lz4Codec codec;
+    writeTestFile(path, &codec);
+    std::vector<unsigned char> data;
+    std::vector<BlockInfo> blocks;
+    bool hasData = readFile(path, data);
+    bool hasIndex = readIndex(path, blocks);
+    std::remove(path);
+    std::remove((std::string(path) + ".idx").c_str());
+    expect(hasData, check, "the file has not been written");
+    expect(hasIndex, check, "the index has not been written");
+
+    // Decompress and decode the frames one by one.
+    CollectingJsonSink sink;
+    std::vector<std::size_t> frameOffsets;
+    std::vector<unsigned char> block;
+    BlockFrame firstFrame;
+    for (std::size_t offset = 0; offset < data.size();)
+    {
+        BlockFrame frame;
+        if (!frame.decodeHeader(data.data() + offset, data.size() - offset))
+        {
+            expect(false, check, "no frame at " + std::to_string(offset));
+            break;
+        }
+        if (frameOffsets.empty())
+            firstFrame = frame;
+        frameOffsets.push_back(offset);
+        auto payload = data.data() + offset + BlockFrame::headerSize;
+        block.resize(frame.rawSize);
+        if (frame.codec == 0)
+        {
+            std::memcpy(block.data(), payload, frame.rawSize);
+        }
+        else if (   frame.codec != Lz4Codec::codecId
+                 || !codec.decompress(payload, frame.payloadSize,
+                                      block.data(), block.size()))
+        {
+            expect(false, check, "bad frame at " + std::to_string(offset));
+        }
+        expect(decodeAll(block, sink), check,
+               "malformed block at " + std::to_string(offset));
+        offset += BlockFrame::headerSize + frame.payloadSize;
+    }
+    expectTestRecords(sink.lines, check, "frames");
+
+    // The index has one entry per frame.
+    expect(blocks.size() == frameOffsets.size(), check,
+           "index entries: " + std::to_string(blocks.size()));
+    for (std::size_t idx = 0; idx < blocks.size() && idx < frameOffsets.size();
+         ++idx)
+    {
+        expect(blocks[idx].offset == frameOffsets[idx], check,
+               "index entry at " + std::to_string(blocks[idx].offset));
+    }
+
+    // Truncated and corrupt frames are rejected.
+    if (firstFrame.codec != Lz4Codec::codecId || firstFrame.payloadSize < 2)
+    {
+        expect(false, check, "the first frame is not compressed");
+        return;
+    }
+    auto payload = data.data() + BlockFrame::headerSize;
+    block.resize(firstFrame.rawSize);
+    expect(!codec.decompress(payload, firstFrame.payloadSize - 1,
+                             block.data(), block.size()),
+           check, "a truncated frame is accepted");
+    expect(!codec.decompress(payload, firstFrame.payloadSize / 2,
+                             block.data(), block.size()),
+           check, "a frame cut in half is accepted");
+    expect(!codec.decompress(payload, firstFrame.payloadSize,
+                             block.data(), block.size() - 1),
+           check, "a frame with a wrong size is accepted");
+
+    // A literal length, which runs past the end of the input.
+    const std::uint8_t longLiterals[] = { 0xF0, 0xFF, 0xFF, 0x10 };
+    // A match before the begin of the output.
+    const std::uint8_t badOffset[] = { 0x14, 'a', 0x02, 0x00 };
+    // A match with an offset of zero.
+    const std::uint8_t zeroOffset[] = { 0x14, 'a', 0x00, 0x00 };
+    std::uint8_t output[16];
+    expect(!codec.decompress(longLiterals, sizeof(longLiterals),
+                             output, sizeof(output)),
+           check, "a long literal run is accepted");
+    expect(!codec.decompress(badOffset, sizeof(badOffset), output, 9),
+           check, "a match before the output is accepted");
+    expect(!codec.decompress(zeroOffset, sizeof(zeroOffset), output, 9),
+           check, "a match with offset zero is accepted");
+}
+
+//! Returns the indices of the \p lines, which contain \p part.
+std::vector<std::size_t> findLines(const std::vector<std::string>& lines,
+                                   const char* part)
+{
+    std::vector<std::size_t> found;
+    for (std::size_t idx = 0; idx < lines.size(); ++idx)
+        if (contains(lines[idx], part))
+            found.push_back(idx);
+    return found;
+}
+
+void checkDeferred()
+{
+    const char* check = "deferred";
+    const int numFailed = 50;
+    const int numEvicting = 1000;
+
+    CollectingJsonSink sink;
+    LogStatistics stats;
+    {
+        LogCore core(64 * 1024);
+        core.setSink(&sink);
+        Logger logger(&core);
+
+        // A scope, which succeeds, is rewound.
+        {
+            auto scope = logger.deferredScope(4096);
+            for (int idx = 0; idx < 10; ++idx)
+                scope.info("rewound {}", idx);
+        }
+
+        // The records of a failed scope are published while another
+        // thread is logging.
+        std::atomic<bool> stop{false};
+        std::atomic<unsigned> numOther{0};
+        std::thread other([&] {
+            while (!stop)
+            {
+                logger.info("other {}", numOther.load());
+                ++numOther;
+            }
+        });
+        while (numOther < 100)
+            std::this_thread::yield();
+        {
+            auto scope = logger.deferredScope(8192);
+            for (int idx = 0; idx < numFailed; ++idx)
+                scope.info("failed {}", idx);
+            scope.fail();
+        }
+        stop = true;
+        other.join();
+
+        // An arena evicts its oldest records when it is full. The arena
+        // may be taken from the thread's cache, so it can be larger than
+        // requested.
+        {
+            auto scope = logger.deferredScope(1024);
+            for (int idx = 0; idx < numEvicting; ++idx)
+                scope.warn("evicted {}", idx);
+            scope.fail();
+        }
+        stats = core.stats();
+    }
+
+    expect(findLines(sink.lines, "rewound ").empty(),
+           check, "a successful scope has been logged");
+
+    // Every record of the failed scope is logged once and the records
+    // of the other thread do not interleave with them.
+    auto failed = findLines(sink.lines, "\"message\":\"failed ");
+    expect(failed.size() == numFailed,
+           check, "failed records: " + std::to_string(failed.size()));
+    for (std::size_t idx = 0; idx < failed.size(); ++idx)
+    {
+        auto message = "\"message\":\"failed " + std::to_string(idx) + "\"";
+        if (   !contains(sink.lines[failed[idx]], message.c_str())
+            || failed[idx] != failed[0] + idx)
+        {
+            expect(false, check, "interleaved: " + sink.lines[failed[idx]]);
+            break;
+        }
+    }
+
+    // The evicted records are counted as drops and the latest records
+    // are kept.
+    auto evicted = findLines(sink.lines, "\"message\":\"evicted ");
+    expect(!evicted.empty() && evicted.size() < numEvicting,
+           check, "kept records: " + std::to_string(evicted.size()));
+    if (!evicted.empty())
+    {
+        auto message = "\"evicted " + std::to_string(numEvicting - 1) + "\"";
+        expect(contains(sink.lines[evicted.back()], message.c_str()),
+               check, "last record: " + sink.lines[evicted.back()]);
+    }
+    auto numDropped = stats.numDropped[static_cast<unsigned>(Severity::Warn)];
+    expect(numDropped == numEvicting - evicted.size(),
+           check, "dropped records: " + std::to_string(numDropped));
+}
+
+void checkCallSiteFilters()
+{
+    const char* check = "filters";
+
+    CollectingJsonSink sink;
+    {
+        LogCore core(16 * 1024);
+        core.setSink(&sink);
+        Logger logger(&core);
+
+        // A burst of 5 records passes the limit. The next record after the
+        // emission interval carries the number of suppressed records.
+        RateLimit limit(10, std::chrono::seconds(1), 5);
+        for (int idx = 0; idx < 100; ++idx)
+            logger.log(limit, Severity::Warn, "limited {}", idx);
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        logger.log(limit, Severity::Warn, "limited {}", 100);
+
+        // One out of 10 records passes the sampler.
+        Sampler sampler(10);
+        for (int idx = 0; idx < 95; ++idx)
+            logger.log(sampler, Severity::Info, "sampled {}", idx);
+    }
+
+    auto limited = findLines(sink.lines, "\"message\":\"limited ");
+    expect(limited.size() == 6,
+           check, "limited records: " + std::to_string(limited.size()));
+    for (std::size_t idx = 0; idx < limited.size() && idx < 5; ++idx)
+    {
+        auto message = "\"message\":\"limited " + std::to_string(idx) + "\"";
+        expect(   contains(sink.lines[limited[idx]], message.c_str())
+               && !contains(sink.lines[limited[idx]], "suppressed"),
+               check, "burst: " + sink.lines[limited[idx]]);
+    }
+    if (limited.size() == 6)
+    {
+        const auto& line = sink.lines[limited.back()];
+        expect(   contains(line, "\"limited 100\"")
+               && contains(line, "\"suppressed\":95"),
+               check, "after the burst: " + line);
+    }
+
+    auto sampled = findLines(sink.lines, "\"message\":\"sampled ");
+    expect(sampled.size() == 10,
+           check, "sampled records: " + std::to_string(sampled.size()));
+    for (std::size_t idx = 0; idx < sampled.size(); ++idx)
+    {
+        const auto& line = sink.lines[sampled[idx]];
+        auto message = "\"sampled " + std::to_string(10 * idx) + "\"";
+        expect(   contains(line, message.c_str())
+               && contains(line, "\"suppressed\":9") == (idx != 0),
+               check, "sample: " + line);
+    }
+}
+
+struct Check
+{
+    const char* name;
+    void (*run)();
+};
+
+const Check checks[] = {
+    { "float", checkFloat },
+    { "json", checkJson },
+    { "repeats", checkRepeats },
+    { "spill", checkSpill },
+    { "decoder", checkDecoder },
+    { "reserve", checkReserve },
+    { "dictionary", checkDictionary },
+    { "flight", checkFlightRecorder },
+    { "drops", checkDrops },
+    { "blocks", checkBlocks },
+    { "lz4", checkLz4 },
+    { "deferred", checkDeferred },
+    { "filters", checkCallSiteFilters },
+};
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    for (const auto& check : checks)
+    {
+        bool selected = argc == 1;
+        for (int idx = 1; idx < argc; ++idx)
+            selected |= std::strcmp(argv[idx], check.name) == 0;
+        if (!selected)
+            continue;
+
+        auto before = numFailures;
+        check.run();
+        std::printf("%-10s %s\n", check.name,
+                    numFailures == before ? "ok" : "FAILED");
+    }
+    return numFailures ? 1 : 0;
+}
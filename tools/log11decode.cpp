@@ -0,0 +1,743 @@
+/*******************************************************************************
+  log11
+  https://github.com/ombre5733/log11
+
+  Copyright (c) 2016, Manuel Freiberger
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice, this
+    list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+// log11decode - Decodes the output of a log11::BinarySink to text.
+//
+// Usage: log11decode [-H <header>] [-j <jobs>]
+//                    [-s <time>] [-u <time>] [-l <severity>] <file>...
+//
+// The files are memory-mapped and decoded in place. The text is written to
+// the standard output. The header uses the syntax of
+// LogCore::setTextHeader().
+//
+// Large files are split into chunks at the block headers of the binary
+// format. Up to <jobs> chunks are decoded in parallel. The default is the
+// number of hardware threads.
+//
+// The options -s and -u select the records from (since) and up to (until)
+// a time, which is given as YYYY-MM-DDTHH:MM[:SS[.fraction]] in UTC or as
+// nanoseconds since the epoch. The option -l selects the records with the
+// given severity or higher (trace, debug, info, warn, error). If a filter
+// is set and the file <file>.idx exists, the blocks which contain no
+// matching record are not decoded at all.
+//
+// Compressed files (see BinaryFileSink::setCodec()) are detected
+// automatically. Their frames are decompressed and decoded in parallel.
+
+#include "BinaryDecoder.hpp"
+#include "BlockCodec.hpp"
+#include "BlockIndex.hpp"
+#include "TextSink.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace log11;
+
+
+namespace
+{
+
+//! A text sink, which writes to a file descriptor through a large buffer.
+class BufferedFileSink : public TextSink
+{
+public:
+    explicit
+    BufferedFileSink(int fd)
+        : m_fd(fd),
+          m_size(0)
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    ~BufferedFileSink()
+    {
+        flush();
+    }
+
+    virtual
+    void writeChar(char ch) override
+    {
+        if (m_size == sizeof(m_buffer))
+            flush();
+        m_buffer[m_size++] = ch;
+    }
+
+    virtual
+    void writeString(const char* text, std::size_t size) override
+    {
+        if (size > sizeof(m_buffer) - m_size)
+        {
+            flush();
+            if (size > sizeof(m_buffer))
+            {
+                writeAll(text, size);
+                return;
+            }
+        }
+        std::memcpy(m_buffer + m_size, text, size);
+        m_size += size;
+    }
+
+    virtual
+    void endLogEntry(const LogRecordData& data) override
+    {
+        writeChar('\n');
+        TextSink::endLogEntry(data);
+    }
+
+    void flush()
+    {
+        writeAll(m_buffer, m_size);
+        m_size = 0;
+    }
+
+private:
+    int m_fd;
+    std::size_t m_size;
+    char m_buffer[1 << 16];
+
+    void writeAll(const char* data, std::size_t size)
+    {
+        while (size)
+        {
+            auto written = ::write(m_fd, data, size);
+            if (written <= 0)
+                return;
+            data += written;
+            size -= written;
+        }
+    }
+};
+
+//! A text sink, which collects the text of a chunk in memory.
+class StringSink : public TextSink
+{
+public:
+    StringSink()
+    {
+        setEnabled(true);
+        setLevel(Severity::Trace);
+    }
+
+    virtual
+    void writeChar(char ch) override
+    {
+        m_text.push_back(ch);
+    }
+
+    virtual
+    void writeString(const char* text, std::size_t size) override
+    {
+        m_text.append(text, size);
+    }
+
+    virtual
+    void endLogEntry(const LogRecordData& data) override
+    {
+        m_text.push_back('\n');
+        TextSink::endLogEntry(data);
+    }
+
+    std::string& text()
+    {
+        return m_text;
+    }
+
+private:
+    std::string m_text;
+};
+
+//! The size of the chunks, which are decoded in parallel.
+const std::size_t chunkSize = 8 * 1024 * 1024;
+
+struct Options
+{
+    const char* header = nullptr;
+    unsigned numJobs = 1;
+    RecordFilter filter;
+    bool isFiltered = false;
+};
+
+//! Parses a \p text of the form <tt>YYYY-MM-DD[T]HH:MM[:SS[.fraction]]</tt>
+//! (UTC) or a plain number of nanoseconds since the epoch into \p time.
+bool parseTime(const char* text, std::uint64_t& time)
+{
+    char* end;
+    if (std::strlen(text) == std::strspn(text, "0123456789"))
+    {
+        time = std::strtoull(text, &end, 10);
+        return *text != 0;
+    }
+
+    int year, month, day, hour, minute, second = 0, consumed = 0;
+    char separator;
+    if (std::sscanf(text, "%d-%d-%d%c%d:%d%n", &year, &month, &day,
+                    &separator, &hour, &minute, &consumed) != 6
+        || (separator != 'T' && separator != ' '))
+    {
+        return false;
+    }
+    text += consumed;
+    if (*text == ':')
+    {
+        if (std::sscanf(text, ":%d%n", &second, &consumed) != 1)
+            return false;
+        text += consumed;
+    }
+    std::uint64_t fraction = 0;
+    if (*text == '.')
+    {
+        int numDigits = 0;
+        for (++text; *text >= '0' && *text <= '9'; ++text, ++numDigits)
+        {
+            if (numDigits < 9)
+                fraction = fraction * 10 + (*text - '0');
+        }
+        for (; numDigits < 9; ++numDigits)
+            fraction *= 10;
+    }
+    if (*text != 0)
+        return false;
+
+    // Convert the civil date to the number of days since 1970-01-01.
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100
+                    + dayOfYear;
+    long days = era * 146097 + dayOfEra - 719468;
+    if (days < 0)
+        return false;
+
+    std::uint64_t seconds = std::uint64_t(days) * 86400
+                            + hour * 3600 + minute * 60 + second;
+    time = seconds * 1000000000 + fraction;
+    return true;
+}
+
+//! Parses the name of a severity.
+bool parseSeverity(const char* text, Severity& severity)
+{
+    static const char* const names[] = {
+        "trace", "debug", "info", "warn", "error"
+    };
+    for (unsigned idx = 0; idx < 5; ++idx)
+    {
+        if (strcasecmp(text, names[idx]) == 0)
+        {
+            severity = static_cast<Severity>(idx);
+            return true;
+        }
+    }
+    return false;
+}
+
+//! Loads the index \p path of a file with \p dataSize bytes. Returns false
+//! if there is no usable index. The entries, which do not describe
+//! consecutive blocks inside the file, are dropped.
+bool loadIndex(const std::string& path, std::size_t dataSize,
+               std::vector<BlockInfo>& blocks)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    std::uint8_t buffer[BlockIndex::entrySize];
+    bool isValid = std::fread(buffer, sizeof(BlockIndex::magic), 1, file) == 1
+                   && std::memcmp(buffer, BlockIndex::magic,
+                                  sizeof(BlockIndex::magic)) == 0;
+    std::uint64_t expectedOffset = 0;
+    while (isValid && std::fread(buffer, sizeof(buffer), 1, file) == 1)
+    {
+        auto block = BlockIndex::decode(buffer);
+        if (   block.offset != expectedOffset
+            || block.offset + block.size > dataSize)
+        {
+            break;
+        }
+        expectedOffset = block.offset + block.size;
+        blocks.push_back(block);
+    }
+    std::fclose(file);
+    return isValid;
+}
+
+//! The result of decoding a range.
+struct RangeResult
+{
+    //! The offset at which the decoding stopped.
+    std::size_t end = 0;
+    //! The offsets of malformed records.
+    std::vector<std::size_t> errors;
+};
+
+//! Decodes the records starting at \p begin. The decoding stops at the
+//! first block header at or after \p stop (or at the end of the data).
+//! Malformed data is skipped up to the next block header.
+RangeResult decodeRange(BinaryDecoder& decoder, std::size_t begin,
+                        std::size_t stop, TextSink& sink)
+{
+    RangeResult result;
+    decoder.seek(begin);
+    DecodedRecord record;
+    for (;;)
+    {
+        if (decoder.position() >= stop && decoder.isAtBlockHeader())
+            break;
+        auto status = decoder.next(record);
+        if (status == BinaryDecoder::Status::EndOfData)
+            break;
+        if (status == BinaryDecoder::Status::Malformed)
+        {
+            result.errors.push_back(decoder.position());
+            decoder.seek(decoder.findBlock(decoder.position() + 1));
+            continue;
+        }
+        decoder.format(record, sink);
+    }
+    result.end = decoder.position();
+    return result;
+}
+
+//! A range of the data, which is decoded as a unit.
+struct Chunk
+{
+    //! The offset of the first block.
+    std::size_t begin;
+    //! The decoding stops at the first block header at or after this offset.
+    std::size_t stop;
+    //! Set if the chunk is known to begin at a block header. Otherwise,
+    //! the block marker at its begin could be part of a record.
+    bool isVerified;
+};
+
+//! The decoded text of a chunk.
+struct ChunkResult
+{
+    StringSink sink;
+    RangeResult range;
+};
+
+//! Runs \p work for the items [0, count) on up to \p numJobs threads and
+//! passes the results to \p consume in the order of the items.
+template <typename TWork, typename TConsume>
+void runOrdered(std::size_t count, unsigned numJobs, TWork work,
+                TConsume consume)
+{
+    std::size_t nextItem = 0;
+    std::deque<std::future<std::unique_ptr<ChunkResult>>> pending;
+    for (std::size_t idx = 0; idx < count; ++idx)
+    {
+        while (nextItem < count && pending.size() < numJobs)
+        {
+            pending.push_back(std::async(std::launch::async, work, nextItem));
+            ++nextItem;
+        }
+
+        auto result = pending.front().get();
+        pending.pop_front();
+        consume(idx, std::move(result));
+    }
+}
+
+int reportErrors(const char* path, const RangeResult& result)
+{
+    for (auto offset : result.errors)
+    {
+        std::fprintf(stderr, "log11decode: '%s' is malformed at offset %zu\n",
+                     path, offset);
+    }
+    return result.errors.empty() ? 0 : 1;
+}
+
+int decodeData(const char* path, const void* data, std::size_t size,
+               const Options& options, BufferedFileSink& sink)
+{
+    BinaryDecoder decoder;
+    if (options.header)
+        decoder.setTextHeader(options.header);
+    decoder.setFilter(options.filter);
+    decoder.setData(data, size);
+
+    // With a filter, the index selects the blocks, which have to be
+    // decoded. Adjacent blocks are merged into chunks.
+    std::vector<Chunk> chunks;
+    std::size_t indexedEnd = 0;
+    std::vector<BlockInfo> blocks;
+    if (options.isFiltered && loadIndex(std::string(path) + ".idx", size, blocks))
+    {
+        for (const auto& block : blocks)
+        {
+            indexedEnd = block.offset + block.size;
+            if (!options.filter.matches(block))
+                continue;
+            if (   !chunks.empty() && chunks.back().stop == block.offset
+                && chunks.back().stop - chunks.back().begin < chunkSize)
+            {
+                chunks.back().stop = indexedEnd;
+            }
+            else
+            {
+                chunks.push_back(Chunk{block.offset, indexedEnd, true});
+            }
+        }
+    }
+
+    // Split the rest of the data into chunks, which begin at block headers.
+    // Data without block headers forms a single chunk.
+    chunks.push_back(Chunk{indexedEnd, size, true});
+    if (options.numJobs > 1)
+    {
+        for (std::size_t offset = indexedEnd + chunkSize; offset < size;
+             offset += chunkSize)
+        {
+            auto block = decoder.findBlock(offset);
+            if (block >= size)
+                break;
+            if (block > chunks.back().begin)
+            {
+                chunks.back().stop = block;
+                chunks.push_back(Chunk{block, size, false});
+            }
+            offset = block;
+        }
+    }
+
+    // A chunk is decoded from the position where the previous chunk has
+    // stopped unless the chunk is known to start at a later block.
+    std::size_t position = 0;
+    auto startOf = [&](const Chunk& chunk) {
+        return chunk.isVerified && chunk.begin > position ? chunk.begin
+                                                          : position;
+    };
+
+    int result = 0;
+    if (options.numJobs <= 1 || chunks.size() == 1)
+    {
+        for (const auto& chunk : chunks)
+        {
+            if (position >= chunk.stop)
+                continue;
+            auto range = decodeRange(decoder, startOf(chunk), chunk.stop, sink);
+            result |= reportErrors(path, range);
+            position = range.end;
+        }
+        return result;
+    }
+
+    // Decode the chunks in parallel but write them in order. A chunk is
+    // accepted if it has been decoded from the correct position. Otherwise,
+    // the block marker at its begin was part of a record and the chunk is
+    // decoded once more.
+    auto decodeChunk = [&](std::size_t idx) {
+        std::unique_ptr<ChunkResult> chunkResult(new ChunkResult);
+        BinaryDecoder chunkDecoder;
+        if (options.header)
+            chunkDecoder.setTextHeader(options.header);
+        chunkDecoder.setFilter(options.filter);
+        chunkDecoder.setData(data, size);
+        chunkResult->range = decodeRange(chunkDecoder, chunks[idx].begin,
+                                         chunks[idx].stop, chunkResult->sink);
+        return chunkResult;
+    };
+
+    auto writeChunk = [&](std::size_t idx,
+                          std::unique_ptr<ChunkResult> chunkResult) {
+        const auto& chunk = chunks[idx];
+        if (position >= chunk.stop)
+            return;
+        auto start = startOf(chunk);
+        if (start == chunk.begin)
+        {
+            sink.writeString(chunkResult->sink.text().data(),
+                             chunkResult->sink.text().size());
+            result |= reportErrors(path, chunkResult->range);
+            position = chunkResult->range.end;
+        }
+        else
+        {
+            auto range = decodeRange(decoder, start, chunk.stop, sink);
+            result |= reportErrors(path, range);
+            position = range.end;
+        }
+    };
+
+    runOrdered(chunks.size(), options.numJobs, decodeChunk, writeChunk);
+    return result;
+}
+
+//! Decodes the frames in the \p data of a compressed file. Every frame
+//! holds one block and is decoded independently.
+int decodeFrames(const char* path, const void* data, std::size_t size,
+                 const Options& options, BufferedFileSink& sink)
+{
+    static Lz4Codec lz4Codec;
+
+    int result = 0;
+    auto bytes = static_cast<const std::uint8_t*>(data);
+
+    // Collect the frames. The frame headers are chained by their sizes.
+    struct Frame
+    {
+        std::size_t offset;
+        BlockFrame header;
+    };
+    std::vector<Frame> frames;
+    for (std::size_t offset = 0; offset < size;)
+    {
+        Frame frame;
+        frame.offset = offset;
+        if (   !frame.header.decodeHeader(bytes + offset, size - offset)
+            || (frame.header.codec != 0
+                && frame.header.codec != Lz4Codec::codecId))
+        {
+            std::fprintf(stderr, "log11decode: '%s' is malformed at offset %zu\n",
+                         path, offset);
+            result = 1;
+            break;
+        }
+        frames.push_back(frame);
+        offset += BlockFrame::headerSize + frame.header.payloadSize;
+    }
+
+    // Select the frames with the index. The index has one entry per frame.
+    std::vector<bool> isSelected(frames.size(), true);
+    std::vector<BlockInfo> blocks;
+    if (options.isFiltered && loadIndex(std::string(path) + ".idx", size, blocks))
+    {
+        for (std::size_t idx = 0; idx < blocks.size() && idx < frames.size(); ++idx)
+        {
+            if (blocks[idx].offset == frames[idx].offset)
+                isSelected[idx] = options.filter.matches(blocks[idx]);
+        }
+    }
+
+    // Group the selected frames into chunks.
+    std::vector<std::pair<std::size_t, std::size_t>> chunks;
+    std::size_t chunkBytes = 0;
+    for (std::size_t idx = 0; idx < frames.size(); ++idx)
+    {
+        if (!isSelected[idx])
+            continue;
+        if (chunks.empty() || chunkBytes >= chunkSize)
+        {
+            chunks.emplace_back(idx, idx);
+            chunkBytes = 0;
+        }
+        chunks.back().second = idx + 1;
+        chunkBytes += frames[idx].header.rawSize;
+    }
+
+    auto decodeChunk = [&](std::size_t chunkIdx) {
+        std::unique_ptr<ChunkResult> chunkResult(new ChunkResult);
+        BinaryDecoder decoder;
+        if (options.header)
+            decoder.setTextHeader(options.header);
+        decoder.setFilter(options.filter);
+        std::vector<std::uint8_t> buffer;
+        for (auto idx = chunks[chunkIdx].first; idx < chunks[chunkIdx].second;
+             ++idx)
+        {
+            const auto& frame = frames[idx];
+            auto payload = bytes + frame.offset + BlockFrame::headerSize;
+            if (frame.header.codec == 0)
+            {
+                decoder.setData(payload, frame.header.rawSize);
+            }
+            else
+            {
+                buffer.resize(frame.header.rawSize);
+                if (!lz4Codec.decompress(payload, frame.header.payloadSize,
+                                         buffer.data(), buffer.size()))
+                {
+                    chunkResult->range.errors.push_back(frame.offset);
+                    continue;
+                }
+                decoder.setData(buffer.data(), buffer.size());
+            }
+
+            auto range = decodeRange(decoder, 0, frame.header.rawSize,
+                                     chunkResult->sink);
+            if (!range.errors.empty())
+                chunkResult->range.errors.push_back(frame.offset);
+        }
+        return chunkResult;
+    };
+
+    auto writeChunk = [&](std::size_t, std::unique_ptr<ChunkResult> chunkResult) {
+        sink.writeString(chunkResult->sink.text().data(),
+                         chunkResult->sink.text().size());
+        result |= reportErrors(path, chunkResult->range);
+    };
+
+    runOrdered(chunks.size(), options.numJobs, decodeChunk, writeChunk);
+    return result;
+}
+
+int decodeFile(const char* path, const Options& options,
+               BufferedFileSink& sink)
+{
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        std::fprintf(stderr, "log11decode: cannot open '%s'\n", path);
+        return 1;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        std::fprintf(stderr, "log11decode: cannot stat '%s'\n", path);
+        ::close(fd);
+        return 1;
+    }
+
+    std::size_t size = info.st_size;
+    void* data = nullptr;
+    if (size)
+    {
+        data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            std::fprintf(stderr, "log11decode: cannot map '%s'\n", path);
+            ::close(fd);
+            return 1;
+        }
+        ::madvise(data, size, options.numJobs > 1 ? MADV_WILLNEED
+                                                  : MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    int result;
+    if (   size >= sizeof(BlockFrame::magic)
+        && std::memcmp(data, BlockFrame::magic, sizeof(BlockFrame::magic)) == 0)
+    {
+        result = decodeFrames(path, data, size, options, sink);
+    }
+    else
+    {
+        result = decodeData(path, data, size, options, sink);
+    }
+
+    if (data)
+        ::munmap(data, size);
+    return result;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    options.numJobs = std::thread::hardware_concurrency();
+    if (options.numJobs == 0)
+        options.numJobs = 1;
+    BufferedFileSink sink(STDOUT_FILENO);
+
+    int result = 0;
+    int numFiles = 0;
+    for (int idx = 1; idx < argc; ++idx)
+    {
+        if (std::strcmp(argv[idx], "-H") == 0 && idx + 1 < argc)
+        {
+            options.header = argv[++idx];
+            continue;
+        }
+        if (std::strcmp(argv[idx], "-s") == 0 && idx + 1 < argc)
+        {
+            if (!parseTime(argv[++idx], options.filter.beginTime))
+            {
+                std::fprintf(stderr, "log11decode: invalid time '%s'\n",
+                             argv[idx]);
+                return 2;
+            }
+            options.isFiltered = true;
+            continue;
+        }
+        if (std::strcmp(argv[idx], "-u") == 0 && idx + 1 < argc)
+        {
+            if (!parseTime(argv[++idx], options.filter.endTime))
+            {
+                std::fprintf(stderr, "log11decode: invalid time '%s'\n",
+                             argv[idx]);
+                return 2;
+            }
+            options.isFiltered = true;
+            continue;
+        }
+        if (std::strcmp(argv[idx], "-l") == 0 && idx + 1 < argc)
+        {
+            Severity severity;
+            if (!parseSeverity(argv[++idx], severity))
+            {
+                std::fprintf(stderr, "log11decode: invalid severity '%s'\n",
+                             argv[idx]);
+                return 2;
+            }
+            options.filter.severities = RecordFilter::atLeast(severity);
+            options.isFiltered = true;
+            continue;
+        }
+        if (std::strcmp(argv[idx], "-j") == 0 && idx + 1 < argc)
+        {
+            int numJobs = std::atoi(argv[++idx]);
+            options.numJobs = numJobs > 0 ? numJobs : 1;
+            continue;
+        }
+        result |= decodeFile(argv[idx], options, sink);
+        ++numFiles;
+    }
+
+    if (numFiles == 0)
+    {
+        std::fprintf(stderr,
+                     "Usage: log11decode [-H <header>] [-j <jobs>] "
+                     "[-s <time>] [-u <time>] [-l <severity>] <file>...\n");
+        return 2;
+    }
+    return result;
+}